@@ -1,16 +1,28 @@
+#include <algorithm>
+
 #include "AncestralStates.hpp"
 
 using namespace std;
 
 AncestralStates::AncestralStates(size_t nodes, size_t states, size_t sites) :
-    num_nodes(nodes), num_states(states), ambiguity(true)
+    num_nodes(nodes), num_states(states), block_size(0), block_start(0), ambiguity(true)
 {
   part_num_sites.push_back(sites);
   prob_eps = num_states > 0 ? 0.5 / num_states : 0.1;
+
+  /* standalone container: all nodes selected and held in a single block */
+  for (size_t n = 0; n < num_nodes; ++n)
+  {
+    node_names.push_back("Node" + to_string(n));
+    selected_nodes.push_back(n);
+  }
+  block_nodes = selected_nodes;
+
+  allocate_probs();
 }
 
 AncestralStates::AncestralStates(size_t nodes, const PartitionedMSA& part_msa) :
-    num_nodes(nodes), ambiguity(true)
+    num_nodes(nodes), block_size(0), block_start(0), ambiguity(true)
 {
   const Model& model = part_msa.part_info(0).model();
   num_states = model.num_states();
@@ -19,14 +31,13 @@ AncestralStates::AncestralStates(size_t nodes, const PartitionedMSA& part_msa) :
 
   for (const auto& pinfo: part_msa.part_list())
   {
-    part_num_sites.push_back(pinfo.msa().num_sites());
+    /* probabilities are computed per pattern and expanded to sites only on output */
+    part_num_sites.push_back(pinfo.msa().length());
+    part_site_pattern_map.push_back(pinfo.msa().site_pattern_map());
     if (pinfo.model().data_type() != model.data_type())
       throw runtime_error("Ancestral State Reconstruction is not supported for mixed-type alignments (eg DNA and AA).");
   }
 
-  // TODO move out of here?
-  allocate_probs();
-
   prob_eps = 0.5 / num_states;
 }
 
@@ -37,24 +48,93 @@ void AncestralStates::allocate_probs()
   for (size_t p = 0; p < part_num_sites.size(); ++p)
   {
     size_t part_span = part_num_sites[p] * num_states;
-    for (size_t n = 0; n < num_nodes; ++n)
+    for (size_t n = 0; n < block_nodes.size(); ++n)
     {
       probs[p].emplace_back(part_span);
     }
   }
 }
 
+void AncestralStates::select_nodes()
+{
+  selected_nodes.clear();
+  if (selected_node_names.empty())
+  {
+    for (size_t n = 0; n < num_nodes; ++n)
+      selected_nodes.push_back(n);
+  }
+  else
+  {
+    for (const auto& name: selected_node_names)
+    {
+      auto it = std::find(node_names.cbegin(), node_names.cend(), name);
+      if (it == node_names.cend())
+        throw runtime_error("Ancestral node not found in the tree: " + name);
+      selected_nodes.push_back(it - node_names.cbegin());
+    }
+  }
+
+  block_start = 0;
+  block_nodes.clear();
+}
+
+bool AncestralStates::next_block()
+{
+  block_start += block_nodes.size();
+  if (block_start >= selected_nodes.size())
+  {
+    free_block();
+    return false;
+  }
+
+  auto block_end = block_size ? std::min(block_start + block_size, selected_nodes.size()) :
+                                selected_nodes.size();
+  block_nodes.assign(selected_nodes.cbegin() + block_start, selected_nodes.cbegin() + block_end);
+
+  allocate_probs();
+
+  return true;
+}
+
+void AncestralStates::free_block()
+{
+  block_nodes.clear();
+  probs.clear();
+  probs.shrink_to_fit();
+}
+
+const std::string& AncestralStates::block_node_name(size_t block_idx) const
+{
+  return node_names.at(block_nodes.at(block_idx));
+}
+
 size_t AncestralStates::num_parts() const
 {
   return part_num_sites.size();
 }
 
+size_t AncestralStates::num_out_sites(size_t part_idx) const
+{
+  if (part_idx < part_site_pattern_map.size() && !part_site_pattern_map[part_idx].empty())
+    return part_site_pattern_map[part_idx].size();
+  else
+    return part_num_sites.at(part_idx);
+}
+
+size_t AncestralStates::site_pattern(size_t part_idx, size_t site_idx) const
+{
+  if (part_idx < part_site_pattern_map.size() && !part_site_pattern_map[part_idx].empty())
+    return part_site_pattern_map[part_idx][site_idx];
+  else
+    return site_idx;
+}
+
 std::string AncestralStates::ml_state(size_t node_idx, size_t site_idx, size_t part_idx) const
 {
   if (part_idx >= part_num_sites.size())
     throw runtime_error("AncestralStates: Partition index out of bounds");
 
-  if (node_idx >= num_nodes)
+  if (node_idx >= block_nodes.size())
     throw runtime_error("AncestralStates: Node index out of bounds");
 
   if (site_idx >= part_num_sites[part_idx])
@@ -91,12 +171,18 @@ std::string AncestralStates::ml_state(size_t node_idx, size_t site_idx, size_t p
 std::string AncestralStates::ml_state_seq(size_t node_idx, size_t part_idx) const
 {
   string s;
-  auto num_sites = part_num_sites[part_idx];
+  auto num_patterns = part_num_sites.at(part_idx);
+  auto num_sites = num_out_sites(part_idx);
+
+  /* ML state is determined once per pattern, and then expanded to the original sites */
+  NameList pattern_states(num_patterns);
+  for (size_t k = 0; k < num_patterns; ++k)
+    pattern_states[k] = ml_state(node_idx, k, part_idx);
 
   s.reserve(num_sites);
 
   for (size_t k = 0; k < num_sites; ++k)
-    s += ml_state(node_idx, k, part_idx);
+    s += pattern_states[site_pattern(part_idx, k)];
 
   return s;
 }
@@ -116,6 +202,8 @@ void assign_tree(AncestralStates& ancestral, const pllmod_ancestral_t& pll_ances
   ancestral.node_names.clear();
   for (size_t i = 0; i < pll_ancestral.node_count; ++i)
     ancestral.node_names.push_back(pll_ancestral.nodes[i]->label);
+
+  ancestral.select_nodes();
 }
 
 void assign_probs(AncestralStates& ancestral, const pllmod_ancestral_t& pll_ancestral,
@@ -144,10 +232,10 @@ void assign_probs(AncestralStates& ancestral, const pllmod_ancestral_t& pll_ance
     size_t prob_offset = part_range->start * ancestral.num_states;
     size_t anc_span = part_range->length * ancestral.num_states;
 
-    for (size_t n = 0; n < pll_ancestral.node_count; ++n)
+    for (size_t i = 0; i < ancestral.block_nodes.size(); ++i)
     {
-      double * probs = part_probs.at(n).data() + prob_offset;
-      double * pll_probs = pll_ancestral.probs[n] + pll_offset;
+      double * probs = part_probs.at(i).data() + prob_offset;
+      double * pll_probs = pll_ancestral.probs[ancestral.block_nodes[i]] + pll_offset;
       memcpy(probs, pll_probs, anc_span * sizeof(double));
     }
     pll_offset += anc_span;
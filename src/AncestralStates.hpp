@@ -14,9 +14,22 @@ struct AncestralStates
   size_t num_nodes;
   size_t num_states;
   std::vector<size_t> part_num_sites;
+  /* original site -> pattern mapping (empty = uncompressed or mapping not available) */
+  std::vector<WeightVector> part_site_pattern_map;
   NameList state_names;
   StateNameMap state_namemap;
   NameList node_names;
+
+  /* nodes to be reconstructed (empty = all inner nodes) */
+  NameList selected_node_names;
+  IDVector selected_nodes;
+
+  /* probabilities are computed for blocks of block_size nodes (0 = all at once) */
+  size_t block_size;
+  size_t block_start;
+
+  /* nodes in the current block -> probs[part][i] belongs to node block_nodes[i] */
+  IDVector block_nodes;
   std::vector<PartitionAncestralProbs> probs;
 
   bool ambiguity;
@@ -26,13 +39,22 @@ struct AncestralStates
   AncestralStates(size_t nodes, const PartitionedMSA& part_msa);
 
   void allocate_probs();
+  void select_nodes();
+  bool next_block();
+  void free_block();
 
   size_t num_parts() const;
+  size_t num_out_sites(size_t part_idx) const;
+  size_t site_pattern(size_t part_idx, size_t site_idx) const;
+  size_t num_selected_nodes() const { return selected_nodes.size(); }
+  size_t num_block_nodes() const { return block_nodes.size(); }
+  const std::string& block_node_name(size_t block_idx) const;
   std::string ml_state_seq(size_t node_idx, size_t part_idx = 0) const ;
   std::string ml_state(size_t node_idx, size_t site_idx, size_t part_idx = 0) const;
 };
 
 typedef std::shared_ptr<AncestralStates> AncestralStatesSharedPtr;
+typedef std::function<void(const AncestralStates&)> AncestralBlockCallback;
 
 void assign_tree(AncestralStates& ancestral, const pllmod_ancestral_t& pll_ancestral);
 void assign_probs(AncestralStates& ancestral, const pllmod_ancestral_t& pll_ancestral,
@@ -10,6 +10,7 @@ using namespace std;
 void Checkpoint::reset_search_state()
 {
   search_state = SearchState();
+  modopt_topology = TreeTopology();
 };
 
 Tree CheckpointFile::tree() const
@@ -240,6 +241,8 @@ void CheckpointManager::save_bs_tree()
 
 void CheckpointManager::update_and_write(const TreeInfo& treeinfo)
 {
+  ProfileScope prof(ProfileEvent::checkpoint);
+
   if (ParallelContext::master_thread())
     _updated_models.clear();
 
@@ -269,6 +272,7 @@ void CheckpointManager::update_and_write(const TreeInfo& treeinfo)
     ParallelContext::UniqueLock lock;
     assign_tree(ckp, treeinfo);
     ckp.last_loglh = ckp.search_state.loglh;
+    ckp.search_state.alpha_pinv = treeinfo.alpha_pinv();
     if (_active)
       write();
 
@@ -318,7 +322,7 @@ void CheckpointManager::gather_ml_trees()
       {
         BinaryStream bs((char*) buf, buf_size);
 
-        bs << _checkp_file.ml_trees;
+        bs << CompactTopologyMap(_checkp_file.ml_trees, TreeBrlenFormat::full);
 
         bs << _checkp_file.best_models;
 
@@ -336,7 +340,7 @@ void CheckpointManager::gather_ml_trees()
        double old_score = _checkp_file.ml_trees.best_score();
        BinaryStream bs((char*) buf, buf_size);
 
-       bs >>  _checkp_file.ml_trees;
+       bs >> CompactTopologyMapRef(_checkp_file.ml_trees, TreeBrlenFormat::full);
 
        if (_checkp_file.ml_trees.best_score() > old_score)
          bs >> _checkp_file.best_models;
@@ -355,7 +359,7 @@ void CheckpointManager::gather_bs_trees()
       {
         BinaryStream bs((char*) buf, buf_size);
 
-        bs << _checkp_file.bs_trees;
+        bs << CompactTopologyMap(_checkp_file.bs_trees, TreeBrlenFormat::full);
 
 //        printf("after worker: %u\n", bs.pos());
 
@@ -370,35 +374,71 @@ void CheckpointManager::gather_bs_trees()
      {
        BinaryStream bs((char*) buf, buf_size);
 
-       bs >>  _checkp_file.bs_trees;
+       bs >> CompactTopologyMapRef(_checkp_file.bs_trees, TreeBrlenFormat::full);
      };
 
   ParallelContext::mpi_gather_custom(worker_cb, master_cb);
 }
 
+void CheckpointManager::remove_bs_trees(const IDSet& bs_ids)
+{
+  for (auto bs_num: bs_ids)
+    _checkp_file.bs_trees.erase(bs_num);
+
+  if (_active)
+    write();
+}
+
 BasicBinaryStream& operator<<(BasicBinaryStream& stream, const Checkpoint& ckp)
 {
-  stream << ckp.search_state;
+  stream << (const BasicSearchState&) ckp.search_state;
+
+  stream << ckp.search_state.alpha_pinv;
+
+  stream << ckp.search_state.modopt;
 
   stream << ckp.tree_index;
 
+  stream << ckp.bs_tree;
+
   stream << ckp.tree.topology();
 
   stream << ckp.models;
 
+  stream << ckp.modopt_topology;
+
   return stream;
 }
 
-BasicBinaryStream& operator>>(BasicBinaryStream& stream, Checkpoint& ckp)
+static void read_checkpoint(BasicBinaryStream& stream, Checkpoint& ckp, int version)
 {
-  stream >> ckp.search_state;
+  /* fields missing in older versions keep their defaults, i.e. the optimizer starts cold */
+  stream >> (BasicSearchState&) ckp.search_state;
+
+  if (version > 5)
+    stream >> ckp.search_state.alpha_pinv;
+
+  if (version > 6)
+    stream >> ckp.search_state.modopt;
 
   stream >> ckp.tree_index;
 
+  /* older versions: tree type is derived from the run phase, see load_checkpoint() */
+  if (version > 8)
+    stream >> ckp.bs_tree;
+
   ckp.tree.topology(stream.get<TreeTopology>());
 
   stream >> ckp.models;
 
+  if (version > 6)
+    stream >> ckp.modopt_topology;
+}
+
+BasicBinaryStream& operator>>(BasicBinaryStream& stream, Checkpoint& ckp)
+{
+  read_checkpoint(stream, ckp, RAXML_CKP_VERSION);
+
   return stream;
 }
 
@@ -411,6 +451,12 @@ BasicBinaryStream& operator<<(BasicBinaryStream& stream, const CheckpointFile& c
 
   stream << ckpfile.consumed_wh + global_energy_monitor.consumed_wh(false);
 
+  // same for the per-phase breakdown
+  auto energy_phases = global_energy_monitor.phase_counters(false);
+  for (size_t p = 0; p < energy_phases.size(); ++p)
+    energy_phases[p] += ckpfile.energy_phases[p];
+  stream << energy_phases;
+
   stream << ckpfile.opts;
 
   stream << ckpfile.checkp_list;
@@ -439,6 +485,12 @@ BasicBinaryStream& operator>>(BasicBinaryStream& stream, CheckpointFile& ckpfile
   {
     stream >> ckpfile.consumed_wh;
 
+    if (ckpfile.version > 7)
+    {
+      stream >> ckpfile.energy_phases;
+      ckpfile.energy_phases.resize((size_t) EnergyPhase::count, EnergyCounter());
+    }
+
     stream >> ckpfile.opts;
   }
 
@@ -452,9 +504,9 @@ BasicBinaryStream& operator>>(BasicBinaryStream& stream, CheckpointFile& ckpfile
     for (size_t i = 0; i < num_ckp_in_file; ++i)
     {
       if (i < num_ckp_to_load)
-        stream >> ckpfile.checkp_list[i];
+        read_checkpoint(stream, ckpfile.checkp_list[i], ckpfile.version);
       else
-        stream >> dummy_ckp;
+        read_checkpoint(stream, dummy_ckp, ckpfile.version);
     }
   }
 
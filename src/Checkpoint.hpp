@@ -1,11 +1,15 @@
 #ifndef RAXML_CHECKPOINT_HPP_
 #define RAXML_CHECKPOINT_HPP_
 
+#include <algorithm>
+#include <limits>
+
 #include "common.h"
 #include "TreeInfo.hpp"
 #include "io/binary_io.hpp"
+#include "util/EnergyMonitor.hpp"
 
-constexpr int RAXML_CKP_VERSION = 5;
+constexpr int RAXML_CKP_VERSION = 9;
 constexpr int RAXML_CKP_MIN_SUPPORTED_VERSION = 5;
 
 struct MLTree
@@ -29,9 +33,30 @@ enum class CheckpointStep
   finish
 };
 
-struct SearchState
+/* adaptive model optimization schedule, see Optimizer::schedule_modopt() */
+struct modopt_schedule
+{
+  int params;                 /* parameters to optimize in the current modOpt step */
+  double lh_epsilon;          /* logLH epsilon for the current modOpt step */
+  double topol_dist;          /* rel. RF distance to the tree at the last modOpt step */
+  double param_gains[RAXML_MODOPT_PARAM_SLOTS];  /* logLH gain per parameter, inf = unknown */
+  unsigned int skipped;       /* consecutive modOpt steps without model parameters */
+
+  void reset()
+  {
+    params = PLLMOD_OPT_PARAM_ALL;
+    lh_epsilon = 0.;
+    topol_dist = 1.;
+    std::fill(param_gains, param_gains + RAXML_MODOPT_PARAM_SLOTS,
+              std::numeric_limits<double>::infinity());
+    skipped = 0;
+  }
+};
+
+/* search state as stored in checkpoint files since version 5 */
+struct BasicSearchState
 {
-  SearchState() : step(CheckpointStep::start), loglh(0.), iteration(0), fast_spr_radius(0) {}
+  BasicSearchState() : step(CheckpointStep::start), loglh(0.), iteration(0), fast_spr_radius(0) {}
 
   CheckpointStep step;
   double loglh;
@@ -41,9 +66,22 @@ struct SearchState
   int fast_spr_radius;
 };
 
+struct SearchState : public BasicSearchState
+{
+  SearchState() : BasicSearchState()
+  {
+    alpha_pinv.reset();
+    modopt.reset();
+  }
+
+  alpha_pinv_state alpha_pinv;    /* since checkpoint version 6 */
+  modopt_schedule modopt;         /* since checkpoint version 7 */
+};
+
 struct Checkpoint
 {
-  Checkpoint() : search_state(), tree_index(0), tree(), models(), last_loglh(0.) {}
+  Checkpoint() : search_state(), tree_index(0), bs_tree(false), tree(), models(), last_loglh(0.),
+      modopt_topology() {}
 
   Checkpoint(const Checkpoint&) = default;
   Checkpoint& operator=(const Checkpoint&) = default;
@@ -53,10 +91,14 @@ struct Checkpoint
   SearchState search_state;
 
   size_t tree_index;
+  bool bs_tree;       /* tree_index refers to a bootstrap replicate rather than to an ML search */
   Tree tree;
   ModelMap models;
   double last_loglh;
 
+  /* topology at the last model optimization (reference for adaptive scheduling) */
+  TreeTopology modopt_topology;
+
   double loglh() const { return search_state.loglh; }
 
   void reset_search_state();
@@ -64,11 +106,13 @@ struct Checkpoint
 
 struct CheckpointFile
 {
-  CheckpointFile() : version(RAXML_CKP_VERSION), elapsed_seconds(0.), consumed_wh(0.) {}
+  CheckpointFile() : version(RAXML_CKP_VERSION), elapsed_seconds(0.), consumed_wh(0.),
+    energy_phases((size_t) EnergyPhase::count, EnergyCounter()) {}
 
   int version;
   double elapsed_seconds;
   double consumed_wh;
+  EnergyCounterList energy_phases;  /* per-phase energy from past runs */
   Options opts;
 
   std::vector<Checkpoint> checkp_list;
@@ -121,6 +165,7 @@ public:
 
   void gather_ml_trees();
   void gather_bs_trees();
+  void remove_bs_trees(const IDSet& bs_ids);
 
 private:
   bool _active;
@@ -70,7 +70,7 @@ static struct option long_options[] =
   {"bs-metric",          required_argument, 0, 0 },  /*  47 */
 
   {"search1",            no_argument, 0, 0 },        /*  48 */
-  {"bsmsa",              no_argument, 0, 0 },        /*  49 */
+  {"bsmsa",              optional_argument, 0, 0 },  /*  49 */
   {"rfdist",             optional_argument, 0, 0 },  /*  50 */
   {"rf",                 optional_argument, 0, 0 },  /*  51 */
   {"consense",           optional_argument, 0, 0 },  /*  52 */
@@ -81,10 +81,68 @@ static struct option long_options[] =
   {"site-weights",       required_argument, 0, 0 },  /*  56 */
   {"bs-write-msa",       no_argument, 0, 0 },        /*  57 */
   {"lh-epsilon-triplet", required_argument, 0, 0 },  /*  58 */
+  {"tree-format",        required_argument, 0, 0 },  /*  59 */
+  {"asr-nodes",          required_argument, 0, 0 },  /*  60 */
+  {"profile",            optional_argument, 0, 0 },  /*  61 */
+  {"budget",             required_argument, 0, 0 },  /*  62 */
 
   { 0, 0, 0, 0 }
 };
 
+/* budget list, e.g. "23h30m", "5kWh" or "2d,100kWh" */
+static void parse_budget(const string& arg, Options& opts)
+{
+  opts.budget_seconds = opts.budget_wh = 0.;
+  for (const auto& item: split_string(arg, ','))
+  {
+    const char * p = item.c_str();
+    bool energy = false;
+    double secs = 0., wh = 0.;
+    while (*p)
+    {
+      double val;
+      int n = 0;
+      if (sscanf(p, "%lf%n", &val, &n) != 1 || val < 0.)
+        throw InvalidOptionValueException("Invalid budget: " + arg);
+      p += n;
+
+      size_t len = 0;
+      while (isalpha(p[len]))
+        len++;
+      const string unit(p, len);
+      p += len;
+
+      if (unit == "s")
+        secs += val;
+      else if (unit == "m" || unit == "min")
+        secs += val * 60.;
+      else if (unit == "h")
+        secs += val * 3600.;
+      else if (unit == "d")
+        secs += val * 86400.;
+      else if (strcasecmp(unit.c_str(), "Wh") == 0 || strcasecmp(unit.c_str(), "kWh") == 0)
+      {
+        wh += unit.size() == 3 ? val * 1000. : val;
+        energy = true;
+      }
+      else
+        throw InvalidOptionValueException("Invalid budget unit: " + unit +
+                                          " (expected: s, m, h, d, Wh or kWh)");
+    }
+
+    if (energy && secs > 0.)
+      throw InvalidOptionValueException("Invalid budget: " + item + " mixes time and energy units");
+
+    if (energy)
+      opts.budget_wh = wh;
+    else
+      opts.budget_seconds = secs;
+  }
+
+  if (opts.budget_seconds <= 0. && opts.budget_wh <= 0.)
+    throw InvalidOptionValueException("Invalid budget: " + arg);
+}
+
 static std::string get_cmdline(int argc, char** argv)
 {
   ostringstream s;
@@ -279,6 +337,30 @@ void CommandLineParser::parse_options(int argc, char** argv, Options &opts)
   /* enable incremental CLV updates across pruned subtrees in SPR rounds */
   opts.use_spr_fastclv = true;
 
+  /* optimize model parameters of all partitions in lockstep */
+  opts.use_split_modopt = false;
+
+  /* optimize alpha and p-inv with two successive 1D searches in +I+G models */
+  opts.use_joint_alpha_pinv = false;
+
+  /* run every model optimization step between SPR phases in full */
+  opts.use_adaptive_modopt = false;
+
+  /* use site repeats rather than tip-inner lookup tables for binary and multistate data */
+  opts.use_tip_lookup = false;
+
+  /* every MPI rank keeps its own copy of the alignment */
+  opts.use_shared_msa = false;
+
+  /* multi-node MPI runs: reduce within node first, then across nodes */
+  opts.use_hier_reduce = true;
+
+  /* --all: ML searches and bootstrap replicates share one task pool */
+  opts.use_pipeline = true;
+
+  /* run bootstopping test in the background while the next batch of replicates is computed */
+  opts.use_async_bootstop = true;
+
   /* optimize model and branch lengths */
   opts.optimize_model = true;
   opts.optimize_brlen = true;
@@ -325,6 +407,25 @@ void CommandLineParser::parse_options(int argc, char** argv, Options &opts)
   opts.model_file = "";
   opts.tree_file = "";
 
+  /* write bootstrap replicate MSAs in PHYLIP format by default */
+  opts.bsmsa_format = FileFormat::phylip;
+
+  /* write ML/bootstrap tree collections in Newick format by default */
+  opts.tree_format = TreeFormat::newick;
+  opts.tree_brlen_format = TreeBrlenFormat::full;
+
+  /* ancestral states: text output, all inner nodes at once */
+  opts.asr_prob_format = AncestralProbFormat::text;
+  opts.asr_block_size = 0;
+  opts.asr_nodes.clear();
+
+  /* no search profiling by default */
+  opts.profile_format = ProfileFormat::none;
+
+  /* no time/energy budget by default */
+  opts.budget_seconds = 0.;
+  opts.budget_wh = 0.;
+
   // autodetect CPU instruction set and use respective SIMD kernels
   opts.simd_arch = sysutil_simd_autodetect();
   opts.load_balance_method = LoadBalancing::benoit;
@@ -827,12 +928,50 @@ void CommandLineParser::parse_options(int argc, char** argv, Options &opts)
               opts.use_par_pars = true;
             else if (eopt == "pars-seq")
               opts.use_par_pars = false;
+            else if (eopt == "modopt-split")
+              opts.use_split_modopt = true;
+            else if (eopt == "modopt-sync")
+              opts.use_split_modopt = false;
+            else if (eopt == "alpha-pinv-joint")
+              opts.use_joint_alpha_pinv = true;
+            else if (eopt == "alpha-pinv-seq")
+              opts.use_joint_alpha_pinv = false;
+            else if (eopt == "modopt-adaptive")
+              opts.use_adaptive_modopt = true;
+            else if (eopt == "modopt-fixed")
+              opts.use_adaptive_modopt = false;
+            else if (eopt == "tiplookup-on")
+              opts.use_tip_lookup = true;
+            else if (eopt == "tiplookup-off")
+              opts.use_tip_lookup = false;
+            else if (eopt == "msa-shm-on")
+              opts.use_shared_msa = true;
+            else if (eopt == "msa-shm-off")
+              opts.use_shared_msa = false;
+            else if (eopt == "reduce-hier")
+              opts.use_hier_reduce = true;
+            else if (eopt == "reduce-flat")
+              opts.use_hier_reduce = false;
+            else if (eopt == "pipeline-on")
+              opts.use_pipeline = true;
+            else if (eopt == "pipeline-off")
+              opts.use_pipeline = false;
+            else if (eopt == "bootstop-async")
+              opts.use_async_bootstop = true;
+            else if (eopt == "bootstop-sync")
+              opts.use_async_bootstop = false;
+            else if (eopt == "clv-float")
+              throw InvalidOptionValueException("Single-precision CLVs are not supported "
+                                                "by libpll: " + string(eopt));
             else if (eopt == "compat-v11")
             {
               compat_ver = 110;
               opts.use_spr_fastclv = false;
               opts.use_bs_pars = false;
               opts.use_par_pars = false;
+              opts.use_joint_alpha_pinv = false;
+              opts.use_adaptive_modopt = false;
+              opts.use_tip_lookup = false;
               if (!lh_epsilon_set)
                 opts.lh_epsilon = DEF_LH_EPSILON_V11;
               opts.lh_epsilon_brlen_triplet = DEF_LH_EPSILON_V11;
@@ -874,6 +1013,16 @@ void CommandLineParser::parse_options(int argc, char** argv, Options &opts)
         opts.command = Command::bsmsa;
         opts.use_par_pars = false;
         num_commands++;
+        if (optarg)
+        {
+          if (strcasecmp(optarg, "phylip") == 0)
+            opts.bsmsa_format = FileFormat::phylip;
+          else if (strcasecmp(optarg, "rba") == 0)
+            opts.bsmsa_format = FileFormat::binary;
+          else
+            throw InvalidOptionValueException("Invalid bootstrap MSA format: " + string(optarg) +
+                                              ", allowed values: PHYLIP, RBA");
+        }
         break;
 
       case 50: /* compute RF distance */
@@ -919,11 +1068,34 @@ void CommandLineParser::parse_options(int argc, char** argv, Options &opts)
 
       case 53: /* ancestral state reconstruction */
         opts.command = Command::ancestral;
-        opts.use_pattern_compression = false;
         opts.use_repeats = false;
         opts.use_tip_inner = true;
         if (opts.precision.empty())
           opts.precision[LogElement::other] = 5;
+        if (optarg)
+        {
+          for (const auto& s: split_string(optarg, ','))
+          {
+            const char * arg = s.c_str();
+            if (strcasecmp(arg, "text") == 0)
+              opts.asr_prob_format = AncestralProbFormat::text;
+            else if (strcasecmp(arg, "float") == 0)
+              opts.asr_prob_format = AncestralProbFormat::float32;
+            else if (strcasecmp(arg, "uint8") == 0)
+              opts.asr_prob_format = AncestralProbFormat::uint8;
+            else if (strcasecmp(arg, "stream") == 0)
+              opts.asr_block_size = RAXML_ASR_BLOCK_SIZE;
+            else if (strncasecmp(arg, "stream{", 7) == 0)
+            {
+              if (sscanf(arg, "stream{%zu}", &opts.asr_block_size) != 1 || opts.asr_block_size == 0)
+                throw InvalidOptionValueException("Invalid ASR block size: " + s +
+                                                  ", please provide a positive integer number!");
+            }
+            else
+              throw InvalidOptionValueException("Unknown ancestral state reconstruction mode: " + s +
+                                                ", allowed values: text, float, uint8, stream, stream{N}");
+          }
+        }
         num_commands++;
         break;
 
@@ -959,7 +1131,48 @@ void CommandLineParser::parse_options(int argc, char** argv, Options &opts)
                                             string(optarg) +
                                             ", please provide a positive real number.");
         break;
-            
+
+      case 59: /* output format for ML/bootstrap tree collections */
+        if (strcasecmp(optarg, "newick") == 0)
+          opts.tree_format = TreeFormat::newick;
+        else if (strncasecmp(optarg, "binary", 6) == 0)
+        {
+          opts.tree_format = TreeFormat::binary;
+          if (strcasecmp(optarg, "binary") == 0 || strcasecmp(optarg, "binary{full}") == 0)
+            opts.tree_brlen_format = TreeBrlenFormat::full;
+          else if (strcasecmp(optarg, "binary{f32}") == 0)
+            opts.tree_brlen_format = TreeBrlenFormat::float32;
+          else if (strcasecmp(optarg, "binary{q16}") == 0)
+            opts.tree_brlen_format = TreeBrlenFormat::quant16;
+          else if (strcasecmp(optarg, "binary{none}") == 0)
+            opts.tree_brlen_format = TreeBrlenFormat::none;
+          else
+            throw InvalidOptionValueException("Invalid branch length format: " + string(optarg) +
+                                              ", allowed values: q16, f32, full, none");
+        }
+        else
+          throw InvalidOptionValueException("Unknown tree format: " + string(optarg));
+        break;
+
+      case 60: /* nodes for ancestral state reconstruction */
+        opts.asr_nodes = split_string(optarg, ',');
+        if (opts.asr_nodes.empty())
+          throw InvalidOptionValueException("Invalid list of ancestral nodes: " + string(optarg));
+        break;
+
+      case 61: /* per-phase timers and call counters */
+        if (!optarg || strcasecmp(optarg, "json") == 0)
+          opts.profile_format = ProfileFormat::json;
+        else if (strcasecmp(optarg, "csv") == 0)
+          opts.profile_format = ProfileFormat::csv;
+        else
+          throw InvalidOptionValueException("Invalid profile format: " + string(optarg));
+        break;
+
+      case 62: /* wall-clock and/or energy budget */
+        parse_budget(optarg, opts);
+        break;
+
       default:
         throw  OptionException("Internal error in option parsing");
     }
@@ -1027,9 +1240,9 @@ void CommandLineParser::print_help()
             "  --support                                  compute bipartition support for a given reference tree (e.g., best ML tree)\n"
             "                                             and a set of replicate trees (e.g., from a bootstrap analysis)\n"
             "  --bsconverge                               test for bootstrapping convergence using autoMRE criterion\n"
-            "  --bsmsa                                    generate bootstrap replicate MSAs\n"
+            "  --bsmsa [ PHYLIP | RBA ]                   generate bootstrap replicate MSAs (default: PHYLIP)\n"
 #ifdef _RAXML_TERRAPHAST
-            "  --terrace                                  check whether a tree lies on a phylogenetic terrace \n"
+            "  --terrace                                  check whether a tree (or a set of trees) lies on a phylogenetic terrace\n"
 #endif
             "  --check                                    check alignment correctness and remove empty columns/rows\n"
             "  --parse                                    parse alignment, compress patterns and create binary MSA file\n"
@@ -1037,7 +1250,10 @@ void CommandLineParser::print_help()
             "  --rfdist                                   compute pair-wise Robinson-Foulds (RF) distances between trees\n"
             "  --consense [ STRICT | MR | MR<n> | MRE ]   build strict, majority-rule (MR) or extended MR (MRE) consensus tree (default: MR)\n"
             "                                             eg: --consense MR75 --tree bsrep.nw\n"
-            "  --ancestral                                ancestral state reconstruction at all inner nodes\n"
+            "  --ancestral [ <FMT>,stream{N} ]            ancestral state reconstruction at all inner nodes\n"
+            "                                             FMT = text | float | uint8 (probabilities file format, default: text)\n"
+            "                                             stream{N} = write N nodes at a time (default N: 16); this bounds\n"
+            "                                             the output buffers only, libpll still holds all inner nodes\n"
             "  --sitelh                                   print per-site log-likelihood values\n"
             "\n"
             "Command shortcuts (mutually exclusive):\n"
@@ -1059,6 +1275,11 @@ void CommandLineParser::print_help()
             "  --precision       VALUE                    number of decimal places to print (default: 6)\n"
             "  --outgroup        o1,o2,..,oN              comma-separated list of outgroup taxon names (it's just a drawing option!)\n"
             "  --site-weights    FILE                     file with MSA column weights (positive integers only!)  \n"
+            "  --tree-format     newick | binary{<BL>}    output format for ML and bootstrap tree sets (default: newick)\n"
+            "                                             BL = branch lengths: full (default), f32, q16 or none\n"
+            "                                             (f32 and q16 are lossy, q16: up to 0.015% relative error)\n"
+            "  --asr-nodes       n1,n2,..,nN              comma-separated list of inner nodes for ancestral state reconstruction\n"
+            "  --profile         [ json | csv ]           write per-thread timers and call counters for each search phase (default: json)\n"
             "\n"
             "General options:\n"
             "  --seed         VALUE                       seed for pseudo-random number generator (default: current time)\n"
@@ -1070,6 +1291,9 @@ void CommandLineParser::print_help()
             "  --simd         none | sse3 | avx | avx2    vector instruction set to use (default: auto-detect).\n"
             "  --rate-scalers on | off                    use individual CLV scalers for each rate category (default: ON for >2000 taxa)\n"
             "  --force        [ <CHECKS> ]                disable safety checks (please think twice!)\n"
+            "  --budget       TIME | ENERGY [,...]        fit the analysis into a wall-clock (e.g. 23h30m) and/or\n"
+            "                                             energy (e.g. 5kWh) budget: fewer starting trees,\n"
+            "                                             bootstrap replicates and SPR rounds if needed\n"
             "\n"
             "Model options:\n"
             "  --model        <name>+G[n]+<Freqs> | FILE  model specification OR partition file\n"
@@ -1091,7 +1315,7 @@ void CommandLineParser::print_help()
             "Bootstrapping options:\n"
             "  --bs-trees     VALUE                       number of bootstraps replicates\n"
             "  --bs-trees     autoMRE{N}                  use MRE-based bootstrap convergence criterion, up to N replicates (default: 1000)\n"
-            "  --bs-trees     FILE                        Newick file containing set of bootstrap replicate trees (with --support)\n"
+            "  --bs-trees     FILE                        Newick or binary (RBT) file containing set of bootstrap replicate trees (with --support)\n"
             "  --bs-cutoff    VALUE                       cutoff threshold for the MRE-based bootstopping criteria (default: 0.03)\n"
             "  --bs-metric    fbp | tbe                   branch support metric: fbp = Felsenstein bootstrap (default), tbe = transfer distance\n"
             "  --bs-write-msa on | off                    write all bootstrap alignments (default: OFF)\n";
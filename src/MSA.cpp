@@ -1,17 +1,25 @@
 #include <stdexcept>
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 
 #include "MSA.hpp"
 
 using namespace std;
 
-MSA::MSA(const RangeList& rl) : _length(0), _states(0), _pll_msa(NULL), _dirty(false)
+static const unsigned int PROB_STATE_FLAG = 1u << 31;
+/* uncertain sites are stored normalized with 16-bit precision (abs. error <= 0.5/65535) */
+static const unsigned int PROB_QUANT_SCALE = 65535;
+
+MSA::MSA(const RangeList& rl) : _length(0), _shared_seqs(nullptr), _shared_count(0), _states(0),
+    _pll_msa(NULL), _dirty(false)
 {
   local_seq_ranges(rl);
 }
 
 MSA::MSA(const pll_msa_t *pll_msa) :
-    _length(0), _num_sites(pll_msa->length), _states(0), _pll_msa(nullptr)
+    _length(0), _num_sites(pll_msa->length), _shared_seqs(nullptr), _shared_count(0), _states(0),
+    _pll_msa(nullptr)
 {
   for (auto i = 0; i < pll_msa->count; ++i)
   {
@@ -22,12 +30,14 @@ MSA::MSA(const pll_msa_t *pll_msa) :
 }
 
 MSA::MSA(MSA&& other) : _length(other._length), _num_sites(other._num_sites),
-    _sequences(move(other._sequences)), _labels(move(other._labels)),
+    _sequences(move(other._sequences)), _shared_seqs(other._shared_seqs),
+    _shared_count(other._shared_count), _labels(move(other._labels)),
     _label_id_map(move(other._label_id_map)), _weights(move(other._weights)),
-    _probs(move(other._probs)), _local_seq_ranges(move(other._local_seq_ranges)),
+    _site_pattern_map(move(other._site_pattern_map)), _probs(move(other._probs)), _local_seq_ranges(move(other._local_seq_ranges)),
     _states(other._states), _pll_msa(other._pll_msa), _dirty(other._dirty)
 {
-  other._length = other._num_sites = 0;
+  other._length = other._num_sites = other._shared_count = 0;
+  other._shared_seqs = nullptr;
   other._pll_msa = nullptr;
   other._dirty = false;
 };
@@ -53,7 +63,10 @@ MSA& MSA::operator=(MSA&& other)
     _num_sites = other._num_sites;
     _pll_msa = other._pll_msa;
     _weights = std::move(other._weights);
+    _site_pattern_map = std::move(other._site_pattern_map);
     _sequences = std::move(other._sequences);
+    _shared_seqs = other._shared_seqs;
+    _shared_count = other._shared_count;
     _labels = std::move(other._labels);
     _label_id_map = std::move(other._label_id_map);
     _probs = std::move(other._probs);
@@ -62,7 +75,8 @@ MSA& MSA::operator=(MSA&& other)
     _dirty = other._dirty;
 
     // reset other
-    other._length = other._num_sites = other._states = 0;
+    other._length = other._num_sites = other._states = other._shared_count = 0;
+    other._shared_seqs = nullptr;
     other._pll_msa = nullptr;
     other._dirty = false;
   }
@@ -83,6 +97,9 @@ void MSA::free_pll_msa() noexcept
 
 void MSA::append(const string& sequence, const string& header)
 {
+  if (_shared_seqs)
+    throw runtime_error("Cannot modify an MSA with shared sequence storage!");
+
   if(_length && sequence.length() != (size_t) _length)
     throw runtime_error{string("Tried to insert sequence to MSA of unequal length: ") + sequence};
 
@@ -106,6 +123,13 @@ void MSA::append(const string& sequence, const string& header)
 
 void MSA::compress_patterns(const pll_state_t * charmap, bool store_backmap)
 {
+  if (_shared_seqs)
+    throw runtime_error("Cannot modify an MSA with shared sequence storage!");
+
+  /* e.g. CATG alignment compressed while reading: weights and backmap are final already */
+  if (_site_pattern_map.size() > _length)
+    throw runtime_error("Alignment is already pattern-compressed!");
+
   update_pll_msa();
 
   assert(_pll_msa->count && _pll_msa->length);
@@ -163,25 +187,22 @@ void MSA::update_pll_msa() const
     _dirty = true;
   }
 
-  assert(_labels.empty() || _labels.size() == _sequences.size());
+  assert(_labels.empty() || _labels.size() == size());
 
   if (_dirty)
   {
     _pll_msa->count = size();
     _pll_msa->length = length();
 
-    size_t i = 0;
+    free(_pll_msa->sequence);
     _pll_msa->sequence = (char **) calloc(_pll_msa->count, sizeof(char *));
-    for (const auto& entry : _sequences)
-    {
-      _pll_msa->sequence[i] = (char *) entry.c_str();
-      ++i;
-    }
-    assert(i == size());
+    for (size_t i = 0; i < size(); ++i)
+      _pll_msa->sequence[i] = (char *) sequence_data(i);
 
     if (!_labels.empty())
     {
-      i = 0;
+      size_t i = 0;
+      free(_pll_msa->label);
       _pll_msa->label = (char **) calloc(_pll_msa->count, sizeof(char *));
       for (const auto& entry : _labels)
       {
@@ -195,60 +216,214 @@ void MSA::update_pll_msa() const
   }
 }
 
-void MSA::states(size_t states)
+/* normalize and quantize site probabilities; near-certain sites are encoded as a single
+ * state (return value has PROB_STATE_FLAG set), otherwise qprobs is filled */
+static unsigned int encode_probs(const double * site_probs, size_t states, uint16_t * qprobs)
 {
-  _states = states;
-  if (size() > 0)
+  double sum = 0.;
+  size_t max_state = 0;
+  for (size_t k = 0; k < states; ++k)
   {
-    _probs.resize(size());
-    for (auto& v: _probs)
-    {
-      v.resize(_length * _states);
-    }
+    sum += site_probs[k];
+    if (site_probs[k] > site_probs[max_state])
+      max_state = k;
   }
+
+  if (sum > 0. && site_probs[max_state] >= (1. - RAXML_PROBMSA_EPSILON) * sum)
+    return PROB_STATE_FLAG | max_state;
+
+  /* all-zero vector = missing data -> all states equally likely */
+  for (size_t k = 0; k < states; ++k)
+  {
+    qprobs[k] = (sum > 0.) ? (uint16_t) std::round(site_probs[k] / sum * PROB_QUANT_SCALE) :
+                             PROB_QUANT_SCALE;
+  }
+
+  return 0;
 }
 
-ProbVector::const_iterator MSA::probs(size_t index, size_t site) const
+void MSA::probs(size_t index, size_t site, double * site_probs) const
 {
-  return _probs.at(index).cbegin() + site * _states;
+  const auto& sp = _probs.at(index);
+  auto entry = sp.site_map.at(site);
+
+  if (entry & PROB_STATE_FLAG)
+  {
+    std::fill(site_probs, site_probs + _states, 0.);
+    site_probs[entry & ~PROB_STATE_FLAG] = 1.;
+  }
+  else
+  {
+    auto q = sp.dense.cbegin() + entry * _states;
+    for (size_t k = 0; k < _states; ++k)
+      site_probs[k] = ((double) q[k]) / PROB_QUANT_SCALE;
+  }
 }
 
-ProbVector::iterator MSA::probs(size_t index, size_t site)
+size_t MSA::uncertain_sites() const
 {
-  return _probs.at(index).begin() + site * _states;
+  size_t count = 0;
+  for (const auto& sp: _probs)
+    count += sp.dense.size() / _states;
+  return count;
 }
 
-bool MSA::normalized() const
+void MSA::init_prob_columns(const NameList& labels, size_t states)
 {
-  if (!probabilistic())
-    return true;
+  assert(empty() && states > 0);
 
-  for (const auto& pv: _probs)
+  for (const auto& label: labels)
+    append("", label);
+
+  _states = states;
+  _probs.assign(size(), SparseProbs());
+  _weights.clear();
+  _site_pattern_map.clear();
+  _prob_column_index.clear();
+}
+
+bool MSA::prob_column_equals(size_t pattern, const std::string& chars, const uintVector& codes,
+                             const std::vector<uint16_t>& qprobs) const
+{
+  for (size_t j = 0; j < size(); ++j)
   {
-    for (auto p: pv)
+    if (_sequences[j][pattern] != chars[j])
+      return false;
+
+    const auto& sp = _probs[j];
+    auto entry = sp.site_map[pattern];
+    if (codes[j] & PROB_STATE_FLAG)
     {
-      if (p > 1.)
+      if (entry != codes[j])
         return false;
     }
+    else if ((entry & PROB_STATE_FLAG) ||
+             !std::equal(qprobs.cbegin() + j * _states, qprobs.cbegin() + (j+1) * _states,
+                         sp.dense.cbegin() + entry * _states))
+      return false;
   }
 
   return true;
 }
 
+size_t MSA::append_prob_column(const std::string& chars, const doubleVector& probs, bool compress)
+{
+  const auto taxa = size();
+
+  assert(chars.size() == taxa && probs.size() == taxa * _states);
+
+  uintVector codes(taxa);
+  std::vector<uint16_t> qprobs(taxa * _states);
+  size_t hash = std::hash<std::string>()(chars);
+  for (size_t j = 0; j < taxa; ++j)
+  {
+    codes[j] = encode_probs(probs.data() + j * _states, _states, qprobs.data() + j * _states);
+
+    hash = hash * 31 + codes[j];
+    if (!(codes[j] & PROB_STATE_FLAG))
+    {
+      for (size_t k = 0; k < _states; ++k)
+        hash = hash * 31 + qprobs[j * _states + k];
+    }
+  }
+
+  if (compress)
+  {
+    auto range = _prob_column_index.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      if (prob_column_equals(it->second, chars, codes, qprobs))
+      {
+        _weights[it->second]++;
+        _site_pattern_map.push_back(it->second);
+        return it->second;
+      }
+    }
+  }
+
+  /* new pattern */
+  const size_t pattern = _length;
+  for (size_t j = 0; j < taxa; ++j)
+  {
+    _sequences[j].push_back(chars[j]);
+
+    auto& sp = _probs[j];
+    if (codes[j] & PROB_STATE_FLAG)
+      sp.site_map.push_back(codes[j]);
+    else
+    {
+      auto dense_idx = sp.dense.size() / _states;
+      if (dense_idx >= PROB_STATE_FLAG)
+        throw runtime_error("Too many uncertain sites in probabilistic alignment!");
+      sp.site_map.push_back(dense_idx);
+      sp.dense.insert(sp.dense.end(), qprobs.cbegin() + j * _states,
+                      qprobs.cbegin() + (j+1) * _states);
+    }
+  }
+
+  _weights.push_back(1);
+  _site_pattern_map.push_back(pattern);
+  if (compress)
+    _prob_column_index.emplace(hash, pattern);
+
+  _length++;
+  _dirty = true;
+
+  return pattern;
+}
+
+void MSA::finalize_prob_columns()
+{
+  std::unordered_multimap<size_t, size_t>().swap(_prob_column_index);
+
+  if (_site_pattern_map.size() == _length)
+  {
+    /* nothing was merged -> plain, uncompressed MSA */
+    _weights.clear();
+    _site_pattern_map.clear();
+    _num_sites = _length;
+  }
+  else
+    update_num_sites();
+
+  for (auto& seq: _sequences)
+    seq.shrink_to_fit();
+
+  for (auto& sp: _probs)
+  {
+    sp.site_map.shrink_to_fit();
+    sp.dense.shrink_to_fit();
+  }
+
+  _dirty = true;
+}
+
 doubleVector MSA::state_freqs() const
 {
   assert(_states > 0);
 
   double sum = 0;
   doubleVector freqs(_states, 0.);
-  for (const auto& pv: _probs)
+  for (const auto& sp: _probs)
   {
-    for (auto p = pv.cbegin(); p != pv.cend();)
+    for (size_t site = 0; site < sp.site_map.size(); ++site)
     {
-      for (size_t i = 0; i < _states; ++i, ++p)
+      const double w = _weights.empty() ? 1. : _weights[site];
+      const auto entry = sp.site_map[site];
+      if (entry & PROB_STATE_FLAG)
+      {
+        freqs[entry & ~PROB_STATE_FLAG] += w;
+        sum += w;
+      }
+      else
       {
-        freqs[i] += *p;
-        sum += *p;
+        auto q = sp.dense.cbegin() + entry * _states;
+        for (size_t i = 0; i < _states; ++i)
+        {
+          double p = w * q[i] / PROB_QUANT_SCALE;
+          freqs[i] += p;
+          sum += p;
+        }
       }
     }
   }
@@ -267,6 +442,9 @@ void MSA::remove_sites(const std::vector<size_t>& site_indices)
   if (site_indices.empty())
     return;
 
+  if (_shared_seqs)
+    throw runtime_error("Cannot modify an MSA with shared sequence storage!");
+
   assert(_length);
 
   auto sorted_indicies = site_indices;
@@ -339,6 +517,56 @@ void MSA::weights(WeightVector&& v)
 }
 
 
+const std::string& MSA::at(size_t index) const
+{
+  if (_shared_seqs)
+    throw runtime_error("Sequence strings are not available for an MSA with shared storage!");
+
+  return _sequences.at(index);
+}
+
+std::string& MSA::operator[](size_t index)
+{
+  if (_shared_seqs)
+    throw runtime_error("Cannot modify an MSA with shared sequence storage!");
+
+  return _sequences.at(index);
+}
+
+const char * MSA::sequence_data(size_t index) const
+{
+  if (_shared_seqs)
+  {
+    if (index >= _shared_count)
+      throw out_of_range("Invalid sequence index: " + to_string(index));
+    return _shared_seqs + index * _length;
+  }
+  else
+    return _sequences.at(index).c_str();
+}
+
+void MSA::share_sequences(char * buf, bool copy)
+{
+  if (_shared_seqs)
+    throw runtime_error("MSA sequences are already shared!");
+
+  if (copy)
+  {
+    for (size_t i = 0; i < _sequences.size(); ++i)
+    {
+      assert(_sequences[i].size() == _length);
+      memcpy(buf + i * _length, _sequences[i].data(), _length);
+    }
+  }
+
+  _shared_count = _sequences.size();
+  _shared_seqs = buf;
+  container().swap(_sequences);
+
+  /* pll_msa points to the old sequence buffers */
+  _dirty = true;
+}
+
 const RangeList& MSA::local_seq_ranges() const
 {
   return _local_seq_ranges;
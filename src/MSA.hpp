@@ -1,11 +1,23 @@
 #ifndef RAXML_MSA_HPP_
 #define RAXML_MSA_HPP_
 
+#include <unordered_map>
+
 #include "common.h"
 
 typedef std::vector<double> ProbVector;
 typedef std::vector<ProbVector> ProbVectorList;
 
+/* compact per-taxon storage of state probabilities: near-certain sites are stored
+ * as a single state, uncertain sites as (normalized) quantized probability vectors */
+struct SparseProbs
+{
+  uintVector site_map;                /* per site: PROB_STATE_FLAG | state, or index into dense */
+  std::vector<uint16_t> dense;        /* quantized probability vectors of uncertain sites */
+};
+
+typedef std::vector<SparseProbs> SparseProbsList;
+
 struct Range
 {
   size_t start;
@@ -24,9 +36,10 @@ public:
   typedef typename container::iterator        iterator;
   typedef typename container::const_iterator  const_iterator;
 
-  MSA() : _length(0), _num_sites(0), _states(0), _pll_msa(NULL), _dirty(false) {};
-  MSA(const unsigned int num_sites) : _length(0), _num_sites(num_sites),
-      _states(0), _pll_msa(nullptr), _dirty(false) {};
+  MSA() : _length(0), _num_sites(0), _shared_seqs(nullptr), _shared_count(0), _states(0),
+      _pll_msa(NULL), _dirty(false) {};
+  MSA(const unsigned int num_sites) : _length(0), _num_sites(num_sites), _shared_seqs(nullptr),
+      _shared_count(0), _states(0), _pll_msa(nullptr), _dirty(false) {};
   MSA(const RangeList& rl);
 
   MSA(const pll_msa_t * pll_msa);
@@ -41,8 +54,8 @@ public:
   void append(const std::string& sequence, const std::string& header = "");
   void compress_patterns(const pll_state_t * charmap, bool store_backmap = false);
 
-  bool empty() const { return _sequences.empty(); }
-  size_t size() const { return _sequences.size(); }
+  bool empty() const { return size() == 0; }
+  size_t size() const { return _shared_seqs ? _shared_count : _sequences.size(); }
   size_t length() const { return _length; }
   size_t num_sites() const { return _num_sites; }
   size_t num_patterns() const { return _weights.size(); }
@@ -53,20 +66,31 @@ public:
 
   const container& labels() const { return _labels; };
   const std::string& label(size_t index) const { return _labels.at(index); }
-  const std::string& at(const std::string& label) const
-  { return _sequences.at(_label_id_map.at(label)); }
-  const std::string& at(size_t index) const { return _sequences.at(index); }
+  /* per-sequence strings are not available with shared storage -> use sequence_data() */
+  const std::string& at(const std::string& label) const { return at(_label_id_map.at(label)); }
+  const std::string& at(size_t index) const;
   const std::string& operator[](const std::string& label) const { return at(label); }
   const std::string& operator[](size_t index) const { return at(index); }
-  std::string& operator[](size_t index) { return _sequences.at(index); }
+  std::string& operator[](size_t index);
+
+  /* raw sequence access, works for both own and shared sequence storage */
+  const char * sequence_data(size_t index) const;
+
+  /* move sequences into an external read-only buffer of size() * length() bytes
+   * (e.g. node-local shared memory); buffer is filled only if copy == true.
+   * Afterwards, sequences are only accessible via sequence_data() */
+  void share_sequences(char * buf, bool copy);
+  bool shared() const { return _shared_seqs != nullptr; }
 
   bool probabilistic() const { return _states > 0; }
-  bool normalized() const;
   size_t states() const { return _states; }
-  void states(size_t states);
-  const ProbVector& probs(size_t index) const { return _probs.at(index); }
-  ProbVector::const_iterator probs(size_t index, size_t site) const;
-  ProbVector::iterator probs(size_t index, size_t site);
+  void probs(size_t index, size_t site, double * site_probs) const;
+  size_t uncertain_sites() const;
+
+  /* probabilistic MSAs are built column by column, optionally merging identical columns */
+  void init_prob_columns(const NameList& labels, size_t states);
+  size_t append_prob_column(const std::string& chars, const doubleVector& probs, bool compress);
+  void finalize_prob_columns();
 
   doubleVector state_freqs() const;
 
@@ -95,17 +119,22 @@ private:
   size_t _length;
   size_t _num_sites;
   container _sequences;
+  const char * _shared_seqs;
+  size_t _shared_count;
   container _labels;
   NameIdMap _label_id_map;
   WeightVector _weights;
   WeightVector _site_pattern_map;
-  ProbVectorList _probs;
+  SparseProbsList _probs;
+  std::unordered_multimap<size_t, size_t> _prob_column_index;   /* column hash -> pattern */
   RangeList _local_seq_ranges;
   size_t _states;
   mutable pll_msa_t * _pll_msa;
   mutable bool _dirty;
 
   void update_pll_msa() const;
+  bool prob_column_equals(size_t pattern, const std::string& chars, const uintVector& codes,
+                          const std::vector<uint16_t>& qprobs) const;
   void free_pll_msa() noexcept;
 
   void update_num_sites();
@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <unordered_map>
+
+#include "MSAChecker.hpp"
+
+using namespace std;
+
+/* character classes: exactly one bit is set for every char */
+static const unsigned char CHAR_INVALID = 1;
+static const unsigned char CHAR_GAP     = 2;
+static const unsigned char CHAR_STATE   = 4;
+
+MSAChecker::MSAChecker(const PartitionedMSA& parted_msa, bool check_dups, bool check_gaps,
+                       size_t num_threads) :
+    _parted_msa(parted_msa), _check_dups(check_dups), _check_gaps(check_gaps),
+    _num_threads(max<size_t>(num_threads, 1))
+{
+  const auto taxa = parted_msa.taxon_count();
+  const auto parts = parted_msa.part_count();
+
+  /* gap = "any state" code, same definition as in pllmod_msa_compute_stats() */
+  for (const auto& pinfo: parted_msa.part_list())
+  {
+    const auto states = pinfo.model().num_states();
+    const pll_state_t gap_state = states < sizeof(pll_state_t) * 8 ?
+                                  (((pll_state_t) 1) << states) - 1 : ~((pll_state_t) 0);
+    const pll_state_t * charmap = pinfo.model().charmap();
+
+    CharClassTable cls;
+    for (size_t c = 0; c < cls.size(); ++c)
+    {
+      if (!charmap[c])
+        cls[c] = CHAR_INVALID;
+      else if (charmap[c] == gap_state)
+        cls[c] = CHAR_GAP;
+      else
+        cls[c] = CHAR_STATE;
+    }
+    _char_classes.push_back(cls);
+  }
+
+  if (_check_dups)
+    _seq_hashes.resize(taxa);
+
+  _gap_seq_flags.assign(taxa, 0);
+  _thread_invalid.resize(_num_threads);
+
+  if (_check_gaps)
+  {
+    _thread_informative.resize(_num_threads);
+    for (auto& ti: _thread_informative)
+    {
+      ti.resize(parts);
+      for (size_t p = 0; p < parts; ++p)
+        ti[p].assign(parted_msa.part_info(p).msa().length(), 0);
+    }
+  }
+}
+
+void MSAChecker::thread_check()
+{
+  const auto tid = ParallelContext::thread_id();
+  const auto num_threads = ParallelContext::num_threads();
+  const auto taxa = _parted_msa.taxon_count();
+  const auto parts = _parted_msa.part_count();
+
+  assert(num_threads <= _num_threads);
+
+  auto& invalid = _thread_invalid[tid];
+
+  for (size_t i = tid; i < taxa; i += num_threads)
+  {
+    if (_check_dups)
+      _seq_hashes[i] = std::hash<std::string>()(_parted_msa.full_msa().at(i));
+
+    bool all_gaps = true;
+    for (size_t p = 0; p < parts; ++p)
+    {
+      const auto& seq = _parted_msa.part_info(p).msa().at(i);
+      const auto cls = _char_classes[p].data();
+      const auto len = seq.size();
+      const auto s = (const unsigned char *) seq.data();
+
+      /* branch-free table scan, per-column "informative" flags are OR-ed */
+      unsigned char seq_flags = 0;
+      if (_check_gaps)
+      {
+        auto informative = _thread_informative[tid][p].data();
+        for (size_t j = 0; j < len; ++j)
+        {
+          const auto k = cls[s[j]];
+          seq_flags |= k;
+          informative[j] |= k & (CHAR_STATE | CHAR_INVALID);
+        }
+      }
+      else
+      {
+        for (size_t j = 0; j < len; ++j)
+          seq_flags |= cls[s[j]];
+      }
+
+      /* slow path: collect positions of invalid characters */
+      if (seq_flags & CHAR_INVALID)
+      {
+        for (size_t j = 0; j < len; ++j)
+        {
+          if (cls[s[j]] == CHAR_INVALID)
+            invalid.push_back({p, i, j, (char) s[j]});
+        }
+      }
+
+      all_gaps &= (seq_flags == CHAR_GAP);
+    }
+
+    _gap_seq_flags[i] = all_gaps ? 1 : 0;
+  }
+}
+
+void MSAChecker::finalize()
+{
+  const auto taxa = _parted_msa.taxon_count();
+  const auto parts = _parted_msa.part_count();
+
+  /* duplicates: group by hash, then confirm with a full comparison */
+  _dup_seqs.clear();
+  if (_check_dups)
+  {
+    const auto& full_msa = _parted_msa.full_msa();
+    unordered_multimap<size_t, size_t> first_seqs;
+    for (size_t i = 0; i < taxa; ++i)
+    {
+      bool dup = false;
+      auto range = first_seqs.equal_range(_seq_hashes[i]);
+      for (auto it = range.first; it != range.second; ++it)
+      {
+        if (full_msa.at(it->second) == full_msa.at(i))
+        {
+          _dup_seqs.emplace_back(it->second, i);
+          dup = true;
+          break;
+        }
+      }
+
+      if (!dup)
+        first_seqs.emplace(_seq_hashes[i], i);
+    }
+  }
+
+  _invalid_chars.clear();
+  for (auto& ti: _thread_invalid)
+    _invalid_chars.insert(_invalid_chars.end(), ti.cbegin(), ti.cend());
+
+  sort(_invalid_chars.begin(), _invalid_chars.end(),
+       [](const InvalidChar& a, const InvalidChar& b) -> bool
+       {
+         return a.part_id != b.part_id ? a.part_id < b.part_id :
+                (a.seq_id != b.seq_id ? a.seq_id < b.seq_id : a.site < b.site);
+       });
+
+  _gap_cols.assign(parts, std::vector<size_t>());
+  _gap_seqs.clear();
+  if (_check_gaps)
+  {
+    for (size_t p = 0; p < parts; ++p)
+    {
+      const auto len = _parted_msa.part_info(p).msa().length();
+      for (size_t j = 0; j < len; ++j)
+      {
+        bool informative = false;
+        for (const auto& ti: _thread_informative)
+          informative |= ti[p][j] != 0;
+
+        if (!informative)
+          _gap_cols[p].push_back(j);
+      }
+    }
+
+    for (size_t i = 0; i < taxa; ++i)
+    {
+      if (_gap_seq_flags[i])
+        _gap_seqs.insert(i);
+    }
+  }
+
+  /* free per-thread buffers */
+  decltype(_thread_informative)().swap(_thread_informative);
+  decltype(_thread_invalid)().swap(_thread_invalid);
+}
@@ -0,0 +1,59 @@
+#ifndef RAXML_MSACHECKER_HPP_
+#define RAXML_MSACHECKER_HPP_
+
+#include <array>
+#include <set>
+
+#include "PartitionedMSA.hpp"
+
+/*
+ * Native alignment validation: duplicate sequences, invalid characters and all-gap
+ * columns/sequences are detected for all partitions in a single sweep over the data.
+ * Sequences are distributed among threads: thread_check() must be called by every thread
+ * of the pool, and finalize() afterwards by the master thread only.
+ */
+class MSAChecker
+{
+public:
+  struct InvalidChar
+  {
+    size_t part_id;
+    size_t seq_id;
+    size_t site;        /* partition-local */
+    char c;
+  };
+
+  typedef std::pair<size_t, size_t> SeqPair;
+
+  MSAChecker(const PartitionedMSA& parted_msa, bool check_dups, bool check_gaps,
+             size_t num_threads);
+
+  void thread_check();
+  void finalize();
+
+  const std::vector<SeqPair>& dup_seqs() const { return _dup_seqs; }
+  const std::vector<InvalidChar>& invalid_chars() const { return _invalid_chars; }
+  const std::vector<std::vector<size_t> >& gap_cols() const { return _gap_cols; }
+  const std::set<size_t>& gap_seqs() const { return _gap_seqs; }
+
+private:
+  typedef std::array<unsigned char, 256> CharClassTable;
+
+  const PartitionedMSA& _parted_msa;
+  bool _check_dups;
+  bool _check_gaps;
+  size_t _num_threads;
+
+  std::vector<CharClassTable> _char_classes;                  /* per partition */
+  std::vector<size_t> _seq_hashes;
+  std::vector<unsigned char> _gap_seq_flags;
+  std::vector<std::vector<InvalidChar> > _thread_invalid;      /* per thread */
+  std::vector<std::vector<std::vector<unsigned char> > > _thread_informative; /* [thread][part][site] */
+
+  std::vector<SeqPair> _dup_seqs;
+  std::vector<InvalidChar> _invalid_chars;
+  std::vector<std::vector<size_t> > _gap_cols;
+  std::set<size_t> _gap_seqs;
+};
+
+#endif /* RAXML_MSACHECKER_HPP_ */
@@ -1,10 +1,59 @@
 #include "Optimizer.hpp"
+#include "util/EnergyMonitor.hpp"
+#include "util/RunBudget.hpp"
 
 using namespace std;
 
+/* model parameters which are subject to adaptive scheduling (-> tracked by TreeInfo) */
+static const int ADAPTIVE_MODOPT_PARAMS = PLLMOD_OPT_PARAM_SUBST_RATES | PLLMOD_OPT_PARAM_FREQUENCIES |
+                                          PLLMOD_OPT_PARAM_ALPHA | PLLMOD_OPT_PARAM_PINV |
+                                          PLLMOD_OPT_PARAM_FREE_RATES;
+
+static const char * step_name(CheckpointStep step)
+{
+  static const char * const names[] = {"start", "brlenOpt", "modOpt1", "radiusDetect", "modOpt2",
+                                       "fastSPR", "modOpt3", "slowSPR", "modOpt4", "finish"};
+  return names[(int) step];
+}
+
+static EnergyPhase energy_phase(CheckpointStep step)
+{
+  switch (step)
+  {
+    case CheckpointStep::radiusDetect:
+    case CheckpointStep::fastSPR:
+      return EnergyPhase::fast_spr;
+    case CheckpointStep::slowSPR:
+      return EnergyPhase::slow_spr;
+    case CheckpointStep::start:
+    case CheckpointStep::finish:
+      return EnergyPhase::other;
+    default:
+      return EnergyPhase::modopt;
+  }
+}
+
+static double relative_rfdist(const Tree& tree1, const Tree& tree2)
+{
+  auto num_tips = tree1.num_tips();
+  if (num_tips <= 3)
+    return 0.;
+
+  pll_split_t * splits1 = pllmod_utree_split_create(&tree1.pll_utree_root(), num_tips, nullptr);
+  pll_split_t * splits2 = pllmod_utree_split_create(&tree2.pll_utree_root(), num_tips, nullptr);
+
+  auto rf = pllmod_utree_split_rf_distance(splits1, splits2, num_tips);
+
+  pllmod_utree_split_destroy(splits1);
+  pllmod_utree_split_destroy(splits2);
+
+  return ((double) rf) / (2 * (num_tips - 3));
+}
+
 Optimizer::Optimizer (const Options &opts) :
     _lh_epsilon(opts.lh_epsilon), _lh_epsilon_brlen_triplet(opts.lh_epsilon_brlen_triplet),
-    _spr_radius(opts.spr_radius), _spr_cutoff(opts.spr_cutoff)
+    _spr_radius(opts.spr_radius), _spr_cutoff(opts.spr_cutoff), _split_modopt(opts.use_split_modopt),
+    _adaptive_modopt(opts.use_adaptive_modopt), _budget_limit(0.)
 {
 }
 
@@ -13,10 +62,22 @@ Optimizer::~Optimizer ()
   // TODO Auto-generated destructor stub
 }
 
-double Optimizer::optimize_model(TreeInfo& treeinfo, double lh_epsilon)
+/* NOTE: collective call, see RunBudget::worker_exceeded() */
+bool Optimizer::budget_exceeded(double loglh) const
+{
+  if (_budget_limit <= 0. || !global_budget.worker_exceeded(_budget_limit))
+    return false;
+
+  LOG_PROGRESS(loglh) << "Run budget exhausted, skipping remaining SPR rounds" << endl;
+  return true;
+}
+
+double Optimizer::optimize_model(TreeInfo& treeinfo, double lh_epsilon, int params_to_optimize)
 {
   double new_loglh = treeinfo.loglh();
 
+  treeinfo.reset_param_gains();
+
 //  if (!params_to_optimize)
 //    return new_loglh;
 
@@ -26,7 +87,7 @@ double Optimizer::optimize_model(TreeInfo& treeinfo, double lh_epsilon)
   {
     cur_loglh = new_loglh;
 
-    treeinfo.optimize_params_all(lh_epsilon);
+    treeinfo.optimize_params(params_to_optimize, lh_epsilon, _split_modopt);
 
     new_loglh = treeinfo.loglh();
 
@@ -40,6 +101,41 @@ double Optimizer::optimize_model(TreeInfo& treeinfo, double lh_epsilon)
   return new_loglh;
 }
 
+/*
+ * Model parameters are re-optimized between the SPR phases. If the topology did not change
+ * much since the last model optimization, parameters which did not improve the logLH last
+ * time are left out, and the convergence criterion is relaxed. If no model parameter is left,
+ * only branch lengths are optimized; after RAXML_MODOPT_MAX_SKIPPED such steps in a row,
+ * a full optimization is enforced.
+ */
+void Optimizer::schedule_modopt(modopt_schedule& sched, double lh_epsilon, bool adaptive)
+{
+  sched.params = PLLMOD_OPT_PARAM_ALL;
+  sched.lh_epsilon = lh_epsilon;
+
+  if (!adaptive || sched.topol_dist > RAXML_MODOPT_STABLE_RFDIST ||
+      sched.skipped >= RAXML_MODOPT_MAX_SKIPPED)
+  {
+    sched.skipped = 0;
+    return;
+  }
+
+  for (size_t i = 0; i < RAXML_MODOPT_PARAM_SLOTS; ++i)
+  {
+    int param = 1 << i;
+    if ((param & ADAPTIVE_MODOPT_PARAMS) && sched.param_gains[i] < RAXML_MODOPT_MIN_GAIN)
+      sched.params &= ~param;
+  }
+
+  if (!(sched.params & ADAPTIVE_MODOPT_PARAMS))
+    sched.skipped++;
+  else
+  {
+    sched.lh_epsilon *= RAXML_MODOPT_EPS_FACTOR;
+    sched.skipped = 0;
+  }
+}
+
 double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
 {
   const double fast_modopt_eps = 10.;
@@ -50,6 +146,9 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
   auto& search_state = ParallelContext::group_master_thread() ? cm.search_state() : local_search_state;
   ParallelContext::barrier();
 
+  /* resume joint alpha+p-inv optimization from the checkpointed state */
+  treeinfo.alpha_pinv(search_state.alpha_pinv);
+
   /* set references such that we can work directly with checkpoint values */
   double &loglh = search_state.loglh;
   int& iter = search_state.iteration;
@@ -64,17 +163,68 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
   /* Compute initial LH of the starting tree */
   loglh = treeinfo.loglh();
 
+  /* reference for adaptive model optimization: topology at the last modOpt step */
+  Tree modopt_ref_tree;
+  if (!cm.checkpoint().modopt_topology.edges.empty())
+  {
+    modopt_ref_tree = treeinfo.tree();
+    modopt_ref_tree.topology(cm.checkpoint().modopt_topology);
+  }
+
   auto do_step = [&search_state,resume_step](CheckpointStep step) -> bool
       {
         if (step >= resume_step)
         {
           search_state.step = step;
+          Profiler::phase(step_name(step));
+          global_energy_monitor.search_phase(energy_phase(step));
           return true;
         }
         else
           return false;;
       };
 
+  auto model_step = [&](CheckpointStep step, double lh_epsilon, bool adaptive) -> double
+      {
+        auto& sched = search_state.modopt;
+
+        /* when resuming, re-use the decision stored in the checkpoint */
+        if (step != resume_step)
+        {
+          sched.topol_dist = modopt_ref_tree.empty() ? 1. :
+                                         relative_rfdist(modopt_ref_tree, treeinfo.tree());
+          schedule_modopt(sched, lh_epsilon, adaptive && _adaptive_modopt);
+        }
+
+        cm.update_and_write(treeinfo);
+
+        LOG_DEBUG << "Model optimization schedule: rel. RF = " << sched.topol_dist <<
+            ", params = 0x" << hex << sched.params << dec << ", eps = " << sched.lh_epsilon << endl;
+
+        if (!(sched.params & ADAPTIVE_MODOPT_PARAMS))
+        {
+          /* keep the reference topology: drift is measured from the last full step */
+          LOG_PROGRESS(loglh) << "Model parameter optimization skipped (rel. RF distance: " <<
+              sched.topol_dist << "), branch length optimization" << endl;
+          return optimize_model(treeinfo, sched.lh_epsilon, sched.params);
+        }
+
+        LOG_PROGRESS(loglh) << "Model parameter optimization (eps = " << sched.lh_epsilon << ")" << endl;
+        auto new_loglh = optimize_model(treeinfo, sched.lh_epsilon, sched.params);
+
+        for (size_t i = 0; i < RAXML_MODOPT_PARAM_SLOTS; ++i)
+        {
+          if (sched.params & ADAPTIVE_MODOPT_PARAMS & (1 << i))
+            sched.param_gains[i] = treeinfo.param_gains()[i];
+        }
+
+        modopt_ref_tree = treeinfo.tree();
+        if (ParallelContext::group_master_thread())
+          cm.checkpoint().modopt_topology = modopt_ref_tree.topology();
+
+        return new_loglh;
+      };
+
   if (do_step(CheckpointStep::brlenOpt))
   {
     cm.update_and_write(treeinfo);
@@ -85,9 +235,7 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
   /* Initial fast model optimization */
   if (do_step(CheckpointStep::modOpt1))
   {
-    cm.update_and_write(treeinfo);
-    LOG_PROGRESS(loglh) << "Model parameter optimization (eps = " << fast_modopt_eps << ")" << endl;
-    loglh = optimize_model(treeinfo, fast_modopt_eps);
+    loglh = model_step(CheckpointStep::modOpt1, fast_modopt_eps, false);
 
     /* start spr rounds from the beginning */
     iter = 0;
@@ -118,7 +266,7 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
 
       double best_loglh = loglh;
 
-      while (spr_params.radius_min < radius_limit)
+      while (spr_params.radius_min < radius_limit && !budget_exceeded(best_loglh))
       {
         cm.update_and_write(treeinfo);
 
@@ -146,12 +294,8 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
 
   if (do_step(CheckpointStep::modOpt2))
   {
-    cm.update_and_write(treeinfo);
-
     /* optimize model parameters a bit more thoroughly */
-    LOG_PROGRESS(loglh) << "Model parameter optimization (eps = " <<
-                                                            interim_modopt_eps << ")" << endl;
-    loglh = optimize_model(treeinfo, interim_modopt_eps);
+    loglh = model_step(CheckpointStep::modOpt2, interim_modopt_eps, true);
 
     /* reset iteration counter for fast SPRs */
     iter = 0;
@@ -181,14 +325,12 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
       /* optimize ALL branches */
       loglh = treeinfo.optimize_branches(_lh_epsilon, 1);
     }
-    while (loglh - old_loglh > _lh_epsilon);
+    while (loglh - old_loglh > _lh_epsilon && !budget_exceeded(loglh));
   }
 
   if (do_step(CheckpointStep::modOpt3))
   {
-    cm.update_and_write(treeinfo);
-    LOG_PROGRESS(loglh) << "Model parameter optimization (eps = " << 1.0 << ")" << endl;
-    loglh = optimize_model(treeinfo, 1.0);
+    loglh = model_step(CheckpointStep::modOpt3, 1.0, true);
 
     /* init slow SPRs */
     spr_params.thorough = 1;
@@ -227,20 +369,20 @@ double Optimizer::optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm)
         spr_params.radius_max += radius_step;
       }
     }
-    while (spr_params.radius_min >= 0 && spr_params.radius_min < radius_limit);
+    while (spr_params.radius_min >= 0 && spr_params.radius_min < radius_limit &&
+           !budget_exceeded(loglh));
   }
 
   /* Final thorough model optimization */
   if (do_step(CheckpointStep::modOpt4))
-  {
-    cm.update_and_write(treeinfo);
-    LOG_PROGRESS(loglh) << "Model parameter optimization (eps = " << final_modopt_eps << ")" << endl;
-    loglh = optimize_model(treeinfo, final_modopt_eps);
-  }
+    loglh = model_step(CheckpointStep::modOpt4, final_modopt_eps, false);
 
   if (do_step(CheckpointStep::finish))
     cm.update_and_write(treeinfo);
 
+  Profiler::phase("other");
+  global_energy_monitor.search_phase(EnergyPhase::other);
+
   return loglh;
 }
 
@@ -252,6 +394,9 @@ double Optimizer::evaluate(TreeInfo& treeinfo, CheckpointManager& cm)
   auto& search_state = ParallelContext::group_master_thread() ? cm.search_state() : local_search_state;
   ParallelContext::barrier();
 
+  /* resume joint alpha+p-inv optimization from the checkpointed state */
+  treeinfo.alpha_pinv(search_state.alpha_pinv);
+
   double &loglh = search_state.loglh;
 
   /* Compute initial LH of the starting tree */
@@ -263,6 +408,8 @@ double Optimizer::evaluate(TreeInfo& treeinfo, CheckpointManager& cm)
         if (step >= resume_step)
         {
           search_state.step = step;
+          Profiler::phase(step_name(step));
+          global_energy_monitor.search_phase(energy_phase(step));
           return true;
         }
         else
@@ -287,5 +434,8 @@ double Optimizer::evaluate(TreeInfo& treeinfo, CheckpointManager& cm)
   if (do_step(CheckpointStep::finish))
     cm.update_and_write(treeinfo);
 
+  Profiler::phase("other");
+  global_energy_monitor.search_phase(EnergyPhase::other);
+
   return loglh;
 }
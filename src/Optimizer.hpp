@@ -11,15 +11,27 @@ public:
   virtual
   ~Optimizer ();
 
-  double optimize_model(TreeInfo& treeinfo, double lh_epsilon);
+  double optimize_model(TreeInfo& treeinfo, double lh_epsilon,
+                        int params_to_optimize = PLLMOD_OPT_PARAM_ALL);
   double optimize_model(TreeInfo& treeinfo) { return optimize_model(treeinfo, _lh_epsilon); };
   double optimize_topology(TreeInfo& treeinfo, CheckpointManager& cm);
   double evaluate(TreeInfo& treeinfo, CheckpointManager& cm);
+
+  /* fraction of the run budget after which SPR rounds are cut short (0 = none) */
+  void budget_limit(double limit) { _budget_limit = limit; }
+
+  /* model parameters and logLH epsilon for the next modOpt step */
+  static void schedule_modopt(modopt_schedule& sched, double lh_epsilon, bool adaptive);
 private:
   double _lh_epsilon;
   double _lh_epsilon_brlen_triplet;
   int _spr_radius;
   double _spr_cutoff;
+  bool _split_modopt;
+  bool _adaptive_modopt;
+  double _budget_limit;
+
+  bool budget_exceeded(double loglh) const;
 };
 
 #endif /* RAXML_OPTIMIZER_H_ */
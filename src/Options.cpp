@@ -7,10 +7,16 @@ using namespace std;
 Options::Options() : opt_version(RAXML_OPT_VERSION), cmdline(""), command(Command::none),
 use_tip_inner(true), use_pattern_compression(true), use_prob_msa(false), use_rate_scalers(false),
 use_repeats(true), use_rba_partload(true), use_energy_monitor(true), use_old_constraint(false),
-use_spr_fastclv(true), use_bs_pars(true), use_par_pars(true),
+use_spr_fastclv(true), use_bs_pars(true), use_par_pars(true), use_split_modopt(false),
+use_joint_alpha_pinv(false), use_adaptive_modopt(false), use_tip_lookup(false),
+use_shared_msa(false), use_hier_reduce(true), use_pipeline(true), use_async_bootstop(true),
 optimize_model(true), optimize_brlen(true), force_mode(false), safety_checks(SafetyCheck::all),
 redo_mode(false), nofiles_mode(false), write_interim_results(true), write_bs_msa(false),
-log_level(LogLevel::progress), msa_format(FileFormat::autodetect), data_type(DataType::autodetect),
+log_level(LogLevel::progress), msa_format(FileFormat::autodetect), tree_format(TreeFormat::newick),
+tree_brlen_format(TreeBrlenFormat::full), bsmsa_format(FileFormat::phylip),
+asr_prob_format(AncestralProbFormat::text), asr_block_size(0), asr_nodes(),
+profile_format(ProfileFormat::none),
+data_type(DataType::autodetect),
 random_seed(0), start_trees(), lh_epsilon(DEF_LH_EPSILON), lh_epsilon_brlen_triplet(DEF_LH_EPSILON_BRLEN_TRIPLET),
 spr_radius(-1), spr_cutoff(1.0),
 brlen_linkage(PLLMOD_COMMON_BRLEN_SCALED), brlen_opt_method(PLLMOD_OPT_BLO_NEWTON_FAST),
@@ -18,6 +24,7 @@ brlen_min(RAXML_BRLEN_MIN), brlen_max(RAXML_BRLEN_MAX),
 num_searches(1), terrace_maxsize(100),
 num_bootstraps(1000), bootstop_criterion(BootstopCriterion::none), bootstop_cutoff(0.03),
 bootstop_interval(RAXML_BOOTSTOP_INTERVAL), bootstop_permutations(RAXML_BOOTSTOP_PERMUTES),
+budget_seconds(0.), budget_wh(0.),
 tbe_naive(false), consense_cutoff(ConsenseCutoff::MR), tree_file(""), constraint_tree_file(""),
 msa_file(""), model_file(""), weights_file(""), outfile_prefix(""),
 num_threads(1), num_threads_max(1), num_ranks(1), num_workers(1), num_workers_max(UINT_MAX),
@@ -47,8 +54,16 @@ void Options::set_default_outfiles()
   set_default_outfile(outfile_names.best_tree_collapsed, "bestTreeCollapsed");
   set_default_outfile(outfile_names.best_model, "bestModel");
   set_default_outfile(outfile_names.partition_trees, "bestPartitionTrees");
-  set_default_outfile(outfile_names.ml_trees, "mlTrees");
-  set_default_outfile(outfile_names.bootstrap_trees, "bootstraps");
+  if (tree_format == TreeFormat::binary)
+  {
+    set_default_outfile(outfile_names.ml_trees, "mlTrees.rbt");
+    set_default_outfile(outfile_names.bootstrap_trees, "bootstraps.rbt");
+  }
+  else
+  {
+    set_default_outfile(outfile_names.ml_trees, "mlTrees");
+    set_default_outfile(outfile_names.bootstrap_trees, "bootstraps");
+  }
   set_default_outfile(outfile_names.support_tree, "support");
   set_default_outfile(outfile_names.fbp_support_tree, "supportFBP");
   set_default_outfile(outfile_names.tbe_support_tree, "supportTBE");
@@ -61,6 +76,7 @@ void Options::set_default_outfiles()
   set_default_outfile(outfile_names.asr_probs, "ancestralProbs");
   set_default_outfile(outfile_names.asr_states, "ancestralStates");
   set_default_outfile(outfile_names.site_loglh, "siteLH");
+  set_default_outfile(outfile_names.profile, "profile");
   set_default_outfile(outfile_names.tmp_best_tree, "lastTree.TMP");
   set_default_outfile(outfile_names.tmp_ml_trees, "mlTrees.TMP");
   set_default_outfile(outfile_names.tmp_bs_trees, "bootstraps.TMP");
@@ -74,6 +90,17 @@ std::string Options::checkp_file() const
     return outfile_names.checkpoint;
 }
 
+std::string Options::profile_file() const
+{
+  if (outfile_names.profile.empty())
+    return "";
+
+  auto fname = outfile_names.profile;
+  if (ParallelContext::num_ranks() > 1)
+    fname += "." + to_string(ParallelContext::rank_id());
+
+  return fname + (profile_format == ProfileFormat::csv ? ".csv" : ".json");
+}
 
 const std::string& Options::support_tree_file(BranchSupportMetric bsm) const
 {
@@ -92,8 +119,9 @@ const std::string& Options::support_tree_file(BranchSupportMetric bsm) const
 
 std::string Options::bootstrap_msa_file(size_t bsnum) const
 {
+  auto ext = (bsmsa_format == FileFormat::binary) ? ".rba" : ".phy";
   return outfile_names.bootstrap_msa.empty() ? "" :
-             outfile_names.bootstrap_msa + "." + to_string(bsnum) + ".phy";
+             outfile_names.bootstrap_msa + "." + to_string(bsnum) + ext;
 }
 
 std::string Options::bootstrap_partition_file() const
@@ -405,6 +433,68 @@ std::ostream& operator<<(std::ostream& stream, const Options& opts)
 
   stream << "  random seed: " << opts.random_seed << endl;
 
+  if (opts.tree_format == TreeFormat::binary &&
+      (opts.command == Command::search || opts.command == Command::all ||
+       opts.command == Command::bootstrap))
+  {
+    stream << "  tree output format: binary (branch lengths: ";
+    switch(opts.tree_brlen_format)
+    {
+      case TreeBrlenFormat::none:
+        stream << "none";
+        break;
+      case TreeBrlenFormat::quant16:
+        stream << "16-bit quantized, lossy";
+        break;
+      case TreeBrlenFormat::float32:
+        stream << "float";
+        break;
+      case TreeBrlenFormat::full:
+        stream << "double";
+        break;
+    }
+    stream << ")" << endl;
+  }
+
+  if (opts.command == Command::ancestral)
+  {
+    stream << "  ancestral probabilities: ";
+    switch(opts.asr_prob_format)
+    {
+      case AncestralProbFormat::text:
+        stream << "text";
+        break;
+      case AncestralProbFormat::float32:
+        stream << "binary (float)";
+        break;
+      case AncestralProbFormat::uint8:
+        stream << "binary (8-bit quantized)";
+        break;
+    }
+    if (opts.asr_block_size > 0)
+      stream << ", streaming (" << opts.asr_block_size << " nodes per block)";
+    stream << endl;
+
+    if (!opts.asr_nodes.empty())
+      stream << "  ancestral nodes: " << opts.asr_nodes.size() << " selected" << endl;
+  }
+
+  if (opts.budget_seconds > 0. || opts.budget_wh > 0.)
+  {
+    stream << "  run budget: ";
+    if (opts.budget_seconds > 0.)
+      stream << opts.budget_seconds << " s" << (opts.budget_wh > 0. ? ", " : "");
+    if (opts.budget_wh > 0.)
+      stream << opts.budget_wh << " Wh";
+    stream << endl;
+  }
+
+  if (opts.profile_format != ProfileFormat::none)
+  {
+    stream << "  search profiling: " <<
+        (opts.profile_format == ProfileFormat::csv ? "CSV" : "JSON") << endl;
+  }
+
   if (opts.command == Command::bootstrap || opts.command == Command::all ||
       opts.command == Command::search || opts.command == Command::evaluate ||
       opts.command == Command::parse || opts.command == Command::ancestral)
@@ -413,12 +503,24 @@ std::ostream& operator<<(std::ostream& stream, const Options& opts)
     stream << "  pattern compression: " << (opts.use_pattern_compression ? "ON" : "OFF") << endl;
     stream << "  per-rate scalers: " << (opts.use_rate_scalers ? "ON" : "OFF") << endl;
     stream << "  site repeats: " << (opts.use_repeats ? "ON" : "OFF") << endl;
+    if (opts.use_repeats && opts.use_tip_lookup)
+      stream << "  tip-inner lookup (binary/multistate): ON" << endl;
 
     stream << "  logLH epsilon: " ;
     stream << "general: " << opts.lh_epsilon << ", ";
     stream << "brlen-triplet: " << opts.lh_epsilon_brlen_triplet;
     stream << endl;
 
+    if (opts.use_split_modopt)
+      stream << "  model optimization: split partitions across threads" << endl;
+
+    if (opts.use_joint_alpha_pinv)
+      stream << "  alpha/p-inv optimization: JOINT" << endl;
+
+    if (opts.use_adaptive_modopt && (opts.command == Command::search ||
+        opts.command == Command::all || opts.command == Command::bootstrap))
+      stream << "  model optimization schedule: ADAPTIVE" << endl;
+
     if (opts.command == Command::search || opts.command == Command::all ||
         opts.command == Command::bootstrap)
     {
@@ -500,6 +602,8 @@ std::ostream& operator<<(std::ostream& stream, const Options& opts)
 
   if (opts.num_threads > 1)
     stream << ", thread pinning: " << (opts.thread_pinning ? "ON" : "OFF");
+  if (opts.num_ranks > 1 && opts.use_shared_msa)
+    stream << ", node-shared MSA";
   stream << endl;
 
   stream << endl;
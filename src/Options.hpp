@@ -5,7 +5,7 @@
 #include "PartitionedMSA.hpp"
 #include "util/SafetyCheck.hpp"
 
-constexpr int RAXML_OPT_VERSION = 2;
+constexpr int RAXML_OPT_VERSION = 3;
 
 struct OutputFileNames
 {
@@ -30,6 +30,7 @@ struct OutputFileNames
   std::string asr_tree;
   std::string asr_probs;
   std::string asr_states;
+  std::string profile;
   std::string tmp_best_tree;
   std::string tmp_ml_trees;
   std::string tmp_bs_trees;
@@ -62,6 +63,14 @@ public:
   bool use_spr_fastclv;
   bool use_bs_pars;
   bool use_par_pars;
+  bool use_split_modopt;
+  bool use_joint_alpha_pinv;
+  bool use_adaptive_modopt;
+  bool use_tip_lookup;
+  bool use_shared_msa;
+  bool use_hier_reduce;
+  bool use_pipeline;
+  bool use_async_bootstop;
 
   bool optimize_model;
   bool optimize_brlen;
@@ -76,6 +85,13 @@ public:
 
   LogLevel log_level;
   FileFormat msa_format;
+  TreeFormat tree_format;
+  TreeBrlenFormat tree_brlen_format;
+  FileFormat bsmsa_format;
+  AncestralProbFormat asr_prob_format;
+  size_t asr_block_size;
+  NameList asr_nodes;
+  ProfileFormat profile_format;
   DataType data_type;
   long random_seed;
   StartingTreeMap start_trees;
@@ -98,6 +114,9 @@ public:
   unsigned int bootstop_interval;
   unsigned int bootstop_permutations;
 
+  double budget_seconds;        /* wall-clock budget, 0 = unlimited */
+  double budget_wh;             /* energy budget, 0 = unlimited */
+
   LogElementMap precision;
   NameList outgroup_taxa;
 
@@ -152,6 +171,7 @@ public:
   const std::string asr_tree_file() const { return outfile_names.asr_tree; }
   const std::string asr_probs_file() const { return outfile_names.asr_probs; }
   const std::string asr_states_file() const { return outfile_names.asr_states; }
+  std::string profile_file() const;
 
   const std::string tmp_best_tree_file() const { return outfile_names.tmp_best_tree; }
   const std::string tmp_ml_trees_file() const { return outfile_names.tmp_ml_trees; }
@@ -1,8 +1,11 @@
+#include <limits>
+
 #include "ParallelContext.hpp"
 
 #include "Options.hpp"
 
 #include "util/EnergyMonitor.hpp"
+#include "util/Profiler.hpp"
 
 using namespace std;
 
@@ -16,10 +19,13 @@ size_t ParallelContext::_num_groups = 1;
 size_t ParallelContext::_rank_id = 0;
 size_t ParallelContext::_local_rank_id = 0;
 bool ParallelContext::_node_master_rank = true;
+bool ParallelContext::_hier_reduce = false;
 std::string ParallelContext::_node_name = "";
 thread_local size_t ParallelContext::_thread_id = 0;
 std::vector<ThreadType> ParallelContext::_threads;
 std::vector<char> ParallelContext::_parallel_buf;
+std::vector<unsigned int> ParallelContext::_pin_cpus;
+GroupCpuMap ParallelContext::_group_cpus;
 std::unordered_map<ThreadIDType, ParallelContext> ParallelContext::_thread_ctx_map;
 MutexType ParallelContext::mtx;
 
@@ -30,6 +36,10 @@ std::vector<ThreadGroup> ParallelContext::_thread_groups;
 
 #ifdef _RAXML_MPI
 MPI_Comm ParallelContext::_comm = MPI_COMM_WORLD;
+MPI_Comm ParallelContext::_node_comm = MPI_COMM_NULL;
+std::vector<MPI_Win> ParallelContext::_node_wins;
+MPI_Comm ParallelContext::_leader_comm = MPI_COMM_NULL;
+std::vector<MPI_Request> ParallelContext::_reduce_reqs;
 bool ParallelContext::_owns_comm = true;
 #endif
 
@@ -78,10 +88,21 @@ void ParallelContext::init_mpi(int argc, char * argv[], void * comm)
 #endif
 }
 
+#ifdef _RAXML_PTHREADS
+static void pin_thread(size_t core_id, pthread_t thread);
+#endif
+
 void ParallelContext::start_thread(size_t thread_id, size_t local_thread_id,
                                    ThreadGroup& thread_grp,
                                    const std::function<void()>& thread_main)
 {
+#ifdef _RAXML_PTHREADS
+  /* pin before thread_main() allocates anything, so that per-thread data (CLVs,
+   * p-matrices, scalers etc.) is first-touched on the NUMA node of this core */
+  if (!_pin_cpus.empty())
+    pin_thread(_pin_cpus[thread_id % _pin_cpus.size()], pthread_self());
+#endif
+
   ParallelContext::_thread_id = thread_id;
   ParallelContext::_local_thread_id = local_thread_id;
   ParallelContext::_thread_group = &thread_grp;
@@ -108,6 +129,20 @@ static void pin_thread(size_t core_id, pthread_t thread)
 }
 #endif
 
+/* helper threads (e.g. std::async) inherit the affinity of the pinned thread which started them */
+void ParallelContext::unpin_thread()
+{
+#if defined(_RAXML_PTHREADS) && defined(__linux__)
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (auto cpu_id: CpuTopology::process_cpus())
+    CPU_SET(cpu_id, &cpuset);
+  int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+  if (rc != 0)
+    std::cerr << "Error calling pthread_setaffinity_np: " << rc << "\n";
+#endif
+}
+
 void ParallelContext::init_pthreads(const Options& opts, const std::function<void()>& thread_main)
 {
   init_pthreads_custom(opts, thread_main, opts.num_threads, opts.num_workers);
@@ -118,6 +153,10 @@ void ParallelContext::init_pthreads_custom(const Options& opts, const std::funct
 {
   _num_threads = num_threads;
   _num_groups = std::max(num_workers, 1u);
+
+  /* two-level reduction only pays off with multiple ranks on multiple nodes */
+  _hier_reduce = opts.use_hier_reduce && _num_nodes > 1 && _num_ranks > _num_nodes &&
+                 _num_ranks > _num_groups;
   _parallel_buf.reserve(PARALLEL_BUF_SIZE);
 
   _local_rank_id = _num_ranks > _num_groups ? _rank_id : 0;
@@ -133,6 +172,20 @@ void ParallelContext::init_pthreads_custom(const Options& opts, const std::funct
   assert(!_thread_groups.empty());
 
 #ifdef _RAXML_PTHREADS
+  _pin_cpus.clear();
+  _group_cpus.clear();
+  if (opts.thread_pinning && _num_threads > 1)
+  {
+    /* every thread group gets a compact set of cores sharing L3 cache / NUMA node */
+    std::vector<size_t> group_sizes;
+    for (const auto& grp: _thread_groups)
+      group_sizes.push_back(grp.num_threads);
+
+    _group_cpus = CpuTopology().place_groups(group_sizes);
+    for (const auto& cpus: _group_cpus)
+      _pin_cpus.insert(_pin_cpus.end(), cpus.cbegin(), cpus.cend());
+  }
+
   /* Launch/init threads */
   auto grp = _thread_groups.begin();
   for (size_t i = 0, local_id = 0; i < _num_threads; ++i, ++local_id)
@@ -151,13 +204,11 @@ void ParallelContext::init_pthreads_custom(const Options& opts, const std::funct
     }
     else
       _threads.emplace_back(ParallelContext::start_thread, i, local_id, std::ref(*grp), thread_main);
-
-    if (opts.thread_pinning && _num_threads > 1)
-    {
-      auto handle = i > 0 ? _threads.back().native_handle() : pthread_self();
-      pin_thread(i, handle);
-    }
   }
+
+  /* worker threads pin themselves in start_thread() */
+  if (!_pin_cpus.empty())
+    pin_thread(_pin_cpus[0], pthread_self());
 #else
   _local_thread_id = 0;
   _thread_group = &(*_thread_groups.begin());
@@ -193,7 +244,7 @@ void ParallelContext::detect_num_nodes()
         {
           assert((size_t) len < buf_size);
           memcpy(buf, name, (len+1) * sizeof(char));
-          return len;
+          return len+1;
         };
 
     /* receive callback -> master rank: collect host names */
@@ -234,11 +285,89 @@ void ParallelContext::detect_num_nodes()
 #endif
 }
 
+#ifdef _RAXML_MPI
+void ParallelContext::init_node_comms()
+{
+  if (_node_comm != MPI_COMM_NULL)
+    return;
+
+  /* rank order is preserved -> node-local rank 0 is the node master rank */
+  MPI_Comm_split_type(_comm, MPI_COMM_TYPE_SHARED, (int) _rank_id, MPI_INFO_NULL, &_node_comm);
+
+  /* communicator with one "leader" rank per node */
+  int node_rank;
+  MPI_Comm_rank(_node_comm, &node_rank);
+  MPI_Comm_split(_comm, node_rank == 0 ? 0 : MPI_UNDEFINED, (int) _rank_id, &_leader_comm);
+}
+#endif
+
+char * ParallelContext::alloc_node_shared(size_t size)
+{
+#ifdef _RAXML_MPI
+  init_node_comms();
+
+  int node_rank;
+  MPI_Comm_rank(_node_comm, &node_rank);
+
+  MPI_Win win;
+  char * base = nullptr;
+  MPI_Aint local_size = (node_rank == 0) ? (MPI_Aint) size : 0;
+  int ret = MPI_Win_allocate_shared(local_size, 1, MPI_INFO_NULL, _node_comm, &base, &win);
+  if (ret != MPI_SUCCESS)
+  {
+    throw runtime_error("Failed to allocate node-local shared memory segment of size " +
+                        to_string(size));
+  }
+
+  /* get local address of the segment owned by the node master */
+  MPI_Aint seg_size;
+  int disp_unit;
+  MPI_Win_shared_query(win, 0, &seg_size, &disp_unit, &base);
+  assert((size_t) seg_size == size);
+
+  _node_wins.push_back(win);
+
+  return base;
+#else
+  RAXML_UNUSED(size);
+  throw runtime_error("Node-local shared memory is only available in MPI mode!");
+#endif
+}
+
+void ParallelContext::node_shared_sync()
+{
+#ifdef _RAXML_MPI
+  for (auto win: _node_wins)
+    MPI_Win_fence(0, win);
+#endif
+}
+
 void ParallelContext::resize_buffers(size_t reduce_buf_size, size_t worker_buf_size)
 {
   _parallel_buf.reserve(worker_buf_size);
   for (auto& grp: _thread_groups)
-    grp.reduction_buf.reserve(reduce_buf_size);
+  {
+    /* buffer content is transient: reallocate without touching the pages,
+     * they are initialized by the group master in touch_group_buffers() */
+    if (grp.reduction_buf.capacity() < reduce_buf_size)
+    {
+      std::vector<char>().swap(grp.reduction_buf);
+      grp.reduction_buf.reserve(reduce_buf_size);
+    }
+  }
+}
+
+/* must be called by all threads of a group after resize_buffers(): the (pinned) group master
+ * writes the reduction buffer first, so that its pages are placed on the group's NUMA node */
+void ParallelContext::touch_group_buffers()
+{
+  if (_local_thread_id == 0)
+  {
+    auto& buf = _thread_group->reduction_buf;
+    buf.resize(buf.capacity());
+  }
+
+  thread_barrier();
 }
 
 void ParallelContext::finalize_threads(bool force)
@@ -261,6 +390,19 @@ void ParallelContext::finalize_threads(bool force)
 void ParallelContext::finalize_mpi(bool force)
 {
 #ifdef _RAXML_MPI
+  if (!force)
+  {
+    for (auto& win: _node_wins)
+      MPI_Win_free(&win);
+    _node_wins.clear();
+
+    if (_leader_comm != MPI_COMM_NULL)
+      MPI_Comm_free(&_leader_comm);
+
+    if (_node_comm != MPI_COMM_NULL)
+      MPI_Comm_free(&_node_comm);
+  }
+
   if (_owns_comm)
   {
     if (force)
@@ -352,6 +494,8 @@ void ParallelContext::thread_barrier()
   if (g.num_threads == 1)
     return;
 
+  ProfileScope prof(ProfileEvent::barrier);
+
   __sync_fetch_and_add(&g.barrier_counter, 1);
 
   if(_local_thread_id == 0)
@@ -368,7 +512,7 @@ void ParallelContext::thread_barrier()
 }
 
 
-void ParallelContext::thread_reduce(double * data, size_t size, int op)
+void ParallelContext::thread_reduce(double * data, size_t size, int op, bool master_only)
 {
   /* synchronize */
   thread_barrier();
@@ -384,6 +528,10 @@ void ParallelContext::thread_reduce(double * data, size_t size, int op)
   /* synchronize */
   thread_barrier();
 
+  /* if result is broadcasted later anyway, only group master needs to reduce */
+  if (master_only && _local_thread_id != 0)
+    return;
+
   /* reduce */
   for (i = 0; i < size; ++i)
   {
@@ -414,20 +562,28 @@ void ParallelContext::thread_reduce(double * data, size_t size, int op)
   }
 }
 
+#ifdef _RAXML_MPI
+static MPI_Op mpi_reduce_op(int op)
+{
+  if (op == PLLMOD_COMMON_REDUCE_SUM)
+    return MPI_SUM;
+  else if (op == PLLMOD_COMMON_REDUCE_MAX)
+    return MPI_MAX;
+  else if (op == PLLMOD_COMMON_REDUCE_MIN)
+    return MPI_MIN;
+  else
+    assert(0);
+
+  return MPI_OP_NULL;
+}
+#endif
+
 void ParallelContext::mpi_reduce(double * data, size_t size, int op)
 {
 #ifdef _RAXML_MPI
   if (_num_ranks > 1)
   {
-      MPI_Op reduce_op;
-      if (op == PLLMOD_COMMON_REDUCE_SUM)
-        reduce_op = MPI_SUM;
-      else if (op == PLLMOD_COMMON_REDUCE_MAX)
-        reduce_op = MPI_MAX;
-      else if (op == PLLMOD_COMMON_REDUCE_MIN)
-        reduce_op = MPI_MIN;
-      else
-        assert(0);
+      MPI_Op reduce_op = mpi_reduce_op(op);
 
       MPI_Reduce(data, _parallel_buf.data(), size, MPI_DOUBLE, reduce_op, 0, _comm);
       memcpy(data, _parallel_buf.data(), size * sizeof(double));
@@ -450,9 +606,17 @@ void ParallelContext::parallel_reduce_cb(void * context, double * data, size_t s
 
 void ParallelContext::parallel_reduce(double * data, size_t size, int op)
 {
+  ProfileScope prof(ProfileEvent::reduction);
+
+#ifdef _RAXML_MPI
+  const bool use_mpi = _num_ranks > _num_groups;
+#else
+  const bool use_mpi = false;
+#endif
+
 #ifdef _RAXML_PTHREADS
   if (_thread_group->num_threads > 1)
-    thread_reduce(data, size, op);
+    thread_reduce(data, size, op, use_mpi);
 #endif
 
 #ifdef _RAXML_MPI
@@ -464,46 +628,128 @@ void ParallelContext::parallel_reduce(double * data, size_t size, int op)
   RAXML_UNUSED(size);
   RAXML_UNUSED(op);
 #endif
+  RAXML_UNUSED(use_mpi);
 }
 
+/* NOTE: in multithreaded mode, data must be reduced on group master thread beforehand */
 void ParallelContext::mpi_allreduce(double * data, size_t size, int op)
 {
 #ifdef _RAXML_MPI
   if (_num_ranks > _num_groups)
   {
-    thread_barrier();
-
-    if (_thread_id == 0)
+    if (_local_thread_id == 0)
     {
-      MPI_Op reduce_op;
-      if (op == PLLMOD_COMMON_REDUCE_SUM)
-        reduce_op = MPI_SUM;
-      else if (op == PLLMOD_COMMON_REDUCE_MAX)
-        reduce_op = MPI_MAX;
-      else if (op == PLLMOD_COMMON_REDUCE_MIN)
-        reduce_op = MPI_MIN;
+      MPI_Op reduce_op = mpi_reduce_op(op);
+
+      if (_hier_reduce)
+      {
+        /* reduce within node -> allreduce between node leaders -> broadcast within node */
+        init_node_comms();
+
+        int node_rank;
+        MPI_Comm_rank(_node_comm, &node_rank);
+
+        if (node_rank == 0)
+        {
+          MPI_Reduce(MPI_IN_PLACE, data, size, MPI_DOUBLE, reduce_op, 0, _node_comm);
+          MPI_Allreduce(MPI_IN_PLACE, data, size, MPI_DOUBLE, reduce_op, _leader_comm);
+        }
+        else
+          MPI_Reduce(data, nullptr, size, MPI_DOUBLE, reduce_op, 0, _node_comm);
+
+        MPI_Bcast(data, size, MPI_DOUBLE, 0, _node_comm);
+      }
       else
-        assert(0);
+        MPI_Allreduce(MPI_IN_PLACE, data, size, MPI_DOUBLE, reduce_op, _comm);
+    }
 
-#if 1
-      MPI_Allreduce(MPI_IN_PLACE, data, size, MPI_DOUBLE, reduce_op, _comm);
+    if (_thread_group->num_threads > 1)
+      group_broadcast(data, size);
+  }
 #else
-      // not sure if MPI_IN_PLACE will work in all cases...
-      MPI_Allreduce(data, _parallel_buf.data(), size, MPI_DOUBLE, reduce_op, _comm);
-      memcpy(data, _parallel_buf.data(), size * sizeof(double));
+  RAXML_UNUSED(data);
+  RAXML_UNUSED(size);
+  RAXML_UNUSED(op);
+#endif
+}
+
+void ParallelContext::parallel_reduce_start(double * data, size_t size, int op)
+{
+  ProfileScope prof(ProfileEvent::reduction);
+
+#ifdef _RAXML_MPI
+  const bool use_mpi = _num_ranks > _num_groups;
+#else
+  const bool use_mpi = false;
+#endif
+
+#ifdef _RAXML_PTHREADS
+  if (_thread_group->num_threads > 1)
+    thread_reduce(data, size, op, use_mpi);
+#endif
+
+#ifdef _RAXML_MPI
+  if (use_mpi && _local_thread_id == 0)
+  {
+    MPI_Request req;
+    MPI_Iallreduce(MPI_IN_PLACE, data, size, MPI_DOUBLE, mpi_reduce_op(op), _comm, &req);
+    _reduce_reqs.push_back(req);
+  }
+#endif
+
+#if !defined(_RAXML_PTHREADS) && !defined(_RAXML_MPI)
+  RAXML_UNUSED(data);
+  RAXML_UNUSED(size);
+  RAXML_UNUSED(op);
 #endif
+  RAXML_UNUSED(use_mpi);
+}
+
+void ParallelContext::parallel_reduce_wait(double * data, size_t size)
+{
+#ifdef _RAXML_MPI
+  if (_num_ranks > _num_groups)
+  {
+    ProfileScope prof(ProfileEvent::reduction);
+
+    /* requests are completed in the order they were started */
+    if (_local_thread_id == 0)
+    {
+      assert(!_reduce_reqs.empty());
+      MPI_Wait(&_reduce_reqs.front(), MPI_STATUS_IGNORE);
+      _reduce_reqs.erase(_reduce_reqs.begin());
     }
 
+    /* other threads might still be reading reduction buffer from the previous call */
     if (_thread_group->num_threads > 1)
-      thread_broadcast(0, data, size * sizeof(double));
+    {
+      thread_barrier();
+      group_broadcast(data, size);
+    }
   }
 #else
   RAXML_UNUSED(data);
   RAXML_UNUSED(size);
-  RAXML_UNUSED(op);
 #endif
 }
 
+/* broadcast from group master thread to all threads of the same group,
+ * NOTE: caller must ensure that reduction buffer is not in use anymore */
+void ParallelContext::group_broadcast(double * data, size_t size)
+{
+  double * double_buf = (double*) _thread_group->reduction_buf.data();
+
+  if (_local_thread_id == 0)
+    memcpy(double_buf, data, size * sizeof(double));
+
+  __sync_synchronize();
+
+  thread_barrier();
+
+  if (_local_thread_id != 0)
+    memcpy(data, double_buf, size * sizeof(double));
+}
+
 void ParallelContext::thread_broadcast(size_t source_id, void * data, size_t size)
 {
   /* write to buf */
@@ -573,34 +819,47 @@ void ParallelContext::mpi_gather_custom(std::function<size_t(void*,size_t)> prep
                                         std::function<void(void*,size_t, size_t)> process_recv_cb)
 {
 #ifdef _RAXML_MPI
-  /* we're gonna use _parallel_buf, so make sure other threads don't interfere... */
+  /* collective calls must be issued in the same order on all ranks -> serialize local threads */
   UniqueLock lock;
 
+  /* serialize local data on worker ranks */
+  vector<char> send_buf;
+  int send_size = 0;
+  if (_rank_id > 0)
+  {
+    send_buf.resize(_parallel_buf.capacity());
+    send_size = (int) prepare_send_cb(send_buf.data(), send_buf.size());
+  }
+
+  /* exchange message sizes */
+  vector<int> recv_sizes(_rank_id == 0 ? _num_ranks : 0);
+  MPI_Gather(&send_size, 1, MPI_INT, recv_sizes.data(), 1, MPI_INT, 0, _comm);
+
+  /* collect all messages in a single pre-sized buffer */
+  vector<int> displs(recv_sizes.size(), 0);
+  vector<char> recv_buf;
   if (_rank_id == 0)
   {
-    for (size_t r = 1; r < _num_ranks; ++r)
+    size_t total_size = 0;
+    for (size_t r = 0; r < _num_ranks; ++r)
     {
-      int recv_size;
-      MPI_Status status;
-      MPI_Probe(r, 0, _comm, &status);
-      MPI_Get_count(&status, MPI_BYTE, &recv_size);
+      displs[r] = (int) total_size;
+      total_size += recv_sizes[r];
+    }
 
-//      printf("recv: %lu\n", recv_size);
+    if (total_size > (size_t) std::numeric_limits<int>::max())
+      throw runtime_error("MPI gather: message size limit exceeded!");
 
-      _parallel_buf.reserve(recv_size);
+    recv_buf.resize(total_size);
+  }
 
-      MPI_Recv((void*) _parallel_buf.data(), recv_size, MPI_BYTE,
-               r, 0, _comm, MPI_STATUS_IGNORE);
+  MPI_Gatherv(send_buf.data(), send_size, MPI_BYTE, recv_buf.data(), recv_sizes.data(),
+              displs.data(), MPI_BYTE, 0, _comm);
 
-      process_recv_cb(_parallel_buf.data(), (size_t) recv_size, r);
-    }
-  }
-  else
+  if (_rank_id == 0)
   {
-    auto send_size = prepare_send_cb(_parallel_buf.data(), _parallel_buf.capacity());
-//    printf("sent: %lu\n", send_size);
-
-    MPI_Send(_parallel_buf.data(), send_size, MPI_BYTE, 0, 0, _comm);
+    for (size_t r = 1; r < _num_ranks; ++r)
+      process_recv_cb(recv_buf.data() + displs[r], (size_t) recv_sizes[r], r);
   }
 #else
   RAXML_UNUSED(prepare_send_cb);
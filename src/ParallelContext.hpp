@@ -9,6 +9,7 @@
 #include <functional>
 
 #include "io/BinaryStream.hpp"
+#include "util/CpuTopology.hpp"
 
 
 #ifdef _RAXML_MPI
@@ -60,6 +61,8 @@ public:
   static void init_pthreads_custom(const Options& opts, const std::function<void()>& thread_main,
                                    unsigned int num_threads, unsigned int num_workers);
   static void resize_buffers(size_t reduce_buf_size, size_t worker_buf_size = 0);
+  static void touch_group_buffers();
+  static void unpin_thread();
 
   static void finalize_threads(bool force = false);
   static void finalize_mpi(bool force = false);
@@ -71,6 +74,7 @@ public:
   static size_t num_nodes() { return _num_nodes; }
   static size_t num_groups() { return _num_groups; }
   static size_t num_local_groups() { return _thread_groups.size(); }
+  static const GroupCpuMap& group_cpus() { return _group_cpus; }
   static size_t ranks_per_node() { return _num_ranks / _num_nodes; }
   static size_t threads_per_group() { return num_procs() / _num_groups; }
   static size_t ranks_per_group() { return _num_ranks / _num_groups; }
@@ -80,7 +84,14 @@ public:
   static void mpi_allreduce(double * data, size_t size, int op);
   static void parallel_reduce_cb(void * context, double * data, size_t size, int op);
   static void parallel_reduce(double * data, size_t size, int op);
-  static void thread_reduce(double * data, size_t size, int op);
+  static void thread_reduce(double * data, size_t size, int op, bool master_only = false);
+
+  /* non-blocking version of parallel_reduce(): reduction across MPI ranks may overlap
+   * with other computations/reductions, result in data is only valid after
+   * parallel_reduce_wait(). Both calls are collective and must be issued in the same order
+   * by all threads; data must not be modified in between */
+  static void parallel_reduce_start(double * data, size_t size, int op);
+  static void parallel_reduce_wait(double * data, size_t size);
   static void thread_broadcast(size_t source_id, void * data, size_t size);
   void thread_send_master(size_t source_id, void * data, size_t size) const;
 
@@ -103,6 +114,13 @@ public:
 
   static void global_master_broadcast(void * data, size_t size);
 
+  /* node-local shared memory (MPI-3 shared window): the segment is owned by the node
+   * master rank and mapped by all other ranks on the same node. Both calls are
+   * collective over all MPI ranks; node_shared_sync() must be called after the node
+   * master has filled the segment and before other ranks start reading it */
+  static char * alloc_node_shared(size_t size);
+  static void node_shared_sync();
+
   static void mpi_gather_custom(std::function<size_t(void*,size_t)> prepare_send_cb,
                                 std::function<void(void*,size_t,size_t)> process_recv_cb);
 
@@ -167,6 +185,8 @@ private:
   static size_t _num_nodes;
   static size_t _num_groups;
   static std::vector<char> _parallel_buf;
+  static std::vector<unsigned int> _pin_cpus;       /* per thread */
+  static GroupCpuMap _group_cpus;
   static std::unordered_map<ThreadIDType, ParallelContext> _thread_ctx_map;
   static MutexType mtx;
 
@@ -184,8 +204,18 @@ private:
 #ifdef _RAXML_MPI
   static bool _owns_comm;
   static MPI_Comm _comm;
+  static MPI_Comm _node_comm;
+  static std::vector<MPI_Win> _node_wins;
+  static MPI_Comm _leader_comm;
+  static std::vector<MPI_Request> _reduce_reqs;
+
+  static void init_node_comms();
 #endif
 
+  static bool _hier_reduce;
+
+  static void group_broadcast(double * data, size_t size);
+
   static void start_thread(size_t thread_id, size_t local_thread_id,
                            ThreadGroup& thread_grp,
                            const std::function<void()>& thread_main);
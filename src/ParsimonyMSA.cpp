@@ -55,12 +55,12 @@ void ParsimonyMSA::init_pars_msa(std::shared_ptr<PartitionedMSA> orig_msa)
         if (pinfo.model().data_type_name() != pars_datatype)
           continue;
 
-        const auto w = pinfo.msa().weights();
-        const auto s = pinfo.msa().at(j);
+        const auto& w = pinfo.msa().weights();
+        const auto s = pinfo.msa().sequence_data(j);
 
         if (w.empty())
         {
-          for (size_t k = 0; k < s.size(); ++k)
+          for (size_t k = 0; k < pinfo.msa().length(); ++k)
             sequence[offset++] = s[k];
         }
         else
@@ -117,7 +117,7 @@ void ParsimonyMSA::create_pll_partitions(unsigned int attributes)
     /* set tip states */
     for (size_t j = 0; j < msa.size(); ++j)
     {
-      pll_set_tip_states(partition, j, model.charmap(), msa.at(j).c_str());
+      pll_set_tip_states(partition, j, model.charmap(), msa.sequence_data(j));
     }
 
     _pll_partitions.push_back(partition);
@@ -189,6 +189,17 @@ void PartitionedMSA::split_msa()
   }
 }
 
+void PartitionedMSA::release_full_msa()
+{
+  /* after split_msa(), all data is held by the partitions: only the site->partition map
+   * is derived from the full MSA, so compute it before dropping the copy */
+  if (_full_msa.empty())
+    return;
+
+  site_part_map();
+  _full_msa = MSA();
+}
+
 void PartitionedMSA::compress_patterns(bool store_backmap)
 {
   for (PartitionInfo& pinfo: _part_list)
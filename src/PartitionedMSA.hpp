@@ -59,6 +59,7 @@ public:
   }
 
   void split_msa();
+  void release_full_msa();
   void compress_patterns(bool store_backmap = false);
   void set_model_empirical_params();
 
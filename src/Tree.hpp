@@ -178,6 +178,7 @@ public:
 
   void clear() { _trees.clear(); };
   void insert(size_t index, const ScoredTopology& t) { _trees[index] = t; };
+  void erase(size_t index) { _trees.erase(index); };
 
 private:
   container_type _trees;
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <set>
 
 #include "TreeInfo.hpp"
 #include "ParallelContext.hpp"
@@ -20,6 +21,26 @@ TreeInfo::TreeInfo (const Options &opts, const Tree& tree, const PartitionedMSA&
   init(opts, tree, parted_msa, tip_msa_idmap, part_assign, site_weights);
 }
 
+/* bootstrap replicate weights cover the whole partition, while the MSA might only hold
+ * some segments of it (RBA partial loading) -> pick the weights of these segments */
+static uintVector local_site_weights(const MSA& msa, const uintVector& weights)
+{
+  const auto& ranges = msa.local_seq_ranges();
+  if (ranges.empty())
+    return weights;
+
+  uintVector local_weights;
+  local_weights.reserve(msa.length());
+  for (const auto& r: ranges)
+  {
+    assert(r.start + r.length <= weights.size());
+    local_weights.insert(local_weights.end(), weights.cbegin() + r.start,
+                         weights.cbegin() + r.start + r.length);
+  }
+
+  return local_weights;
+}
+
 void TreeInfo::init(const Options &opts, const Tree& tree, const PartitionedMSA& parted_msa,
                     const IDVector& tip_msa_idmap,
                     const PartitionAssignment& part_assign,
@@ -31,6 +52,12 @@ void TreeInfo::init(const Options &opts, const Tree& tree, const PartitionedMSA&
   _check_lh_impr = opts.safety_checks.isset(SafetyCheck::model_lh_impr);
   _use_old_constraint = opts.use_old_constraint;
   _use_spr_fastclv = opts.use_spr_fastclv;
+  _brlen_linkage = opts.brlen_linkage;
+  _split_parts_init = false;
+  _use_joint_alpha_pinv = opts.use_joint_alpha_pinv;
+  _alpha_pinv.reset();
+  _num_loglh_evals = 0;
+  _param_gains.assign(RAXML_MODOPT_PARAM_SLOTS, 0.);
 
   _partition_contributions.resize(parted_msa.part_count());
   double total_weight = 0;
@@ -42,8 +69,9 @@ void TreeInfo::init(const Options &opts, const Tree& tree, const PartitionedMSA&
   libpll_check_error("ERROR creating treeinfo structure");
   assert(_pll_treeinfo);
 
-  pllmod_treeinfo_set_parallel_context(_pll_treeinfo, (void *) nullptr,
-                                       ParallelContext::parallel_reduce_cb);
+  pllmod_treeinfo_set_parallel_context(_pll_treeinfo, (void *) this, TreeInfo::reduce_cb);
+
+  _gamma_modes.resize(parted_msa.part_count());
 
   // init partitions
   int optimize_branches = opts.optimize_brlen ? PLLMOD_OPT_PARAM_BRANCHES_ITERATIVE : 0;
@@ -55,6 +83,8 @@ void TreeInfo::init(const Options &opts, const Tree& tree, const PartitionedMSA&
     int params_to_optimize = opts.optimize_model ? pinfo.model().params_to_optimize() : 0;
     params_to_optimize |= optimize_branches;
 
+    _gamma_modes[p] = pinfo.model().gamma_mode();
+
     _partition_contributions[p] = std::accumulate(weights.begin(), weights.end(), 0);
     total_weight += _partition_contributions[p];
 
@@ -62,8 +92,9 @@ void TreeInfo::init(const Options &opts, const Tree& tree, const PartitionedMSA&
     if (part_range != part_assign.end())
     {
       /* create and init PLL partition structure */
-      pll_partition_t * partition = create_pll_partition(opts, pinfo, tip_msa_idmap,
-                                                         *part_range, weights);
+      pll_partition_t * partition = create_pll_partition(opts, pinfo, tip_msa_idmap, *part_range,
+                                                         site_weights.empty() ? weights :
+                                                           local_site_weights(pinfo.msa(), weights));
 
       int retval = pllmod_treeinfo_init_partition(_pll_treeinfo, p, partition,
                                                   params_to_optimize,
@@ -186,12 +217,14 @@ void TreeInfo::tree(const Tree& tree)
 
 double TreeInfo::loglh(bool incremental)
 {
+  ProfileScope prof(ProfileEvent::loglh);
   return pllmod_treeinfo_compute_loglh(_pll_treeinfo, incremental ? 1 : 0);
 }
 
 double TreeInfo::persite_loglh(std::vector<double*> part_site_lh, bool incremental)
 {
   assert(part_site_lh.size() == _pll_treeinfo->partition_count);
+  ProfileScope prof(ProfileEvent::loglh);
   return pllmod_treeinfo_compute_loglh_persite(_pll_treeinfo, incremental ? 1 : 0,
       part_site_lh.data());
 }
@@ -220,6 +253,7 @@ double TreeInfo::optimize_branches(double lh_epsilon, double brlen_smooth_factor
 
   if (_pll_treeinfo->params_to_optimize[0] & PLLMOD_OPT_PARAM_BRANCHES_ITERATIVE)
   {
+    ProfileScope prof(ProfileEvent::brlen_opt);
     int max_iters = brlen_smooth_factor * RAXML_BRLEN_SMOOTHINGS;
     new_loglh = -1 * pllmod_algo_opt_brlen_treeinfo(_pll_treeinfo,
                                                     _brlen_min,
@@ -240,6 +274,7 @@ double TreeInfo::optimize_branches(double lh_epsilon, double brlen_smooth_factor
   if (_pll_treeinfo->brlen_linkage == PLLMOD_COMMON_BRLEN_SCALED &&
       _pll_treeinfo->partition_count > 1)
   {
+    ProfileScope prof(ProfileEvent::brlen_scaler_opt);
     new_loglh = -1 * pllmod_algo_opt_brlen_scalers_treeinfo(_pll_treeinfo,
                                                             RAXML_BRLEN_SCALER_MIN,
                                                             RAXML_BRLEN_SCALER_MAX,
@@ -256,7 +291,7 @@ double TreeInfo::optimize_branches(double lh_epsilon, double brlen_smooth_factor
   return new_loglh;
 }
 
-double TreeInfo::optimize_params(int params_to_optimize, double lh_epsilon)
+double TreeInfo::optimize_params(int params_to_optimize, double lh_epsilon, bool split_parts)
 {
   assert(!pll_errno);
 
@@ -264,9 +299,35 @@ double TreeInfo::optimize_params(int params_to_optimize, double lh_epsilon)
     cur_loglh = loglh(),
     new_loglh = cur_loglh;
 
+  int model_params = params_to_optimize & ~PLLMOD_OPT_PARAM_BRANCHES_ITERATIVE;
+  if (model_params)
+  {
+    if (split_parts && ParallelContext::threads_per_group() > 1)
+      new_loglh = optimize_model_split(model_params, cur_loglh);
+    else
+      new_loglh = optimize_model_params(model_params, cur_loglh);
+    cur_loglh = new_loglh;
+  }
+
+  if (params_to_optimize & PLLMOD_OPT_PARAM_BRANCHES_ITERATIVE)
+  {
+    new_loglh = optimize_branches(lh_epsilon, 0.25);
+
+    assert_lh_improvement(cur_loglh, new_loglh, "BRLEN");
+    cur_loglh = new_loglh;
+  }
+
+  return new_loglh;
+}
+
+double TreeInfo::optimize_model_params(int params_to_optimize, double cur_loglh)
+{
+  double new_loglh = cur_loglh;
+
   /* optimize SUBSTITUTION RATES */
   if (params_to_optimize & PLLMOD_OPT_PARAM_SUBST_RATES)
   {
+    ProfileScope prof(ProfileEvent::subst_rates_opt);
     new_loglh = -1 * pllmod_algo_opt_subst_rates_treeinfo(_pll_treeinfo,
                                                           0,
                                                           PLLMOD_OPT_MIN_SUBST_RATE,
@@ -278,12 +339,14 @@ double TreeInfo::optimize_params(int params_to_optimize, double lh_epsilon)
 
     libpll_check_error("ERROR in substitution rates optimization");
     assert_lh_improvement(cur_loglh, new_loglh, "RATES");
+    add_param_gain(PLLMOD_OPT_PARAM_SUBST_RATES, new_loglh - cur_loglh);
     cur_loglh = new_loglh;
   }
 
   /* optimize BASE FREQS */
   if (params_to_optimize & PLLMOD_OPT_PARAM_FREQUENCIES)
   {
+    ProfileScope prof(ProfileEvent::freqs_opt);
     new_loglh = -1 * pllmod_algo_opt_frequencies_treeinfo(_pll_treeinfo,
                                                           0,
                                                           PLLMOD_OPT_MIN_FREQ,
@@ -295,60 +358,74 @@ double TreeInfo::optimize_params(int params_to_optimize, double lh_epsilon)
 
     libpll_check_error("ERROR in base frequencies optimization");
     assert_lh_improvement(cur_loglh, new_loglh, "FREQS");
+    add_param_gain(PLLMOD_OPT_PARAM_FREQUENCIES, new_loglh - cur_loglh);
     cur_loglh = new_loglh;
   }
 
-  // TODO: co-optimization of PINV and ALPHA, mb with multiple starting points
-  if (0 &&
-      (params_to_optimize & PLLMOD_OPT_PARAM_ALPHA) &&
-      (params_to_optimize & PLLMOD_OPT_PARAM_PINV))
+  const int alpha_pinv = PLLMOD_OPT_PARAM_ALPHA | PLLMOD_OPT_PARAM_PINV;
+  if (_use_joint_alpha_pinv && (params_to_optimize & alpha_pinv) == alpha_pinv)
   {
-    new_loglh = -1 * pllmod_algo_opt_alpha_pinv_treeinfo(_pll_treeinfo,
-                                                         0,
-                                                         PLLMOD_OPT_MIN_ALPHA,
-                                                         PLLMOD_OPT_MAX_ALPHA,
-                                                         PLLMOD_OPT_MIN_PINV,
-                                                         PLLMOD_OPT_MAX_PINV,
-                                                         RAXML_BFGS_FACTOR,
-                                                         RAXML_PARAM_EPSILON);
+    /* partitions with both ALPHA and PINV -> joint optimization, rest -> 1D */
+    const auto part_count = _pll_treeinfo->partition_count;
+    std::vector<int> orig_params(_pll_treeinfo->params_to_optimize,
+                                 _pll_treeinfo->params_to_optimize + part_count);
+    bool joint = false, onedim = false;
+    for (size_t p = 0; p < part_count; ++p)
+    {
+      auto pp = orig_params[p] & alpha_pinv;
+      if (pp == alpha_pinv)
+        joint = true;
+      else if (pp)
+        onedim = true;
+    }
 
-    LOG_DEBUG << "\t - after a+i  : logLH = " << new_loglh << endl;
+    if (joint)
+    {
+      for (size_t p = 0; p < part_count; ++p)
+      {
+        if ((orig_params[p] & alpha_pinv) != alpha_pinv)
+          _pll_treeinfo->params_to_optimize[p] &= ~alpha_pinv;
+      }
 
-    libpll_check_error("ERROR in alpha/p-inv parameter optimization");
-    assert_lh_improvement(cur_loglh, new_loglh, "ALPHA+PINV");
-    cur_loglh = new_loglh;
+      new_loglh = optimize_alpha_pinv(cur_loglh);
+      add_param_gain(alpha_pinv, new_loglh - cur_loglh);
+      cur_loglh = new_loglh;
+    }
+
+    if (onedim)
+    {
+      for (size_t p = 0; p < part_count; ++p)
+      {
+        _pll_treeinfo->params_to_optimize[p] = ((orig_params[p] & alpha_pinv) == alpha_pinv) ?
+                                               orig_params[p] & ~alpha_pinv : orig_params[p];
+      }
+
+      new_loglh = optimize_onedim(PLLMOD_OPT_PARAM_ALPHA, PLLMOD_OPT_MIN_ALPHA,
+                                  PLLMOD_OPT_MAX_ALPHA, cur_loglh, "alpha");
+      cur_loglh = new_loglh;
+
+      new_loglh = optimize_onedim(PLLMOD_OPT_PARAM_PINV, PLLMOD_OPT_MIN_PINV,
+                                  PLLMOD_OPT_MAX_PINV, cur_loglh, "p-inv");
+      cur_loglh = new_loglh;
+    }
+
+    std::copy(orig_params.cbegin(), orig_params.cend(), _pll_treeinfo->params_to_optimize);
   }
   else
   {
     /* optimize ALPHA */
     if (params_to_optimize & PLLMOD_OPT_PARAM_ALPHA)
     {
-      new_loglh = -1 * pllmod_algo_opt_onedim_treeinfo(_pll_treeinfo,
-                                                        PLLMOD_OPT_PARAM_ALPHA,
-                                                        PLLMOD_OPT_MIN_ALPHA,
-                                                        PLLMOD_OPT_MAX_ALPHA,
-                                                        RAXML_PARAM_EPSILON);
-
-     LOG_DEBUG << "\t - after alpha: logLH = " << new_loglh << endl;
-
-     libpll_check_error("ERROR in alpha parameter optimization");
-     assert_lh_improvement(cur_loglh, new_loglh, "ALPHA");
-     cur_loglh = new_loglh;
+      new_loglh = optimize_onedim(PLLMOD_OPT_PARAM_ALPHA, PLLMOD_OPT_MIN_ALPHA,
+                                  PLLMOD_OPT_MAX_ALPHA, cur_loglh, "alpha");
+      cur_loglh = new_loglh;
     }
 
     /* optimize PINV */
     if (params_to_optimize & PLLMOD_OPT_PARAM_PINV)
     {
-      new_loglh = -1 * pllmod_algo_opt_onedim_treeinfo(_pll_treeinfo,
-                                                        PLLMOD_OPT_PARAM_PINV,
-                                                        PLLMOD_OPT_MIN_PINV,
-                                                        PLLMOD_OPT_MAX_PINV,
-                                                        RAXML_PARAM_EPSILON);
-
-      LOG_DEBUG << "\t - after p-inv: logLH = " << new_loglh << endl;
-
-      libpll_check_error("ERROR in p-inv optimization");
-      assert_lh_improvement(cur_loglh, new_loglh, "PINV");
+      new_loglh = optimize_onedim(PLLMOD_OPT_PARAM_PINV, PLLMOD_OPT_MIN_PINV,
+                                  PLLMOD_OPT_MAX_PINV, cur_loglh, "p-inv");
       cur_loglh = new_loglh;
     }
   }
@@ -356,6 +433,7 @@ double TreeInfo::optimize_params(int params_to_optimize, double lh_epsilon)
   /* optimize FREE RATES and WEIGHTS */
   if (params_to_optimize & PLLMOD_OPT_PARAM_FREE_RATES)
   {
+    ProfileScope prof(ProfileEvent::free_rates_opt);
     new_loglh = -1 * pllmod_algo_opt_rates_weights_treeinfo (_pll_treeinfo,
                                                           RAXML_FREERATE_MIN,
                                                           RAXML_FREERATE_MAX,
@@ -369,22 +447,316 @@ double TreeInfo::optimize_params(int params_to_optimize, double lh_epsilon)
 
     libpll_check_error("ERROR in FreeRate rates/weights optimization");
     assert_lh_improvement(cur_loglh, new_loglh, "FREE RATES");
+    add_param_gain(PLLMOD_OPT_PARAM_FREE_RATES, new_loglh - cur_loglh);
     cur_loglh = new_loglh;
   }
 
-  if (params_to_optimize & PLLMOD_OPT_PARAM_BRANCHES_ITERATIVE)
+  return new_loglh;
+}
+
+double TreeInfo::optimize_onedim(int param, double min_value, double max_value,
+                                 double cur_loglh, const std::string& param_name)
+{
+  ProfileScope prof(param == PLLMOD_OPT_PARAM_ALPHA ? ProfileEvent::alpha_opt : ProfileEvent::pinv_opt);
+
+  double new_loglh = -1 * pllmod_algo_opt_onedim_treeinfo(_pll_treeinfo,
+                                                          param,
+                                                          min_value,
+                                                          max_value,
+                                                          RAXML_PARAM_EPSILON);
+
+  LOG_DEBUG << "\t - after " << param_name << ": logLH = " << new_loglh << endl;
+
+  libpll_check_error("ERROR in " + param_name + " parameter optimization");
+  assert_lh_improvement(cur_loglh, new_loglh, param_name);
+  add_param_gain(param, new_loglh - cur_loglh);
+
+  return new_loglh;
+}
+
+void TreeInfo::add_param_gain(int params, double gain)
+{
+  for (size_t i = 0; i < _param_gains.size(); ++i)
   {
-    new_loglh = optimize_branches(lh_epsilon, 0.25);
+    if (params & (1 << i))
+      _param_gains[i] += gain;
+  }
+}
 
-    assert_lh_improvement(cur_loglh, new_loglh, "BRLEN");
-    cur_loglh = new_loglh;
+void TreeInfo::set_alpha_pinv(size_t partition_id, double alpha, double pinv)
+{
+  _pll_treeinfo->alphas[partition_id] = alpha;
+
+  auto partition = _pll_treeinfo->partitions[partition_id];
+  if (!partition)
+    return;
+
+  if (partition->rate_cats > 1)
+  {
+    doubleVector rates(partition->rate_cats);
+    pll_compute_gamma_cats(alpha, partition->rate_cats, rates.data(), _gamma_modes[partition_id]);
+    pll_set_category_rates(partition, rates.data());
   }
 
+  for (size_t i = 0; i < partition->rate_matrices; ++i)
+    pll_update_invariant_sites_proportion(partition, i, pinv);
+}
+
+/* optimum at (or very close to) the alpha or p-inv bounds */
+static bool alpha_pinv_bounded(double alpha, double pinv)
+{
+  return alpha < PLLMOD_OPT_MIN_ALPHA * (1. + RAXML_ALPHA_PINV_BOUND_TOL) ||
+         alpha > PLLMOD_OPT_MAX_ALPHA * (1. - RAXML_ALPHA_PINV_BOUND_TOL) ||
+         pinv < PLLMOD_OPT_MIN_PINV + RAXML_ALPHA_PINV_BOUND_TOL ||
+         pinv > PLLMOD_OPT_MAX_PINV - RAXML_ALPHA_PINV_BOUND_TOL;
+}
+
+/*
+ * 2D alpha+p-inv optimization (L-BFGS-B in pll-modules). It starts from the current
+ * parameter values, i.e. the optimum from the previous round ("warm start"). On a cold
+ * start, partitions where the first run ended on the parameter bounds get a second run
+ * from the other side of the alpha/p-inv ridge, and the better solution is kept. The
+ * convergence tolerance is adapted such that one call stays around
+ * RAXML_ALPHA_PINV_EVAL_BUDGET logLH evaluations.
+ */
+double TreeInfo::optimize_alpha_pinv(double cur_loglh)
+{
+  const auto part_count = _pll_treeinfo->partition_count;
+  const bool lockstep = _pll_treeinfo->parallel_reduce_cb != nullptr;
+  auto evals_start = _num_loglh_evals;
+
+  auto run_joint = [this]() -> double
+  {
+    ProfileScope prof(ProfileEvent::alpha_pinv_opt);
+    double loglh = -1 * pllmod_algo_opt_alpha_pinv_treeinfo(_pll_treeinfo,
+                                                            0,
+                                                            PLLMOD_OPT_MIN_ALPHA,
+                                                            PLLMOD_OPT_MAX_ALPHA,
+                                                            PLLMOD_OPT_MIN_PINV,
+                                                            PLLMOD_OPT_MAX_PINV,
+                                                            RAXML_BFGS_FACTOR,
+                                                            _alpha_pinv.epsilon);
+    libpll_check_error("ERROR in alpha/p-inv parameter optimization");
+    return loglh;
+  };
+
+  double new_loglh = run_joint();
+
+  LOG_DEBUG << "\t - after a+i  : logLH = " << new_loglh << endl;
+
+  if (!_alpha_pinv.warm)
+  {
+    const int alpha_pinv = PLLMOD_OPT_PARAM_ALPHA | PLLMOD_OPT_PARAM_PINV;
+    std::vector<int> orig_params(_pll_treeinfo->params_to_optimize,
+                                 _pll_treeinfo->params_to_optimize + part_count);
+    doubleVector alphas(part_count), pinvs(part_count), part_loglh(part_count);
+    doubleVector restart(part_count, 0.);
+
+    /* an interior optimum is kept, second start only where the first one ran into
+     * the alpha or p-inv bounds */
+    loglh();
+    for (size_t p = 0; p < part_count; ++p)
+    {
+      auto partition = _pll_treeinfo->partitions[p];
+      alphas[p] = _pll_treeinfo->alphas[p];
+      pinvs[p] = partition ? partition->prop_invar[0] : 0.;
+      part_loglh[p] = _pll_treeinfo->partition_loglh[p];
+
+      if (partition && (orig_params[p] & alpha_pinv) == alpha_pinv &&
+          alpha_pinv_bounded(alphas[p], pinvs[p]))
+        restart[p] = 1.;
+    }
+
+    /* partition can be split across threads -> same decision everywhere (collective call!) */
+    if (lockstep)
+      ParallelContext::parallel_reduce(restart.data(), part_count, PLLMOD_COMMON_REDUCE_MAX);
+
+    auto num_restarts = std::count(restart.cbegin(), restart.cend(), 1.);
+    if (num_restarts > 0)
+    {
+      for (size_t p = 0; p < part_count; ++p)
+      {
+        if (restart[p] > 0.)
+        {
+          if (pinvs[p] < 0.25)
+            set_alpha_pinv(p, std::min(alphas[p] * 4., PLLMOD_OPT_MAX_ALPHA),
+                           std::min(pinvs[p] + 0.25, PLLMOD_OPT_MAX_PINV));
+          else
+            set_alpha_pinv(p, std::max(alphas[p] / 4., PLLMOD_OPT_MIN_ALPHA), pinvs[p] / 4.);
+        }
+        else
+          _pll_treeinfo->params_to_optimize[p] &= ~alpha_pinv;
+      }
+
+      pllmod_treeinfo_invalidate_all(_pll_treeinfo);
+      double alt_loglh = run_joint();
+      std::copy(orig_params.cbegin(), orig_params.cend(), _pll_treeinfo->params_to_optimize);
+      loglh();
+
+      /* keep the better start for every partition (partition logLHs are reduced -> consistent) */
+      size_t restored = 0;
+      for (size_t p = 0; p < part_count; ++p)
+      {
+        if (restart[p] > 0. && _pll_treeinfo->partition_loglh[p] < part_loglh[p])
+        {
+          set_alpha_pinv(p, alphas[p], pinvs[p]);
+          restored++;
+        }
+      }
+
+      pllmod_treeinfo_invalidate_all(_pll_treeinfo);
+      new_loglh = loglh();
+
+      LOG_DEBUG << "\t - after a+i (2nd start for " << num_restarts << " partitions): logLH = "
+                << alt_loglh << ", combined: " << new_loglh << " (1st start kept for "
+                << restored << " partitions)" << endl;
+    }
+
+    /* in split mode, local phase must not change the state -> see optimize_model_split() */
+    if (lockstep)
+      _alpha_pinv.warm = true;
+  }
+
+  if (lockstep)
+  {
+    _alpha_pinv.last_evals = _num_loglh_evals - evals_start;
+    if (_alpha_pinv.last_evals > RAXML_ALPHA_PINV_EVAL_BUDGET)
+      _alpha_pinv.epsilon = std::min(_alpha_pinv.epsilon * 10., RAXML_ALPHA_PINV_MAX_EPSILON);
+    else if (_alpha_pinv.last_evals < RAXML_ALPHA_PINV_EVAL_BUDGET / 4)
+      _alpha_pinv.epsilon = std::max(_alpha_pinv.epsilon / 10., RAXML_PARAM_EPSILON);
+  }
+
+  assert_lh_improvement(cur_loglh, new_loglh, "ALPHA+PINV");
+
+  return new_loglh;
+}
+
+void TreeInfo::reduce_cb(void * context, double * data, size_t size, int op)
+{
+  /* every logLH evaluation sums up the per-partition logLHs, other reductions
+   * (e.g. convergence checks in the optimizers) are not counted */
+  auto treeinfo = static_cast<TreeInfo*>(context);
+  if (treeinfo && data == treeinfo->_pll_treeinfo->partition_loglh)
+    treeinfo->_num_loglh_evals++;
+
+  ParallelContext::parallel_reduce_cb(nullptr, data, size, op);
+}
+
+void TreeInfo::init_split_parts()
+{
+  if (_split_parts_init)
+    return;
+
+  /* count how many threads hold (a slice of) each partition -> collective call! */
+  doubleVector thread_count(_pll_treeinfo->partition_count, 0.);
+  for (size_t p = 0; p < thread_count.size(); ++p)
+  {
+    if (_pll_treeinfo->partitions[p])
+      thread_count[p] = 1.;
+  }
+
+  ParallelContext::parallel_reduce(thread_count.data(), thread_count.size(),
+                                   PLLMOD_COMMON_REDUCE_SUM);
+
+  for (size_t p = 0; p < thread_count.size(); ++p)
+  {
+    if (thread_count[p] > 1.)
+      _parts_shared.insert(p);
+    else if (_pll_treeinfo->partitions[p])
+      _parts_local.insert(p);
+  }
+
+  _split_parts_init = true;
+}
+
+/*
+ * Model parameters are independent between partitions as long as branch lengths are fixed.
+ * Thus, partitions held by a single thread are optimized by this thread alone without any
+ * reductions, and only partitions split across multiple threads are optimized in lockstep.
+ */
+double TreeInfo::optimize_model_split(int params_to_optimize, double cur_loglh)
+{
+  init_split_parts();
+
+  /* FreeRate optimization rescales branch lengths, which are shared unless unlinked */
+  int local_params = params_to_optimize;
+  if (_brlen_linkage != PLLMOD_COMMON_BRLEN_UNLINKED)
+    local_params &= ~PLLMOD_OPT_PARAM_FREE_RATES;
+
+  const auto part_count = _pll_treeinfo->partition_count;
+  std::vector<int> orig_params(_pll_treeinfo->params_to_optimize,
+                               _pll_treeinfo->params_to_optimize + part_count);
+  auto orig_gains = _param_gains;
+
+  /* phase 1: local partitions, no reductions */
+  if (!_parts_local.empty())
+  {
+    std::vector<pll_partition_t*> orig_parts(_pll_treeinfo->partitions,
+                                             _pll_treeinfo->partitions + part_count);
+
+    for (size_t p = 0; p < part_count; ++p)
+    {
+      if (_parts_local.count(p))
+        _pll_treeinfo->params_to_optimize[p] = orig_params[p] & (local_params | ~params_to_optimize);
+      else
+      {
+        _pll_treeinfo->partitions[p] = nullptr;
+        _pll_treeinfo->params_to_optimize[p] = 0;
+      }
+    }
+    pllmod_treeinfo_set_parallel_context(_pll_treeinfo, (void *) nullptr, nullptr);
+
+    optimize_model_params(local_params, loglh());
+
+    pllmod_treeinfo_set_parallel_context(_pll_treeinfo, (void *) this, TreeInfo::reduce_cb);
+    for (size_t p = 0; p < part_count; ++p)
+      _pll_treeinfo->partitions[p] = orig_parts[p];
+  }
+
+  /* phase 1 gains only cover the local partitions -> sum them up (collective call!),
+   * reduction is non-blocking and overlaps with phase 2 */
+  doubleVector local_gains(_param_gains.size());
+  for (size_t i = 0; i < _param_gains.size(); ++i)
+    local_gains[i] = _param_gains[i] - orig_gains[i];
+  _param_gains = orig_gains;
+  ParallelContext::parallel_reduce_start(local_gains.data(), local_gains.size(),
+                                         PLLMOD_COMMON_REDUCE_SUM);
+
+  /* phase 2: shared partitions (+ params which can not be optimized locally) in lockstep */
+  int global_params = _parts_shared.empty() ? (params_to_optimize & ~local_params) : params_to_optimize;
+  if (global_params)
+  {
+    for (size_t p = 0; p < part_count; ++p)
+    {
+      _pll_treeinfo->params_to_optimize[p] = _parts_shared.count(p) ?
+          orig_params[p] : orig_params[p] & ~local_params;
+    }
+
+    optimize_model_params(global_params, loglh());
+  }
+
+  ParallelContext::parallel_reduce_wait(local_gains.data(), local_gains.size());
+  for (size_t i = 0; i < _param_gains.size(); ++i)
+    _param_gains[i] += local_gains[i];
+
+  std::copy(orig_params.cbegin(), orig_params.cend(), _pll_treeinfo->params_to_optimize);
+
+  const int alpha_pinv = PLLMOD_OPT_PARAM_ALPHA | PLLMOD_OPT_PARAM_PINV;
+  if (_use_joint_alpha_pinv && (params_to_optimize & alpha_pinv) == alpha_pinv)
+    _alpha_pinv.warm = true;
+
+  /* final sync: global logLH over all partitions */
+  double new_loglh = loglh();
+
+  assert_lh_improvement(cur_loglh, new_loglh, "SPLIT MODEL");
+
   return new_loglh;
 }
 
 double TreeInfo::spr_round(spr_round_params& params)
 {
+  ProfileScope prof(ProfileEvent::spr_round);
+
   double loglh = pllmod_algo_spr_round(_pll_treeinfo, params.radius_min, params.radius_max,
                                params.ntopol_keep, params.thorough, _brlen_opt_method,
                                _brlen_min, _brlen_max, RAXML_BRLEN_SMOOTHINGS,
@@ -413,7 +785,8 @@ void TreeInfo::set_topology_constraint(const Tree& cons_tree)
 }
 
 void TreeInfo::compute_ancestral(const AncestralStatesSharedPtr& ancestral,
-                                 const PartitionAssignment& part_assign)
+                                 const PartitionAssignment& part_assign,
+                                 const AncestralBlockCallback& block_cb)
 {
   pllmod_ancestral_t * pll_ancestral = pllmod_treeinfo_compute_ancestral(_pll_treeinfo);
 
@@ -425,7 +798,32 @@ void TreeInfo::compute_ancestral(const AncestralStatesSharedPtr& ancestral,
   if (ParallelContext::master_thread())
     assign_tree(*ancestral, *pll_ancestral);
 
-  assign_probs(*ancestral, *pll_ancestral, part_assign);
+  /* copy probabilities block-wise, so that only a part of the nodes is held in memory
+   * (block_cb can write out and free each block before the next one is assembled) */
+  for (;;)
+  {
+    ParallelContext::thread_barrier();
+
+    if (ParallelContext::master_thread())
+      ancestral->next_block();
+
+    ParallelContext::thread_barrier();
+
+    if (ancestral->block_nodes.empty())
+      break;
+
+    assign_probs(*ancestral, *pll_ancestral, part_assign);
+
+    ParallelContext::thread_barrier();
+
+    if (ParallelContext::master_thread() && block_cb)
+      block_cb(*ancestral);
+
+    /* keep the last block if there is no consumer for it */
+    if (!block_cb && ancestral->block_start + ancestral->num_block_nodes() >=
+                     ancestral->num_selected_nodes())
+      break;
+  }
 
   pllmod_treeinfo_destroy_ancestral(pll_ancestral);
 }
@@ -464,8 +862,8 @@ void assign(Model& model, const TreeInfo& treeinfo, size_t partition_id)
     model.brlen_scaler(pll_treeinfo.brlen_scalers[partition_id]);
 }
 
-void build_clv(ProbVector::const_iterator probs, size_t sites, const WeightVector& weights, size_t seq_offset,
-               pll_partition_t* partition, bool normalize, std::vector<double>& clv)
+void build_clv(const MSA& msa, size_t seq_id, size_t sites, const WeightVector& weights,
+               size_t seq_offset, pll_partition_t* partition, std::vector<double>& clv)
 {
   const auto states = partition->states;
   auto clvp = clv.begin();
@@ -474,23 +872,10 @@ void build_clv(ProbVector::const_iterator probs, size_t sites, const WeightVecto
   {
     if (weights.empty() || weights[seq_offset + i] > 0)
     {
-      double sum = 0.;
-      for (size_t j = 0; j < states; ++j)
-        sum += probs[j];
-
-      for (size_t j = 0; j < states; ++j)
-      {
-        if (sum > 0.)
-          clvp[j] =  normalize ? probs[j] / sum : probs[j];
-        else
-          clvp[j] = 1.0;
-      }
-
+      /* MSA stores normalized probabilities (or all-1.0 for missing data) */
+      msa.probs(seq_id, seq_offset + i, &(*clvp));
       clvp += states;
     }
-
-    /* NB: clv has to be padded, but msa arrays are not! */
-    probs += states;
   }
 
   assert(clvp == clv.end());
@@ -498,32 +883,30 @@ void build_clv(ProbVector::const_iterator probs, size_t sites, const WeightVecto
 
 void set_partition_tips(const Options& opts, const MSA& msa, const IDVector& tip_msa_idmap,
                         const PartitionRange& part_region,
-                        pll_partition_t* partition, const pll_state_t * charmap)
+                        pll_partition_t* partition, const pll_state_t * charmap,
+                        const WeightType * pattern_weights)
 {
   /* get "true" sequence offset considering that MSA can be partially loaded */
   auto seq_offset = msa.get_local_offset(part_region.start);
 
 //  printf("\n\n rank %lu, GLOBAL OFFSET %lu, LOCAL OFFSET %lu \n\n", ParallelContext::proc_id(), part_region.start, seq_offset);
 
-  /* set pattern weights */
-  if (!msa.weights().empty())
-    pll_set_pattern_weights(partition, msa.weights().data() + seq_offset);
+  /* set pattern weights (MSA or bootstrap replicate weights, all columns are kept) */
+  if (pattern_weights)
+    pll_set_pattern_weights(partition, pattern_weights + seq_offset);
 
   if (opts.use_prob_msa && msa.probabilistic())
   {
     assert(!(partition->attributes & PLL_ATTRIB_PATTERN_TIP));
     assert(partition->states == msa.states());
 
-    auto normalize = !msa.normalized();
-
     // we need a libpll function for that!
     auto clv_size = partition->sites * partition->states;
     std::vector<double> tmp_clv(clv_size);
     for (size_t tip_id = 0; tip_id < partition->tips; ++tip_id)
     {
       auto seq_id = tip_msa_idmap.empty() ? tip_id : tip_msa_idmap[tip_id];
-      auto prob_start = msa.probs(seq_id, seq_offset);
-      build_clv(prob_start, partition->sites, msa.weights(), seq_offset, partition, normalize, tmp_clv);
+      build_clv(msa, seq_id, partition->sites, msa.weights(), seq_offset, partition, tmp_clv);
       pll_set_tip_clv(partition, tip_id, tmp_clv.data(), PLL_FALSE);
     }
   }
@@ -532,7 +915,7 @@ void set_partition_tips(const Options& opts, const MSA& msa, const IDVector& tip
     for (size_t tip_id = 0; tip_id < partition->tips; ++tip_id)
     {
       auto seq_id = tip_msa_idmap.empty() ? tip_id : tip_msa_idmap[tip_id];
-      pll_set_tip_states(partition, tip_id, charmap, msa.at(seq_id).c_str() + seq_offset);
+      pll_set_tip_states(partition, tip_id, charmap, msa.sequence_data(seq_id) + seq_offset);
     }
   }
 }
@@ -562,16 +945,13 @@ void set_partition_tips(const Options& opts, const MSA& msa, const IDVector& tip
     assert(!(partition->attributes & PLL_ATTRIB_PATTERN_TIP));
     assert(partition->states == msa.states());
 
-    auto normalize = !msa.normalized();
-
     // we need a libpll function for that!
     auto clv_size = comp_weights.size() * partition->states;
     std::vector<double> tmp_clv(clv_size);
     for (size_t tip_id = 0; tip_id < partition->tips; ++tip_id)
     {
       auto seq_id = tip_msa_idmap.empty() ? tip_id : tip_msa_idmap[tip_id];
-      auto prob_start = msa.probs(seq_id, pstart);
-      build_clv(prob_start, plen, weights, pstart, partition, normalize, tmp_clv);
+      build_clv(msa, seq_id, plen, weights, pstart, partition, tmp_clv);
       pll_set_tip_clv(partition, tip_id, tmp_clv.data(), PLL_FALSE);
     }
   }
@@ -581,7 +961,7 @@ void set_partition_tips(const Options& opts, const MSA& msa, const IDVector& tip
     for (size_t tip_id = 0; tip_id < partition->tips; ++tip_id)
     {
       auto seq_id = tip_msa_idmap.empty() ? tip_id : tip_msa_idmap[tip_id];
-      const char * full_seq = msa.at(seq_id).c_str();
+      const char * full_seq = msa.sequence_data(seq_id);
       size_t pos = 0;
       for (size_t j = pstart; j < pend; ++j)
       {
@@ -597,6 +977,40 @@ void set_partition_tips(const Options& opts, const MSA& msa, const IDVector& tip
   pll_set_pattern_weights(partition, comp_weights.data());
 }
 
+/* minimum partition length for which tip-inner kernels pay off */
+static unsigned long tip_inner_min_length(const Model& model)
+{
+  // TODO: use proper auto-tuning
+  return model.num_states() > 4 ? 40 : 100;
+}
+
+/* binary, multistate and user-defined (custom charmap) state spaces with few distinct
+ * tip codes: tip-inner CLV updates can use precomputed lookup tables (PLL_ATTRIB_PATTERN_TIP).
+ * Used instead of site repeats, thus only if PLL_ATTRIB_PATTERN_TIP will be set below,
+ * otherwise the partition would end up with neither optimization */
+static bool use_tip_lookup(const Options& opts, const Model& model, size_t part_length)
+{
+  const auto states = model.num_states();
+
+  if (!opts.use_tip_lookup || opts.use_prob_msa)
+    return false;
+
+  if (states == 4 || states >= 20 || opts.simd_arch == PLL_ATTRIB_ARCH_SSE ||
+      (unsigned long) part_length <= tip_inner_min_length(model))
+    return false;
+
+  /* ambiguity codes count as separate tip codes -> check lookup table size */
+  std::set<pll_state_t> tip_codes;
+  const pll_state_t * charmap = model.charmap();
+  for (size_t c = 0; c < PLL_ASCII_SIZE; ++c)
+  {
+    if (charmap[c])
+      tip_codes.insert(charmap[c]);
+  }
+
+  return tip_codes.size() <= RAXML_TIPLOOKUP_MAX_CODES;
+}
+
 pll_partition_t* create_pll_partition(const Options& opts, const PartitionInfo& pinfo,
                                       const IDVector& tip_msa_idmap,
                                       const PartitionRange& part_region, const uintVector& weights)
@@ -608,12 +1022,17 @@ pll_partition_t* create_pll_partition(const Options& opts, const PartitionInfo&
 //  printf("\n\n rank %lu, GLOBAL OFFSET %lu, LOCAL OFFSET %lu \n\n", ParallelContext::proc_id(), part_region.start, pstart);
 
   /* part_length doesn't include columns with zero weight */
-  const size_t part_length = weights.empty() ? part_region.length :
-                             std::count_if(weights.begin() + pstart,
-                                           weights.begin() + pstart + part_region.length,
-                                           [](uintVector::value_type w) -> bool
-                                             { return w > 0; }
-                                           );
+  size_t part_length = weights.empty() ? part_region.length :
+                       std::count_if(weights.begin() + pstart,
+                                     weights.begin() + pstart + part_region.length,
+                                     [](uintVector::value_type w) -> bool
+                                       { return w > 0; }
+                                     );
+
+  /* fixed site ranges (RBA partial loading): no site of this range might have been drawn
+   * into the bootstrap replicate -> keep all columns with zero weights */
+  if (part_length == 0)
+    part_length = part_region.length;
 
   unsigned int attrs = opts.simd_arch;
 
@@ -622,21 +1041,21 @@ pll_partition_t* create_pll_partition(const Options& opts, const PartitionInfo&
     attrs |= PLL_ATTRIB_RATE_SCALERS;
   }
 
-  if (opts.use_repeats)
+  const bool tip_lookup = use_tip_lookup(opts, model, part_length);
+
+  if (opts.use_repeats && !tip_lookup)
   {
     assert(!(opts.use_prob_msa));
     attrs |= PLL_ATTRIB_SITE_REPEATS;
   }
-  else if (opts.use_tip_inner)
+  else if (opts.use_tip_inner || tip_lookup)
   {
     assert(!(opts.use_prob_msa));
     // 1) SSE3 tip-inner kernels are not implemented so far, so generic version will be faster
     // 2) same for state-rich models
     if (opts.simd_arch != PLL_ATTRIB_ARCH_SSE && model.num_states() <= 20)
     {
-      // TODO: use proper auto-tuning
-      const unsigned long min_len_ti = model.num_states() > 4 ? 40 : 100;
-      if ((unsigned long) part_length > min_len_ti)
+      if ((unsigned long) part_length > tip_inner_min_length(model))
         attrs |= PLL_ATTRIB_PATTERN_TIP;
     }
   }
@@ -669,7 +1088,8 @@ pll_partition_t* create_pll_partition(const Options& opts, const PartitionInfo&
     pll_set_asc_state_weights(partition, model.ascbias_weights().data());
 
   if (part_length == part_region.length)
-    set_partition_tips(opts, msa, tip_msa_idmap, part_region, partition, model.charmap());
+    set_partition_tips(opts, msa, tip_msa_idmap, part_region, partition, model.charmap(),
+                       weights.empty() ? nullptr : weights.data());
   else
     set_partition_tips(opts, msa, tip_msa_idmap, part_region, partition, model.charmap(), weights);
 
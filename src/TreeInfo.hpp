@@ -26,6 +26,21 @@ struct spr_round_params
   }
 };
 
+/* joint alpha+p-inv optimizer state, carried over between rounds and stored in checkpoint */
+struct alpha_pinv_state
+{
+  bool warm;                /* false -> run multi-start on the next call */
+  double epsilon;           /* current convergence tolerance (adapted to eval budget) */
+  unsigned int last_evals;  /* logLH evaluations in the last joint optimization */
+
+  void reset()
+  {
+    warm = false;
+    epsilon = RAXML_PARAM_EPSILON;
+    last_evals = 0;
+  }
+};
+
 class TreeInfo
 {
 public:
@@ -53,17 +68,25 @@ public:
 
   void set_topology_constraint(const Tree& cons_tree);
 
+  const alpha_pinv_state& alpha_pinv() const { return _alpha_pinv; }
+  void alpha_pinv(const alpha_pinv_state& state) { _alpha_pinv = state; }
+
+  /* logLH gain per model parameter since the last reset, indexed by PLLMOD_OPT_PARAM_* bit */
+  const doubleVector& param_gains() const { return _param_gains; }
+  void reset_param_gains() { std::fill(_param_gains.begin(), _param_gains.end(), 0.); }
+
   double loglh(bool incremental = false);
   double persite_loglh(std::vector<double*> part_site_lh, bool incremental = false);
-  double optimize_params(int params_to_optimize, double lh_epsilon);
-  double optimize_params_all(double lh_epsilon)
-  { return optimize_params(PLLMOD_OPT_PARAM_ALL, lh_epsilon); } ;
+  double optimize_params(int params_to_optimize, double lh_epsilon, bool split_parts = false);
+  double optimize_params_all(double lh_epsilon, bool split_parts = false)
+  { return optimize_params(PLLMOD_OPT_PARAM_ALL, lh_epsilon, split_parts); } ;
   double optimize_model(double lh_epsilon)
   { return optimize_params(PLLMOD_OPT_PARAM_ALL & ~PLLMOD_OPT_PARAM_BRANCHES_ITERATIVE, lh_epsilon); } ;
   double optimize_branches(double lh_epsilon, double brlen_smooth_factor);
   double spr_round(spr_round_params& params);
   void compute_ancestral(const AncestralStatesSharedPtr& ancestral,
-                         const PartitionAssignment& part_assign);
+                         const PartitionAssignment& part_assign,
+                         const AncestralBlockCallback& block_cb = nullptr);
 
 private:
   pllmod_treeinfo_t * _pll_treeinfo;
@@ -74,13 +97,36 @@ private:
   bool _check_lh_impr;
   bool _use_old_constraint;
   bool _use_spr_fastclv;
+  int _brlen_linkage;
+  bool _use_joint_alpha_pinv;
+  alpha_pinv_state _alpha_pinv;
+  intVector _gamma_modes;
+  size_t _num_loglh_evals;
+  doubleVector _param_gains;
   doubleVector _partition_contributions;
 
+  /* partitions held entirely by this thread vs. partitions split across >1 thread
+   * (determined lazily, see init_split_parts()) */
+  IDSet _parts_local;
+  IDSet _parts_shared;
+  bool _split_parts_init;
+
   void init(const Options &opts, const Tree& tree, const PartitionedMSA& parted_msa,
             const IDVector& tip_msa_idmap, const PartitionAssignment& part_assign,
             const std::vector<uintVector>& site_weights);
 
   void assert_lh_improvement(double old_lh, double new_lh, const std::string& where = "");
+
+  double optimize_model_params(int params_to_optimize, double cur_loglh);
+  double optimize_alpha_pinv(double cur_loglh);
+  double optimize_onedim(int param, double min_value, double max_value,
+                         double cur_loglh, const std::string& param_name);
+  void set_alpha_pinv(size_t partition_id, double alpha, double pinv);
+  void add_param_gain(int params, double gain);
+
+  static void reduce_cb(void * context, double * data, size_t size, int op);
+  double optimize_model_split(int params_to_optimize, double cur_loglh);
+  void init_split_parts();
 };
 
 void assign(PartitionedMSA& parted_msa, const TreeInfo& treeinfo);
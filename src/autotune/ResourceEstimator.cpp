@@ -5,6 +5,14 @@ ResourceEstimator::ResourceEstimator(const PartitionedMSA& parted_msa, const Opt
 {
   _taxon_clv_size = parted_msa.taxon_clv_size();
 
+  /* scaling counters: one per site, or one per site and rate category with rate scalers */
+  _taxon_scaler_size = 0;
+  for (const auto& pinfo: parted_msa.part_list())
+  {
+    auto rate_cats = pinfo.model().num_ratecats();
+    _taxon_scaler_size += pinfo.length() * (opts.use_rate_scalers && rate_cats > 1 ? rate_cats : 1);
+  }
+
   _num_patterns = opts.use_pattern_compression ? parted_msa.total_patterns() :
                                                  parted_msa.total_sites();
 
@@ -34,6 +42,9 @@ StaticResourceEstimator::StaticResourceEstimator(const PartitionedMSA& parted_ms
     _num_clvs = _num_taxa + _num_taxa - 2;
   }
 
+  /* inner nodes only */
+  _num_scale_buffers = _num_taxa - 2;
+
 // TODO: account for site repeats
 //  if (opts.use_repeats)
 
@@ -56,7 +67,9 @@ void StaticResourceEstimator::compute_estimates(ResEstimates& res)
 {
   size_t mem_size = 0;
 
+  /* element sizes as allocated by libpll: CLVs are always stored in double precision */
   mem_size += _num_clvs * _taxon_clv_size * sizeof(double);
+  mem_size += _num_scale_buffers * _taxon_scaler_size * sizeof(unsigned int);
   mem_size += _num_tipvecs * _num_patterns * sizeof(unsigned char);
 
   res.total_mem_size = mem_size;
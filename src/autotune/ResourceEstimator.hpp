@@ -28,6 +28,7 @@ protected:
   size_t _num_partitions;
   size_t _num_patterns;
   size_t _taxon_clv_size;
+  size_t _taxon_scaler_size;
 };
 
 class StaticResourceEstimator : public ResourceEstimator
@@ -44,6 +45,7 @@ private:
 protected:
   size_t _num_tipvecs;
   size_t _num_clvs;
+  size_t _num_scale_buffers;
 };
 
 
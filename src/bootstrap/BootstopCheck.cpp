@@ -1,5 +1,8 @@
 #include "BootstopCheck.hpp"
 
+#include "../ParallelContext.hpp"
+#include "../util/Profiler.hpp"
+
 using namespace std;
 
 BootstopCheck::BootstopCheck(size_t max_bs_trees)
@@ -11,12 +14,17 @@ BootstopCheck::BootstopCheck(size_t max_bs_trees)
 
 BootstopCheck::~BootstopCheck ()
 {
+  wait_pending();
+
   if (_pll_splits_hash)
     pllmod_utree_split_hashtable_destroy(_pll_splits_hash);
 }
 
 void BootstopCheck::add_bootstrap_tree(const Tree& tree)
 {
+  /* background test must not see a half-updated split table */
+  wait_pending();
+
   if (_num_bs_trees == _max_bs_trees)
   {
     throw runtime_error("BootstopCheck::add_bootstrap_tree: "
@@ -99,6 +107,35 @@ bool BootstopCheck::converged(unsigned long random_seed)
   return check_convergence(gen);
 }
 
+void BootstopCheck::converged_async(unsigned long random_seed)
+{
+  wait_pending();
+
+#ifdef _RAXML_PTHREADS
+  /* the test thread must not be stuck on the core of the (pinned) master thread;
+   * it has the same proc_id() as the master thread -> no profiling there */
+  _pending_test = std::async(std::launch::async, [this, random_seed]() -> bool
+      {
+        ParallelContext::unpin_thread();
+        Profiler::disable_thread();
+        return converged(random_seed);
+      });
+#else
+  _pending_test = std::async(std::launch::deferred, &BootstopCheck::converged, this, random_seed);
+#endif
+}
+
+bool BootstopCheck::converged_result()
+{
+  return _pending_test.valid() ? _pending_test.get() : false;
+}
+
+void BootstopCheck::wait_pending() const
+{
+  if (_pending_test.valid())
+    _pending_test.wait();
+}
+
 BootstopCheckMRE::BootstopCheckMRE(size_t max_bs_trees, double cutoff,
                                    size_t num_permutations) : BootstopCheck(max_bs_trees),
                                        _wrf_cutoff(cutoff), _num_permutations(num_permutations),
@@ -108,6 +145,7 @@ BootstopCheckMRE::BootstopCheckMRE(size_t max_bs_trees, double cutoff,
 
 BootstopCheckMRE::~BootstopCheckMRE ()
 {
+  wait_pending();
 }
 
 bool BootstopCheckMRE::check_convergence(RandomGenerator& gen)
@@ -2,6 +2,7 @@
 #define RAXML_BOOTSTRAP_BOOTSTOPCHECK_HPP_
 
 #include <bitset>
+#include <future>
 #include "../Tree.hpp"
 
 typedef std::vector<bool> bitVector;
@@ -33,6 +34,11 @@ public:
 
   bool converged(unsigned long random_seed = 0);
 
+  /* start convergence test in the background, and collect its result later on */
+  void converged_async(unsigned long random_seed = 0);
+  bool converged_pending() const { return _pending_test.valid(); }
+  bool converged_result();
+
   size_t num_bs_trees() const { return _num_bs_trees; }
   size_t max_bs_trees() const { return _max_bs_trees; }
   void max_bs_trees(size_t val) { if (!_num_bs_trees) _max_bs_trees = val; }
@@ -42,8 +48,10 @@ protected:
   size_t _max_bs_trees;
   bitv_hashtable_t * _pll_splits_hash;
   std::vector<bitVector> _split_occurence;
+  std::future<bool> _pending_test;
 
   splitEntryVector all_splits();
+  void wait_pending() const;
 
   virtual bool check_convergence(RandomGenerator& gen) = 0;
 };
@@ -1,3 +1,5 @@
+#include <numeric>
+
 #include "BootstrapGenerator.hpp"
 
 BootstrapGenerator::BootstrapGenerator ()
@@ -31,10 +33,33 @@ WeightVector BootstrapGenerator::generate(const MSA& msa, unsigned long random_s
   return generate(msa, gen);
 }
 
+BootstrapReplicate BootstrapGenerator::generate(const WeightVectorList& part_weights,
+                                                unsigned long random_seed)
+{
+  BootstrapReplicate result;
+
+  RandomGenerator gen(random_seed);
+
+  for (const auto& w: part_weights)
+  {
+    auto orig_len = std::accumulate(w.cbegin(), w.cend(), 0u);
+    result.site_weights.emplace_back(generate(orig_len, w, gen));
+  }
+
+  return result;
+}
+
 WeightVector BootstrapGenerator::generate(const MSA& msa, RandomGenerator& gen)
 {
-  unsigned int orig_len = msa.num_sites();
-  unsigned int comp_len = msa.length();
+  assert(msa.num_sites() == msa.length() || !msa.weights().empty());
+
+  return generate(msa.num_sites(), msa.weights(), gen);
+}
+
+WeightVector BootstrapGenerator::generate(unsigned int orig_len, const WeightVector& orig_weights,
+                                          RandomGenerator& gen)
+{
+  unsigned int comp_len = orig_weights.empty() ? orig_len : orig_weights.size();
 
   WeightVector w_buf(orig_len, 0);
 
@@ -51,9 +76,6 @@ WeightVector BootstrapGenerator::generate(const MSA& msa, RandomGenerator& gen)
   else
   {
     WeightVector result(comp_len, 0);
-    auto orig_weights = msa.weights();
-
-    assert(!orig_weights.empty());
 
     unsigned int pos = 0;
     for (unsigned int i = 0; i < comp_len; ++i)
@@ -65,4 +87,3 @@ WeightVector BootstrapGenerator::generate(const MSA& msa, RandomGenerator& gen)
     return result;
   }
 }
-
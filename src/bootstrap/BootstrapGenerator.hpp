@@ -22,8 +22,13 @@ public:
   BootstrapReplicate generate(const PartitionedMSA& parted_msa, unsigned long random_seed);
   WeightVector generate(const MSA& msa, unsigned long random_seed);
 
+  /* same as above, but only needs the per-partition pattern weights (no sequence data) */
+  BootstrapReplicate generate(const WeightVectorList& part_weights, unsigned long random_seed);
+
 private:
   WeightVector generate(const MSA& msa, RandomGenerator& gen);
+  WeightVector generate(unsigned int orig_len, const WeightVector& orig_weights,
+                        RandomGenerator& gen);
 };
 
 #endif /* RAXML_BOOTSTRAP_BOOTSTRAPGENERATOR_HPP_ */
@@ -23,6 +23,7 @@ extern "C" {
 #include "ParallelContext.hpp"
 #include "log.hpp"
 #include "util/SystemTimer.hpp"
+#include "util/Profiler.hpp"
 
 /* used to suppress compiler warnings about unused args */
 #define RAXML_UNUSED(expr) (void)(expr)
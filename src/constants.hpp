@@ -13,6 +13,22 @@
 #define RAXML_PARAM_EPSILON       0.001  //0.01
 #define RAXML_BFGS_FACTOR         1e7
 
+/* joint alpha+p-inv optimization: target number of logLH evaluations per call */
+#define RAXML_ALPHA_PINV_EVAL_BUDGET  40
+#define RAXML_ALPHA_PINV_MAX_EPSILON  0.01
+#define RAXML_ALPHA_PINV_BOUND_TOL    0.001  /* optimum this close to the bounds -> second start */
+
+/* adaptive model optimization scheduling between SPR phases */
+#define RAXML_MODOPT_PARAM_SLOTS      16     /* PLLMOD_OPT_PARAM_* bits tracked */
+#define RAXML_MODOPT_MIN_GAIN         0.1    /* parameter is considered converged below this gain */
+#define RAXML_MODOPT_STABLE_RFDIST    0.05   /* max. relative RF distance of a "stable" topology */
+#define RAXML_MODOPT_EPS_FACTOR       3.     /* epsilon loosening factor for stable topologies */
+#define RAXML_MODOPT_MAX_SKIPPED      2      /* max. consecutive steps w/o model parameter optimization */
+
+#define RAXML_TIPLOOKUP_MAX_CODES     64     /* max. distinct tip codes for binary/multistate lookups */
+
+#define RAXML_PROBMSA_EPSILON         1e-6   /* prob. vectors this close to a single state are stored as discrete */
+
 #define DEF_LH_EPSILON_BRLEN_TRIPLET   1000
 
 #define DEF_LH_EPSILON_V11         0.1
@@ -40,6 +56,13 @@
 #define RAXML_BOOTSTOP_INTERVAL   50
 #define RAXML_BOOTSTOP_PERMUTES   1000
 
+#define RAXML_BUDGET_ML_SHARE     0.5    /* max. budget for ML searches if bootstrapping follows */
+#define RAXML_BUDGET_RESERVE      0.05   /* kept for support/result files at the end */
+
+#define RAXML_PIPELINE_ML_COST    2.0    /* rough cost of an ML search relative to a BS replicate */
+
+#define RAXML_ASR_BLOCK_SIZE      16
+
 // cpu features
 #define RAXML_CPU_SSE3  (1<<0)
 #define RAXML_CPU_AVX   (1<<1)
@@ -78,6 +78,85 @@ RBAStream& operator<<(RBAStream& stream, const PartitionedMSA& part_msa)
   return stream;
 }
 
+RBAStream& operator<<(RBAStream& stream, const BootstrapMSA& bs_msa)
+{
+  BinaryFileStream bos(stream.fname(), std::ios::out);
+
+  const auto& part_msa = std::get<0>(bs_msa);
+  const auto& bsrep = std::get<1>(bs_msa);
+
+  /* patterns which were not drawn in this replicate are omitted; partition stats (empirical
+   * frequencies, p-inv etc.) must be computed on the replicate, not on the original alignment */
+  std::vector<PartitionInfo> rep_parts;
+  rep_parts.reserve(part_msa.part_count());
+  size_t pattern_count = 0;
+  for (size_t p = 0; p < part_msa.part_count(); ++p)
+  {
+    const auto& pinfo = part_msa.part_info(p);
+    const auto& msa = pinfo.msa();
+    const auto& w = bsrep.site_weights.at(p);
+
+    IDVector patterns;
+    WeightVector pat_weights;
+    for (size_t j = 0; j < w.size(); ++j)
+    {
+      if (w[j] > 0)
+      {
+        patterns.push_back(j);
+        pat_weights.push_back(w[j]);
+      }
+    }
+
+    MSA rep_msa(patterns.size());
+    rep_msa.weights(std::move(pat_weights));
+
+    std::string seq(patterns.size(), 0);
+    for (size_t i = 0; i < msa.size(); ++i)
+    {
+      const auto orig_seq = msa.sequence_data(i);
+      for (size_t j = 0; j < patterns.size(); ++j)
+        seq[j] = orig_seq[patterns[j]];
+      rep_msa.append(seq);
+    }
+
+    rep_parts.emplace_back(pinfo.name(), PartitionStats(), pinfo.model(), pinfo.range_string());
+    rep_parts.back().msa(std::move(rep_msa));
+    pattern_count += patterns.size();
+  }
+
+  RBAHeader header{};
+
+  header.taxon_count = part_msa.taxon_count();
+  header.site_count = part_msa.total_sites();
+  header.pattern_count = pattern_count;
+  header.part_count = part_msa.part_count();
+
+  bos << header;
+
+  // taxon labels
+  for (const auto& label: part_msa.taxon_names())
+  {
+    bos << label;
+  }
+
+  // models
+  for (const auto& pinfo: rep_parts)
+  {
+    bos << pinfo.name();
+    bos << pinfo.range_string();
+    bos << pinfo.stats();
+    bos << std::make_tuple(std::ref(pinfo.model()), ModelBinaryFmt::full);
+  }
+
+  // per-partition alignment blocks with replicate weights
+  for (const auto& pinfo: rep_parts)
+  {
+    bos << pinfo.msa();
+  }
+
+  return stream;
+}
+
 RBAStream& operator>>(RBAStream& stream, PartitionedMSA& part_msa)
 {
   stream >> RBAStream::RBAOutput(part_msa, RBAStream::RBAElement::all, nullptr);
@@ -186,6 +265,12 @@ RBAStream& operator>>(RBAStream& stream, RBAStream::RBAOutput out)
     }
   }
 
+  if (elem == RBAStream::RBAElement::weights)
+  {
+    for (auto& pinfo: part_msa.part_list())
+      bos >> MSAWeights(pinfo.msa());
+  }
+
 //  LOG_INFO << part_msa << endl;
 
   return stream;
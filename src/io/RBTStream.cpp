@@ -0,0 +1,209 @@
+#include "file_io.hpp"
+#include "binary_io.hpp"
+
+using namespace std;
+
+const uint64_t RBT_MAGIC       = *(reinterpret_cast<const uint64_t*>("RBTF\x13\x12\x17\x0A"));
+const uint32_t RBT_VERSION     = 1;
+const uint32_t RBT_MIN_VERSION = 1;
+
+struct RBTHeader
+{
+  uint64_t magic;
+  uint32_t version;
+  TreeBrlenFormat brlen_fmt;
+  uint64_t taxon_count;
+  uint64_t tree_count;
+
+  bool valid() { return magic == RBT_MAGIC; }
+
+  bool supported() { return version >= RBT_MIN_VERSION && version <= RBT_VERSION; }
+
+  RBTHeader() : magic(RBT_MAGIC), version(RBT_VERSION), brlen_fmt(TreeBrlenFormat::full),
+      taxon_count(0), tree_count(0)
+      {}
+};
+
+/*
+ *  File layout:
+ *    header | taxon labels | offset index (tree_count+1 entries) | tree block
+ *
+ *  Trees are stored as TreeTopology edge lists with varint-encoded node IDs,
+ *  tip node IDs refer to the taxon table. Offsets are relative to the start
+ *  of the tree block, which allows for random access to individual trees.
+ */
+static RBTHeader read_header(BinaryFileStream& bos)
+{
+  RBTHeader header;
+
+  bos >> header;
+
+  if (!bos.good())
+    throw runtime_error("Invalid RBT file!");
+
+  if (!header.valid())
+    throw runtime_error("Invalid RBT file header!");
+
+  if (!header.supported())
+    throw runtime_error("Unsupported RBT file version: " + to_string(header.version));
+
+  return header;
+}
+
+/* node IDs are used as array indices later on -> reject anything that does not fit
+ * an unrooted binary tree with taxon_count tips */
+static void check_topology(const TreeTopology& topol, size_t taxon_count, size_t index)
+{
+  const size_t num_nodes = taxon_count > 2 ? 2 * taxon_count - 2 : taxon_count;
+  const size_t num_branches = taxon_count > 2 ? 2 * taxon_count - 3 : 0;
+  const string tree_str = "RBTStream: tree #" + to_string(index + 1);
+
+  if (topol.edges.size() != num_branches)
+  {
+    throw runtime_error(tree_str + " has wrong number of branches: " +
+                        to_string(topol.edges.size()) + " (expected: " +
+                        to_string(num_branches) + ")");
+  }
+
+  if (topol.vroot_node_id >= num_nodes)
+    throw runtime_error(tree_str + " has invalid root node ID: " + to_string(topol.vroot_node_id));
+
+  for (const auto& e: topol.edges)
+  {
+    if (e.left_node_id >= num_nodes || e.right_node_id >= num_nodes ||
+        e.left_node_id == e.right_node_id)
+    {
+      throw runtime_error(tree_str + " has invalid branch: " + to_string(e.left_node_id) +
+                          " - " + to_string(e.right_node_id));
+    }
+  }
+
+  for (const auto& part_brlens: topol.brlens)
+  {
+    if (part_brlens.size() != num_branches)
+      throw runtime_error(tree_str + " has wrong number of per-partition branch lengths");
+  }
+}
+
+bool RBTStream::rbt_file(const std::string& fname)
+{
+  BinaryFileStream bos(fname, std::ios::in);
+  RBTHeader header;
+
+  bos >> header;
+
+  return bos.good() && header.valid() && header.supported();
+}
+
+size_t RBTStream::tree_count() const
+{
+  BinaryFileStream bos(_fname, std::ios::in);
+
+  return read_header(bos).tree_count;
+}
+
+NameList RBTStream::taxon_names() const
+{
+  BinaryFileStream bos(_fname, std::ios::in);
+  auto header = read_header(bos);
+
+  NameList taxon_names(header.taxon_count, "");
+  for (auto& taxon: taxon_names)
+    bos >> taxon;
+
+  return taxon_names;
+}
+
+TreeTopology RBTStream::tree(size_t index) const
+{
+  BinaryFileStream bos(_fname, std::ios::in);
+  auto header = read_header(bos);
+
+  if (index >= header.tree_count)
+  {
+    throw out_of_range("RBTStream: tree index " + to_string(index) +
+                       " is out of range (" + to_string(header.tree_count) + " trees)");
+  }
+
+  for (size_t i = 0; i < header.taxon_count; ++i)
+    bos.get<std::string>();
+
+  std::vector<uint64_t> offsets;
+  bos >> offsets;
+
+  TreeTopology topol;
+  bos.skip(offsets.at(index));
+  bos >> CompactTopologyRef(topol, header.brlen_fmt);
+
+  if (!bos.good())
+    throw runtime_error("RBTStream: unexpected end of file: " + _fname);
+
+  check_topology(topol, header.taxon_count, index);
+
+  return topol;
+}
+
+RBTStream& operator<<(RBTStream& stream, RBTStream::RBTInput in)
+{
+  BinaryFileStream bos(stream.fname(), std::ios::out);
+
+  const auto& taxon_names = std::get<0>(in);
+  const auto& trees = std::get<1>(in);
+
+  RBTHeader header{};
+
+  header.brlen_fmt = stream.brlen_format();
+  header.taxon_count = taxon_names.size();
+  header.tree_count = trees.size();
+
+  bos << header;
+
+  for (const auto& label: taxon_names)
+    bos << label;
+
+  /* compute tree offsets in advance, so that the index can precede the tree block */
+  std::vector<uint64_t> offsets(trees.size() + 1, 0);
+  for (size_t i = 0; i < trees.size(); ++i)
+  {
+    offsets[i+1] = offsets[i] +
+        BinaryStream::serialized_size(CompactTopology(trees[i], header.brlen_fmt));
+  }
+
+  bos << offsets;
+
+  for (const auto& topol: trees)
+    bos << CompactTopology(topol, header.brlen_fmt);
+
+  return stream;
+}
+
+RBTStream& operator>>(RBTStream& stream, RBTStream::RBTOutput out)
+{
+  BinaryFileStream bos(stream.fname(), std::ios::in);
+  auto header = read_header(bos);
+
+  auto& taxon_names = std::get<0>(out);
+  auto& trees = std::get<1>(out);
+
+  taxon_names.assign(header.taxon_count, "");
+  for (auto& taxon: taxon_names)
+    bos >> taxon;
+
+  /* sequential read -> index is not needed */
+  bos.get<std::vector<uint64_t>>();
+
+  trees.clear();
+  for (size_t i = 0; i < header.tree_count; ++i)
+  {
+    TreeTopology topol;
+    bos >> CompactTopologyRef(topol, header.brlen_fmt);
+
+    if (!bos.good())
+      throw runtime_error("RBTStream: unexpected end of file: " + stream.fname());
+
+    check_topology(topol, header.taxon_count, i);
+    trees.emplace_back(std::move(topol));
+  }
+
+  return stream;
+}
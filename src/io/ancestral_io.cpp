@@ -1,48 +1,138 @@
+#include <algorithm>
+#include <cmath>
+
 #include "file_io.hpp"
 
 using namespace std;
 
+const uint64_t ASR_BIN_MAGIC    = *(reinterpret_cast<const uint64_t*>("RAPF\x13\x12\x17\x0A"));
+const uint32_t ASR_BIN_VERSION  = 1;
+
+template<typename T>
+static void write_raw(std::ostream& stream, const T& v)
+{
+  stream.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+static void write_raw(std::ostream& stream, const std::string& s)
+{
+  write_raw(stream, (uint64_t) s.length());
+  stream.write(s.c_str(), s.length());
+}
+
+/*
+ *  Binary layout (little-endian, native):
+ *    magic | version | format (1=float32, 2=uint8) | #states | #parts | #sites per part |
+ *    #nodes | state names | { node name | part1 probs | part2 probs | ... } x #nodes
+ *
+ *  uint8 probabilities are quantized as round(p * 255).
+ */
+static void write_binary_probs(AncestralProbStream& stream, const AncestralStates& ancestral)
+{
+  auto num_parts = ancestral.num_parts();
+
+  if (stream.print_header())
+  {
+    write_raw(stream, ASR_BIN_MAGIC);
+    write_raw(stream, ASR_BIN_VERSION);
+    write_raw(stream, (uint32_t) stream.prob_format());
+    write_raw(stream, (uint64_t) ancestral.num_states);
+    write_raw(stream, (uint64_t) num_parts);
+    for (size_t p = 0; p < num_parts; ++p)
+      write_raw(stream, (uint64_t) ancestral.num_out_sites(p));
+    write_raw(stream, (uint64_t) ancestral.num_selected_nodes());
+    for (const auto& s: ancestral.state_names)
+      write_raw(stream, s);
+    stream.print_header(false);
+  }
+
+  std::vector<float> fbuf;
+  std::vector<uint8_t> qbuf;
+  for (size_t i = 0; i < ancestral.num_block_nodes(); ++i)
+  {
+    write_raw(stream, ancestral.block_node_name(i));
+
+    for (size_t p = 0; p < num_parts; ++p)
+    {
+      const auto& probvec = ancestral.probs.at(p).at(i);
+      auto num_sites = ancestral.num_out_sites(p);
+      auto num_states = ancestral.num_states;
+      if (stream.prob_format() == AncestralProbFormat::float32)
+      {
+        fbuf.resize(num_sites * num_states);
+        for (size_t j = 0; j < num_sites; ++j)
+        {
+          auto prob = probvec.cbegin() + ancestral.site_pattern(p, j) * num_states;
+          std::copy(prob, prob + num_states, fbuf.begin() + j * num_states);
+        }
+        stream.write(reinterpret_cast<const char*>(fbuf.data()), fbuf.size() * sizeof(float));
+      }
+      else
+      {
+        qbuf.resize(num_sites * num_states);
+        for (size_t j = 0; j < num_sites; ++j)
+        {
+          auto prob = probvec.cbegin() + ancestral.site_pattern(p, j) * num_states;
+          for (size_t k = 0; k < num_states; ++k)
+            qbuf[j * num_states + k] = (uint8_t) std::round(std::max(0., std::min(prob[k], 1.)) * 255.);
+        }
+        stream.write(reinterpret_cast<const char*>(qbuf.data()), qbuf.size());
+      }
+    }
+  }
+}
+
 AncestralProbStream& operator<<(AncestralProbStream& stream, const AncestralStates& ancestral)
 {
+  if (stream.prob_format() != AncestralProbFormat::text)
+  {
+    write_binary_probs(stream, ancestral);
+    return stream;
+  }
+
   auto delim = stream.delim();
   stream << fixed << setprecision(stream.precision());
 
   auto num_parts = ancestral.num_parts();
 
   /* print header line */
-  stream << "Node";
-  if (num_parts > 1)
-    stream << delim << "Part";
-  stream << delim << "Site" << delim << "State ";
+  if (stream.print_header())
+  {
+    stream << "Node";
+    if (num_parts > 1)
+      stream << delim << "Part";
+    stream << delim << "Site" << delim << "State ";
 
-  for (const auto& s: ancestral.state_names)
-    stream << delim << "p_" << s;
-  stream << endl;
+    for (const auto& s: ancestral.state_names)
+      stream << delim << "p_" << s;
+    stream << endl;
+
+    stream.print_header(false);
+  }
 
   assert(ancestral.probs.size() == num_parts);
-  for (size_t i = 0; i < ancestral.num_nodes; ++i)
+  for (size_t i = 0; i < ancestral.num_block_nodes(); ++i)
   {
-    string node_name = i < ancestral.node_names.size() ?
-                          ancestral.node_names.at(i) : ("Node" + to_string(i+1));
+    const auto& node_name = ancestral.block_node_name(i);
 
     for (size_t p = 0; p < num_parts; ++p)
     {
-      auto num_sites = ancestral.part_num_sites[p];
+      auto num_sites = ancestral.num_out_sites(p);
       const auto& probvec = ancestral.probs.at(p).at(i);
       const auto& seq = ancestral.ml_state_seq(i, p);
 
-      assert(probvec.size() == num_sites * ancestral.num_states);
+      assert(probvec.size() == ancestral.part_num_sites[p] * ancestral.num_states);
 
-      auto prob = probvec.cbegin();
       for (size_t j = 0; j < num_sites; ++j)
       {
+        auto prob = probvec.cbegin() + ancestral.site_pattern(p, j) * ancestral.num_states;
         stream << node_name;
         if (num_parts > 1)
           stream << delim << (p+1);
         stream << delim << (j+1) << delim << seq[j];
         for (size_t k = 0; k < ancestral.num_states; ++k)
           stream << delim << *prob++;
-        stream << endl;
+        stream << "\n";
       }
     }
 
@@ -57,12 +147,9 @@ AncestralStateStream& operator<<(AncestralStateStream& stream, const AncestralSt
 
   auto num_parts = ancestral.num_parts();
   assert(ancestral.probs.size() == num_parts);
-  for (size_t i = 0; i < ancestral.num_nodes; ++i)
+  for (size_t i = 0; i < ancestral.num_block_nodes(); ++i)
   {
-    string node_name = i < ancestral.node_names.size() ?
-                          ancestral.node_names.at(i) : ("Node" + to_string(i));
-
-    stream << node_name << delim;
+    stream << ancestral.block_node_name(i) << delim;
     for (size_t p = 0; p < num_parts; ++p)
       stream << ancestral.ml_state_seq(i, p);
     stream << endl;
@@ -268,6 +268,147 @@ BasicBinaryStream& operator>>(BasicBinaryStream& stream, TreeTopology& t)
   return stream;
 }
 
+void put_varint(BasicBinaryStream& stream, uint64_t v)
+{
+  /* LEB128: 7 bits per byte, MSB set on all but the last byte */
+  unsigned char buf[10];
+  size_t n = 0;
+  do
+  {
+    buf[n] = v & 0x7F;
+    v >>= 7;
+    if (v)
+      buf[n] |= 0x80;
+    n++;
+  }
+  while (v);
+
+  stream.put(buf, n);
+}
+
+uint64_t get_varint(BasicBinaryStream& stream)
+{
+  uint64_t v = 0;
+  unsigned char b = 0;
+  unsigned int shift = 0;
+  do
+  {
+    if (shift > 63)
+      throw std::runtime_error("Invalid varint in binary stream");
+    stream.get(&b, 1);
+    v |= ((uint64_t) (b & 0x7F)) << shift;
+    shift += 7;
+  }
+  while (b & 0x80);
+
+  return v;
+}
+
+/* branch lengths are quantized on a log scale over [RAXML_BRLEN_MIN, RAXML_BRLEN_MAX] */
+static const double BRLEN_QUANT_LOGMIN = log(RAXML_BRLEN_MIN);
+static const double BRLEN_QUANT_LOGRANGE = log(RAXML_BRLEN_MAX) - log(RAXML_BRLEN_MIN);
+
+static void put_brlen(BasicBinaryStream& stream, double brlen, TreeBrlenFormat fmt)
+{
+  switch (fmt)
+  {
+    case TreeBrlenFormat::none:
+      break;
+    case TreeBrlenFormat::quant16:
+    {
+      double b = std::max(RAXML_BRLEN_MIN, std::min(brlen, RAXML_BRLEN_MAX));
+      double q = (log(b) - BRLEN_QUANT_LOGMIN) / BRLEN_QUANT_LOGRANGE;
+      stream << (uint16_t) std::round(q * UINT16_MAX);
+      break;
+    }
+    case TreeBrlenFormat::float32:
+      stream << (float) brlen;
+      break;
+    case TreeBrlenFormat::full:
+      stream << brlen;
+      break;
+    default:
+      assert(0);
+  }
+}
+
+static double get_brlen(BasicBinaryStream& stream, TreeBrlenFormat fmt)
+{
+  switch (fmt)
+  {
+    case TreeBrlenFormat::none:
+      return RAXML_BRLEN_DEFAULT;
+    case TreeBrlenFormat::quant16:
+    {
+      double q = (double) stream.get<uint16_t>() / UINT16_MAX;
+      return exp(BRLEN_QUANT_LOGMIN + q * BRLEN_QUANT_LOGRANGE);
+    }
+    case TreeBrlenFormat::float32:
+      return (double) stream.get<float>();
+    case TreeBrlenFormat::full:
+      return stream.get<double>();
+    default:
+      assert(0);
+      return 0.;
+  }
+}
+
+BasicBinaryStream& operator<<(BasicBinaryStream& stream, CompactTopology ct)
+{
+  const auto& t = std::get<0>(ct);
+  auto fmt = std::get<1>(ct);
+
+  put_varint(stream, t.vroot_node_id);
+  put_varint(stream, t.edges.size());
+  for (const auto& e: t.edges)
+  {
+    put_varint(stream, e.left_node_id);
+    put_varint(stream, e.right_node_id);
+    put_brlen(stream, e.length, fmt);
+  }
+
+  /* per-partition branch lengths (unlinked/scaled models) */
+  if (fmt == TreeBrlenFormat::none)
+    put_varint(stream, 0);
+  else
+  {
+    put_varint(stream, t.brlens.size());
+    for (const auto& part_brlens: t.brlens)
+    {
+      put_varint(stream, part_brlens.size());
+      for (auto b: part_brlens)
+        put_brlen(stream, b, fmt);
+    }
+  }
+
+  return stream;
+}
+
+BasicBinaryStream& operator>>(BasicBinaryStream& stream, CompactTopologyRef ct)
+{
+  auto& t = std::get<0>(ct);
+  auto fmt = std::get<1>(ct);
+
+  t.vroot_node_id = get_varint(stream);
+  t.edges.resize(get_varint(stream));
+  for (auto& e: t.edges)
+  {
+    e.left_node_id = get_varint(stream);
+    e.right_node_id = get_varint(stream);
+    e.length = get_brlen(stream, fmt);
+  }
+
+  t.brlens.resize(get_varint(stream));
+  for (auto& part_brlens: t.brlens)
+  {
+    part_brlens.resize(get_varint(stream));
+    for (auto& b: part_brlens)
+      b = get_brlen(stream, fmt);
+  }
+
+  return stream;
+}
+
 BasicBinaryStream& operator<<(BasicBinaryStream& stream, const ScoredTopologyMap& c)
 {
   stream << c.size();
@@ -288,6 +429,38 @@ BasicBinaryStream& operator>>(BasicBinaryStream& stream, ScoredTopologyMap& c)
   return stream;
 }
 
+BasicBinaryStream& operator<<(BasicBinaryStream& stream, CompactTopologyMap cc)
+{
+  const auto& c = std::get<0>(cc);
+  auto fmt = std::get<1>(cc);
+
+  put_varint(stream, c.size());
+  for (const auto& tree: c)
+  {
+    put_varint(stream, tree.first);
+    stream << tree.second.first;
+    stream << CompactTopology(tree.second.second, fmt);
+  }
+  return stream;
+}
+
+BasicBinaryStream& operator>>(BasicBinaryStream& stream, CompactTopologyMapRef cc)
+{
+  auto& c = std::get<0>(cc);
+  auto fmt = std::get<1>(cc);
+
+  auto size = get_varint(stream);
+  for (size_t i = 0; i < size; ++i)
+  {
+    auto index = get_varint(stream);
+    auto score = stream.get<double>();
+    TreeTopology topol;
+    stream >> CompactTopologyRef(topol, fmt);
+    c.insert(index, ScoredTopology(score, std::move(topol)));
+  }
+  return stream;
+}
+
 BasicBinaryStream& operator<<(BasicBinaryStream& stream, const MSA& m)
 {
   stream << m.size();
@@ -296,11 +469,7 @@ BasicBinaryStream& operator<<(BasicBinaryStream& stream, const MSA& m)
   stream << m.weights();
 
   for (size_t i = 0; i < m.size(); ++i)
-  {
-    auto seq = m.at(i);
-    assert(seq.length() == m.length());
-    stream.write(seq.c_str(), m.length());
-  }
+    stream.write(m.sequence_data(i), m.length());
 
   return stream;
 }
@@ -382,6 +551,18 @@ BasicBinaryStream& operator>>(BasicBinaryStream& stream, NullMSA)
   return stream;
 }
 
+BasicBinaryStream& operator>>(BasicBinaryStream& stream, MSAWeights mw)
+{
+  auto taxa_count = stream.get<size_t>();
+  auto pat_count = stream.get<size_t>();
+
+  mw.msa = MSA(pat_count);
+  mw.msa.weights(stream.get<WeightVector>());
+  stream.skip(taxa_count * pat_count);
+
+  return stream;
+}
+
 BasicBinaryStream& operator<<(BasicBinaryStream& stream, const PartitionStats& ps)
 {
   stream << ps.site_count;
@@ -450,6 +631,9 @@ BasicBinaryStream& operator<<(BasicBinaryStream& stream, const Options& o)
 
   stream << o.write_bs_msa << o.use_old_constraint;
 
+  stream << o.tree_format << o.tree_brlen_format << o.bsmsa_format;
+  stream << o.asr_prob_format << o.asr_block_size << o.asr_nodes;
+
   return stream;
 }
 
@@ -497,5 +681,11 @@ BasicBinaryStream& operator>>(BasicBinaryStream& stream, Options& o)
   if (o.opt_version >= 2)
     stream >> o.write_bs_msa >> o.use_old_constraint;
 
+  if (o.opt_version >= 3)
+  {
+    stream >> o.tree_format >> o.tree_brlen_format >> o.bsmsa_format;
+    stream >> o.asr_prob_format >> o.asr_block_size >> o.asr_nodes;
+  }
+
   return stream;
 }
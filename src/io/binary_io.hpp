@@ -15,8 +15,20 @@ enum class ModelBinaryFmt
 
 typedef std::tuple<const Model&, ModelBinaryFmt> BinaryModel;
 
+typedef std::tuple<const TreeTopology&, TreeBrlenFormat> CompactTopology;
+typedef std::tuple<TreeTopology&, TreeBrlenFormat> CompactTopologyRef;
+typedef std::tuple<const ScoredTopologyMap&, TreeBrlenFormat> CompactTopologyMap;
+typedef std::tuple<ScoredTopologyMap&, TreeBrlenFormat> CompactTopologyMapRef;
+
 struct NullMSA {};
 
+/* pattern weights only, sequence data is skipped */
+struct MSAWeights
+{
+  MSAWeights(MSA& m) : msa(m) {}
+  MSA& msa;
+};
+
 typedef std::pair<MSA&,RangeList&> MSARange;
 
 BasicBinaryStream& operator<<(BasicBinaryStream& stream, const std::string& s);
@@ -172,6 +184,7 @@ BasicBinaryStream& operator<<(BasicBinaryStream& stream, const MSA& m);
 BasicBinaryStream& operator>>(BasicBinaryStream& stream, MSA& m);
 BasicBinaryStream& operator>>(BasicBinaryStream& stream, MSARange mr);
 BasicBinaryStream& operator>>(BasicBinaryStream& stream, NullMSA);
+BasicBinaryStream& operator>>(BasicBinaryStream& stream, MSAWeights mw);
 
 /**
  * TreeTopology I/O
@@ -179,11 +192,22 @@ BasicBinaryStream& operator>>(BasicBinaryStream& stream, NullMSA);
 BasicBinaryStream& operator<<(BasicBinaryStream& stream, const TreeTopology& t);
 BasicBinaryStream& operator>>(BasicBinaryStream& stream, TreeTopology& t);
 
+/**
+ * Compact TreeTopology I/O: varint-encoded node IDs + (optionally quantized) branch lengths
+ */
+BasicBinaryStream& operator<<(BasicBinaryStream& stream, CompactTopology ct);
+BasicBinaryStream& operator>>(BasicBinaryStream& stream, CompactTopologyRef ct);
+
+void put_varint(BasicBinaryStream& stream, uint64_t v);
+uint64_t get_varint(BasicBinaryStream& stream);
+
 /**
  * TreeCollection I/O
  */
 BasicBinaryStream& operator<<(BasicBinaryStream& stream, const ScoredTopologyMap& c);
 BasicBinaryStream& operator>>(BasicBinaryStream& stream, ScoredTopologyMap& c);
+BasicBinaryStream& operator<<(BasicBinaryStream& stream, CompactTopologyMap cc);
+BasicBinaryStream& operator>>(BasicBinaryStream& stream, CompactTopologyMapRef cc);
 
 /**
  * Options I/O
@@ -60,7 +60,12 @@ private:
 class CATGStream : public MSAFileStream
 {
 public:
-  CATGStream(const std::string& fname) : MSAFileStream(fname) {}
+  CATGStream(const std::string& fname, bool compress_patterns = false) :
+    MSAFileStream(fname), _compress_patterns(compress_patterns) {}
+
+  bool compress_patterns() const { return _compress_patterns; }
+private:
+  bool _compress_patterns;
 };
 
 class RBAStream : public MSAFileStream
@@ -70,7 +75,8 @@ public:
   {
     all = 0,
     metadata,
-    seqdata
+    seqdata,
+    weights     /* pattern weights of all partitions, without sequences */
   };
 
   typedef std::tuple<PartitionedMSA&, RBAElement, PartitionAssignment*> RBAOutput;
@@ -81,6 +87,31 @@ public:
   static bool rba_file(const std::string& fname, bool check_version = false);
 };
 
+/* compact binary format for tree collections (ML trees, bootstrap replicates) */
+class RBTStream
+{
+public:
+  typedef std::tuple<const NameList&, const TreeTopologyList&> RBTInput;
+  typedef std::tuple<NameList&, TreeTopologyList&> RBTOutput;
+
+public:
+  RBTStream(const std::string& fname, TreeBrlenFormat brlen_fmt = TreeBrlenFormat::full) :
+    _fname(fname), _brlen_fmt(brlen_fmt) {}
+
+  const std::string& fname() const { return _fname; };
+  TreeBrlenFormat brlen_format() const { return _brlen_fmt; }
+
+  size_t tree_count() const;
+  NameList taxon_names() const;
+  TreeTopology tree(size_t index) const;
+
+  static bool rbt_file(const std::string& fname);
+
+private:
+  std::string _fname;
+  TreeBrlenFormat _brlen_fmt;
+};
+
 class RaxmlPartitionStream : public std::fstream
 {
 public:
@@ -131,9 +162,20 @@ protected:
 class AncestralProbStream : public FileIOStream
 {
 public:
-  AncestralProbStream(const std::string& fname) : FileIOStream(fname) {};
+  AncestralProbStream(const std::string& fname) : FileIOStream(fname),
+    _prob_format(AncestralProbFormat::text), _print_header(true) {};
   AncestralProbStream(const std::string& fname, std::ios_base::openmode mode) :
-    FileIOStream(fname, mode) {};
+    FileIOStream(fname, mode), _prob_format(AncestralProbFormat::text),
+    _print_header(!(mode & std::ios::app)) {};
+
+  AncestralProbFormat prob_format() const { return _prob_format; }
+  void prob_format(AncestralProbFormat fmt) { _prob_format = fmt; }
+  bool print_header() const { return _print_header; }
+  void print_header(bool value) { _print_header = value; }
+
+private:
+  AncestralProbFormat _prob_format;
+  bool _print_header;
 };
 
 class AncestralStateStream : public FileIOStream
@@ -157,7 +199,8 @@ NewickStream& operator<<(NewickStream& stream, const SupportTree& tree);
 PhylipStream& operator>>(PhylipStream& stream, MSA& msa);
 FastaStream& operator>>(FastaStream& stream, MSA& msa);
 CATGStream& operator>>(CATGStream& stream, MSA& msa);
-MSA msa_load_from_file(const std::string &filename, const FileFormat format);
+MSA msa_load_from_file(const std::string &filename, const FileFormat format,
+                       bool compress_prob = false);
 
 PhylipStream& operator<<(PhylipStream& stream, const MSA& msa);
 PhylipStream& operator<<(PhylipStream& stream, const PartitionedMSA& msa);
@@ -165,9 +208,13 @@ PhylipStream& operator<<(PhylipStream& stream, const PartitionedMSAView& msa);
 PhylipStream& operator<<(PhylipStream& stream, const BootstrapMSA& bs_msa);
 
 RBAStream& operator<<(RBAStream& stream, const PartitionedMSA& part_msa);
+RBAStream& operator<<(RBAStream& stream, const BootstrapMSA& bs_msa);
 RBAStream& operator>>(RBAStream& stream, PartitionedMSA& part_msa);
 RBAStream& operator>>(RBAStream& stream, RBAStream::RBAOutput out);
 
+RBTStream& operator<<(RBTStream& stream, RBTStream::RBTInput in);
+RBTStream& operator>>(RBTStream& stream, RBTStream::RBTOutput out);
+
 RaxmlPartitionStream& operator>>(RaxmlPartitionStream& stream, PartitionInfo& part_info);
 RaxmlPartitionStream& operator>>(RaxmlPartitionStream& stream, PartitionedMSA& parted_msa);
 
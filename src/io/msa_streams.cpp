@@ -151,28 +151,41 @@ PhylipStream& operator<<(PhylipStream& stream, const BootstrapMSA& bs_msa)
   auto sites = msa.total_sites();
   fs << taxa << " " << sites << endl;
 
-  for (size_t i = 0; i < taxa; ++i)
+  /* expand replicate weights into a column index once, then gather for every taxon */
+  std::vector<IDVector> part_site_idx(msa.part_count());
+  for (size_t p = 0; p < msa.part_count(); ++p)
   {
-    fs << msa.taxon_names().at(i) << " ";
-    for (size_t p = 0; p < msa.part_count(); ++p)
-    {
-      const auto& w = bsrep.site_weights.at(p);
-      const auto& m = msa.part_info(p).msa();
-      const auto& seq = m.at(i);
+    const auto& w = bsrep.site_weights.at(p);
+    auto& site_idx = part_site_idx[p];
 
-      assert(w.size() == seq.size());
+    assert(w.size() == msa.part_info(p).msa().length());
 
-      size_t wsum = 0;
-      for (size_t j = 0; j < seq.length(); ++j)
-      {
-        wsum += w[j];
-        for (size_t k = 0; k < w[j]; ++k)
-          fs << seq[j];
-      }
+    site_idx.reserve(msa.part_info(p).msa().num_sites());
+    for (size_t j = 0; j < w.size(); ++j)
+      site_idx.insert(site_idx.end(), w[j], j);
 
-      assert(wsum == m.num_sites());
+    assert(site_idx.size() == msa.part_info(p).msa().num_sites());
+  }
+
+  std::string line(sites, 0);
+  for (size_t i = 0; i < taxa; ++i)
+  {
+    auto out = &line[0];
+    for (size_t p = 0; p < msa.part_count(); ++p)
+    {
+      const auto& site_idx = part_site_idx[p];
+      const auto seq_ptr = msa.part_info(p).msa().sequence_data(i);
+      const auto idx_ptr = site_idx.data();
+      const auto len = site_idx.size();
+      for (size_t j = 0; j < len; ++j)
+        out[j] = seq_ptr[idx_ptr[j]];
+      out += len;
     }
-    fs << endl;
+    assert(out == &line[0] + line.size());
+
+    fs << msa.taxon_names().at(i) << " ";
+    fs.write(line.data(), line.size());
+    fs << "\n";
   }
 
   return stream;
@@ -201,16 +214,14 @@ CATGStream& operator>>(CATGStream& stream, MSA& msa)
 
   LOG_DEBUG << "CATG: taxa: " << taxa_count << ", sites: " << site_count << endl;
 
-  string dummy(site_count, '*');
-
   /* read taxa names */
+  NameList taxon_names;
   try
   {
     string taxon_name;
-    for (size_t i = 0; i < taxa_count; ++i)
+    for (size_t i = 0; i < taxa_count && fs >> taxon_name; ++i)
     {
-      fs >> taxon_name;
-      msa.append(dummy, taxon_name);
+      taxon_names.push_back(taxon_name);
       LOG_DEBUG << "CATG: taxon " << i << ": " << taxon_name << endl;
     }
   }
@@ -219,63 +230,74 @@ CATGStream& operator>>(CATGStream& stream, MSA& msa)
     LOG_DEBUG << e.what() << endl;
   }
 
-  if (msa.size() != taxa_count)
+  if (taxon_names.size() != taxa_count)
     throw runtime_error("Wrong number of taxon labels!");
 
   /* this is mapping for DNA: CATG -> ACGT, for other datatypes we assume 1:1 mapping */
   std::vector<size_t> state_map({1, 0, 3, 2});
 
   string cons_str, prob_str;
+  size_t states = 0;
+  doubleVector column_probs;
 
-  /* read alignment, remember that the matrix is transposed! */
-  for (size_t i = 0; i < msa.num_sites(); ++i)
+  /* read alignment site by site (the matrix is transposed!): every column is quantized and
+   * (optionally) merged with an identical one right away, so we never hold the raw input */
+  for (size_t i = 0; i < site_count; ++i)
   {
     /* read consensus sequences */
-    fs >> cons_str;
+    if (!(fs >> cons_str))
+      throw runtime_error("Unexpected end of file at site " + to_string(i+1) + "!");
 
     LOG_DEBUG << "CATG: site " << i << " consesus seq: " << cons_str << endl;
 
-    if (cons_str.length() != msa.size())
+    if (cons_str.length() != taxa_count)
       throw runtime_error("Wrong length of consensus sequence for site " + to_string(i+1) + "!");
 
-    std::vector<double> probs;
-
-    for (size_t j = 0; j < msa.size(); ++j)
+    for (size_t j = 0; j < taxa_count; ++j)
     {
-      msa[j][i] = cons_str[j];
-
       fs >> prob_str;
 
-      if (msa.states() == 0)
+      if (!states)
       {
-        auto states = std::count_if(prob_str.cbegin(), prob_str.cend(),
-                                    [](char c) -> bool { return c == ','; }) + 1;
-        msa.states(states);
+        states = std::count_if(prob_str.cbegin(), prob_str.cend(),
+                               [](char c) -> bool { return c == ','; }) + 1;
 
         /* see above: for datatypes other than DNA we assume 1:1 mapping */
         if (states != 4)
           state_map.clear();
 
+        msa.init_prob_columns(taxon_names, states);
+        column_probs.resize(taxa_count * states);
+
         LOG_DEBUG << "CATG: number of states: " << states << endl;
       }
 
-      auto site_probs = msa.probs(j, i);
+      auto site_probs = column_probs.begin() + j * states;
 
       istringstream ss(prob_str);
       size_t k = 0;
       for (string token; getline(ss, token, ','); ++k)
       {
-        if (state_map.empty())
+        if (k >= states)
+          break;
+        else if (state_map.empty())
           site_probs[k] = stod(token);
         else
           site_probs[state_map[k]] = stod(token);
       }
 
-      if (k != msa.states())
+      if (k != states || ss)
         throw runtime_error("Wrong number of state probabilities for site " + to_string(i+1) + "!");
     }
+
+    msa.append_prob_column(cons_str, column_probs, stream.compress_patterns());
   }
 
+  msa.finalize_prob_columns();
+
+  LOG_DEBUG << "CATG: patterns: " << msa.length() << ", uncertain sites stored as probability vectors: " <<
+      msa.uncertain_sites() << " / " << msa.size() * msa.length() << endl;
+
 #ifdef CATG_DEBUG
   {
     PhylipStream ps("catgout.phy");
@@ -286,7 +308,8 @@ CATGStream& operator>>(CATGStream& stream, MSA& msa)
   return stream;
 }
 
-MSA msa_load_from_file(const std::string &filename, const FileFormat format)
+MSA msa_load_from_file(const std::string &filename, const FileFormat format,
+                       bool compress_prob)
 {
   MSA msa;
 
@@ -349,7 +372,7 @@ MSA msa_load_from_file(const std::string &filename, const FileFormat format)
         }
         case FileFormat::catg:
         {
-          CATGStream s(filename);
+          CATGStream s(filename, compress_prob);
           s >> msa;
           return msa;
           break;
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <stdexcept>
 
 #include "CoarseLoadBalancer.hpp"
@@ -34,6 +35,27 @@ CoarseAssignment CoarseLoadBalancer::get_proc_assignments(const CoarseAssignment
     return compute_assignments(search_ids, num_workers).at(worker_id);
 }
 
+void CoarseLoadBalancer::get_pipelined_assignments(const CoarseAssignment& ml_ids,
+                                                   const CoarseAssignment& bs_ids,
+                                                   size_t num_workers, double ml_cost,
+                                                   CoarseAssignmentList& ml_assign,
+                                                   CoarseAssignmentList& bs_assign)
+{
+  ml_assign = get_all_assignments(ml_ids, num_workers);
+  ml_assign.resize(num_workers);
+  bs_assign.assign(num_workers, CoarseAssignment());
+
+  std::vector<double> load(num_workers);
+  for (size_t w = 0; w < num_workers; ++w)
+    load[w] = ml_assign[w].size() * ml_cost;
+
+  for (auto id: bs_ids)
+  {
+    size_t w = std::min_element(load.cbegin(), load.cend()) - load.cbegin();
+    bs_assign[w].push_back(id);
+    load[w] += 1.;
+  }
+}
 
 CoarseAssignmentList SimpleCoarseLoadBalancer::compute_assignments(const CoarseAssignment& search_ids,
                                                  size_t num_workers)
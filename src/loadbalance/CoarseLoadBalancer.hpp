@@ -19,6 +19,12 @@ public:
   CoarseAssignment get_proc_assignments(const CoarseAssignment& search_ids,
                                            size_t num_workers, size_t worker_id);
 
+  /* pipelined ML+BS run: ML searches are distributed as above, BS replicates go to the
+   * worker with the lowest estimated load (one ML search costs ml_cost replicates) */
+  void get_pipelined_assignments(const CoarseAssignment& ml_ids, const CoarseAssignment& bs_ids,
+                                 size_t num_workers, double ml_cost,
+                                 CoarseAssignmentList& ml_assign, CoarseAssignmentList& bs_assign);
+
 protected:
   virtual CoarseAssignmentList compute_assignments(const CoarseAssignment& search_ids,
                                                    size_t num_workers) = 0;
@@ -33,6 +33,7 @@
 #include "PartitionInfo.hpp"
 #include "PartitionedMSAView.hpp"
 #include "ParsimonyMSA.hpp"
+#include "MSAChecker.hpp"
 #include "TreeInfo.hpp"
 #include "io/file_io.hpp"
 #include "io/binary_io.hpp"
@@ -48,6 +49,7 @@
 #include "topology/RFDistCalculator.hpp"
 #include "topology/ConstraintTree.hpp"
 #include "util/EnergyMonitor.hpp"
+#include "util/RunBudget.hpp"
 
 #ifdef _RAXML_TERRAPHAST
 #include "terraces/TerraceWrapper.hpp"
@@ -77,6 +79,9 @@ struct RaxmlInstance
   BootstrapReplicateList bs_reps;
   TreeList bs_start_trees;
 
+  /* RBA partial loading: pattern weights of the whole alignment (-> bootstrap replicates) */
+  WeightVectorList part_weights;
+
   intVector bs_seeds;
 
   /* IDs of the trees that have been already inferred (eg after resuming from a checkpoint) */
@@ -92,7 +97,9 @@ struct RaxmlInstance
   unique_ptr<BootstopCheckMRE> bootstop_checker;
   bool bs_converged;
   RaxmlRunPhase run_phase;
+  size_t max_worker_tasks;    /* pipelined mode: max. number of ML+BS searches per worker */
   double used_wh;
+  EnergyCounterList energy_phases;
 
   // mapping taxon name -> tip_id/clv_id in the tree
   NameIdMap tip_id_map;
@@ -100,7 +107,10 @@ struct RaxmlInstance
   // mapping tip_id in the tree (array index) -> sequence index in MSA
   IDVector tip_msa_idmap;
 
- // unique_ptr<TerraceWrapper> terrace_wrapper;
+#ifdef _RAXML_TERRAPHAST
+  /* partition presence matrix + terrace sizes of already checked topologies */
+  TerraceCacheSharedPtr terrace_cache;
+#endif
 
 //  unique_ptr<RandomGenerator> starttree_seed_gen;
 //  unique_ptr<RandomGenerator> bootstrap_seed_gen;
@@ -123,7 +133,8 @@ struct RaxmlInstance
   vector<RaxmlWorker> workers;
   RaxmlWorker& get_worker() { return workers.at(ParallelContext::local_group_id()); }
 
-  RaxmlInstance() : bs_converged(false), run_phase(RaxmlRunPhase::start), used_wh(0) {}
+  RaxmlInstance() : bs_converged(false), run_phase(RaxmlRunPhase::start), max_worker_tasks(0),
+    used_wh(0) {}
 };
 
 struct RaxmlWorker
@@ -369,14 +380,11 @@ bool check_msa(RaxmlInstance& instance)
 
   const auto& opts = instance.opts;
   auto& parted_msa = *instance.parted_msa;
-  const auto& full_msa = parted_msa.full_msa();
-  const auto pll_msa = full_msa.pll_msa();
 
   bool msa_valid = true;
   bool msa_corrected = false;
   PartitionedMSAView parted_msa_view(instance.parted_msa);
 
-  vector<pair<size_t,size_t> > dup_taxa;
   vector<pair<size_t,size_t> > dup_seqs;
   std::set<size_t> gap_seqs;
 
@@ -399,69 +407,50 @@ bool check_msa(RaxmlInstance& instance)
     msa_valid &= parted_msa_view.taxon_name_map().empty();
   }
 
-  /* check for duplicate sequences */
-  if (opts.safety_checks.isset(SafetyCheck::msa_dups))
-  {
-    unsigned long stats_mask = PLLMOD_MSA_STATS_DUP_SEQS;
+  /* check for duplicate sequences, invalid characters, all-gap columns and sequences:
+   * one parallel sweep over all partitions */
+  const bool check_dups = opts.safety_checks.isset(SafetyCheck::msa_dups);
+  const bool check_gaps = opts.safety_checks.isset(SafetyCheck::msa_allgaps);
 
-    pllmod_msa_stats_t * stats = pllmod_msa_compute_stats(pll_msa,
-                                                          4,
-                                                          pll_map_nt, // map is not used here
-                                                          NULL,
-                                                          stats_mask);
+  auto num_threads = opts.num_threads ? opts.num_threads : opts.num_threads_max;
+  num_threads = std::max<unsigned int>(1, std::min<size_t>(num_threads, parted_msa.taxon_count()));
 
-    libpll_check_error("ERROR computing MSA stats");
-    assert(stats);
+  MSAChecker checker(parted_msa, check_dups, check_gaps, num_threads);
+  auto thread_fn = std::bind(&MSAChecker::thread_check, &checker);
+  ParallelContext::init_pthreads_custom(opts, thread_fn, num_threads, num_threads);
+  thread_fn();
+  ParallelContext::finalize_threads();
+  checker.finalize();
 
-    for (unsigned long c = 0; c < stats->dup_seqs_pairs_count; ++c)
+  dup_seqs = checker.dup_seqs();
+
+  std::set<size_t> invalid_parts;
+  if (!checker.invalid_chars().empty())
+  {
+    msa_valid = false;
+    LOG_ERROR << endl;
+    for (const auto& e: checker.invalid_chars())
     {
-      dup_seqs.emplace_back(stats->dup_seqs_pairs[c*2],
-                            stats->dup_seqs_pairs[c*2+1]);
+      auto global_pos = parted_msa.full_msa_site(e.part_id, e.site);
+      LOG_ERROR << "ERROR: Invalid character in sequence " <<  e.seq_id+1
+                << " at position " <<  global_pos+1  << ": " << e.c << endl;
+      invalid_parts.insert(e.part_id);
     }
-
-    pllmod_msa_destroy_stats(stats);
   }
 
   size_t total_gap_cols = 0;
-  size_t part_num = 0;
-  for (auto& pinfo: parted_msa.part_list())
+  if (check_gaps)
   {
-    /* check for invalid MSA characters */
-    pllmod_msa_errors_t * errs = pllmod_msa_check(pinfo.msa().pll_msa(),
-                                                  pinfo.model().charmap());
-
-    if (errs)
+    for (size_t part_num = 0; part_num < parted_msa.part_count(); ++part_num)
     {
-      if (errs->invalid_char_count > 0)
-      {
-        msa_valid = false;
-        LOG_ERROR << endl;
-        for (unsigned long c = 0; c < errs->invalid_char_count; ++c)
-        {
-          auto global_pos = parted_msa.full_msa_site(part_num, errs->invalid_char_pos[c]);
-          LOG_ERROR << "ERROR: Invalid character in sequence " <<  errs->invalid_char_seq[c]+1
-                    << " at position " <<  global_pos+1  << ": " << errs->invalid_chars[c] << endl;
-        }
-        part_num++;
+      if (invalid_parts.count(part_num))
         continue;
-      }
-      pllmod_msa_destroy_errors(errs);
-    }
-    else
-      libpll_check_error("MSA check failed");
-
-
-    /* Check for all-gap columns and sequences */
-    if (opts.safety_checks.isset(SafetyCheck::msa_allgaps))
-    {
-      unsigned long stats_mask = PLLMOD_MSA_STATS_GAP_SEQS | PLLMOD_MSA_STATS_GAP_COLS;
 
-      pllmod_msa_stats_t * stats = pinfo.compute_stats(stats_mask);
-
-      if (stats->gap_cols_count > 0)
+      auto& pinfo = parted_msa.part_list().at(part_num);
+      const auto& gap_cols = checker.gap_cols().at(part_num);
+      if (!gap_cols.empty())
       {
-        total_gap_cols += stats->gap_cols_count;
-        std::vector<size_t> gap_cols(stats->gap_cols, stats->gap_cols + stats->gap_cols_count);
+        total_gap_cols += gap_cols.size();
         if (gap_cols.size() < pinfo.msa().length() && opts.command != Command::sitelh)
         {
           /* Normally, we just remove all-gap columns immediately */
@@ -475,28 +464,9 @@ bool check_msa(RaxmlInstance& instance)
           parted_msa_view.exclude_sites(part_num, gap_cols);
         }
       }
-
-      std::set<size_t> cur_gap_seq(stats->gap_seqs, stats->gap_seqs + stats->gap_seqs_count);
-
-      if (!part_num)
-      {
-        gap_seqs = cur_gap_seq;
-      }
-      else
-      {
-        for(auto it = gap_seqs.begin(); it != gap_seqs.end();)
-        {
-          if(cur_gap_seq.find(*it) == cur_gap_seq.end())
-            it = gap_seqs.erase(it);
-          else
-            ++it;
-        }
-      }
-
-      pllmod_msa_destroy_stats(stats);
     }
 
-    part_num++;
+    gap_seqs = checker.gap_seqs();
   }
 
   if (total_gap_cols > 0)
@@ -806,8 +776,6 @@ void check_options_early(Options& opts)
 
   if (opts.command == Command::ancestral)
   {
-    if (opts.use_pattern_compression)
-      throw runtime_error("Pattern compression is not supported in ancestral state reconstruction mode!");
     if (opts.use_repeats)
       throw runtime_error("Site repeats are not supported in ancestral state reconstruction mode!");
     if (opts.use_rate_scalers)
@@ -824,12 +792,20 @@ void check_options_early(Options& opts)
       throw runtime_error("Custom site weights are not supported in per-site likelihood computation mode!");
   }
 
+  /* node-shared MSA is only useful with multiple ranks, and it requires full MSA on every rank */
+  opts.use_shared_msa &= (opts.num_ranks > 1);
+  opts.use_rba_partload &= !opts.use_shared_msa;
+
   /* autodetect if we can use partial RBA loading */
   opts.use_rba_partload &= (opts.num_ranks > 1 && !opts.coarse());                // only useful for fine-grain MPI runs
   opts.use_rba_partload &= (!opts.start_trees.count(StartingTree::parsimony));    // does not work with parsimony
-  opts.use_rba_partload &= (opts.command == Command::search ||                    // currently doesn't work with bootstrap
+  opts.use_rba_partload &= (opts.command == Command::search ||
                             opts.command == Command::evaluate ||
-                            opts.command == Command::ancestral);
+                            opts.command == Command::ancestral ||
+                            /* bootstrap replicates are drawn from the pattern weights, but
+                             * parsimony starting trees and replicate MSAs need all sites */
+                            ((opts.command == Command::bootstrap || opts.command == Command::all) &&
+                             !opts.use_bs_pars && !opts.write_bs_msa));
 
   LOG_DEBUG << "RBA partial loading: " << (opts.use_rba_partload ? "ON" : "OFF") << endl;
 }
@@ -1076,7 +1052,18 @@ void load_msa(RaxmlInstance& instance)
   LOG_INFO_TS << "Reading alignment from file: " << opts.msa_file << endl;
 
   /* load MSA */
-  auto msa = msa_load_from_file(opts.msa_file, opts.msa_format);
+  /* probabilistic (CATG) alignments are pattern-compressed while reading, unless
+   * site weights or partition ranges refer to the original, uncompressed columns.
+   * Without --prob-msa, the consensus sequences are compressed later as usual */
+  bool compress_prob = opts.use_prob_msa && opts.use_pattern_compression &&
+                       opts.weights_file.empty() && parted_msa.part_count() == 1;
+  if (compress_prob)
+  {
+    const auto& range = parted_msa.part_info(0).range_string();
+    compress_prob = range.empty() || range == "all";
+  }
+
+  auto msa = msa_load_from_file(opts.msa_file, opts.msa_format, compress_prob);
 
   if (!msa.size())
     throw runtime_error("Alignment file is empty!");
@@ -1086,6 +1073,9 @@ void load_msa(RaxmlInstance& instance)
 
   if (msa.probabilistic() && opts.use_prob_msa)
   {
+    LOG_INFO << "NOTE: State probabilities are normalized per site and stored with "
+             << "16-bit precision" << endl;
+
     instance.opts.use_pattern_compression = false;
     instance.opts.use_tip_inner = false;
     instance.opts.use_repeats = false;
@@ -1114,7 +1104,7 @@ void load_msa(RaxmlInstance& instance)
   if (opts.use_pattern_compression)
   {
     LOG_VERB_TS << "Compressing alignment patterns... " << endl;
-    bool store_backmap = opts.command == Command::sitelh;
+    bool store_backmap = opts.command == Command::sitelh || opts.command == Command::ancestral;
     parted_msa.compress_patterns(store_backmap);
 
     // temp workaround: since MSA pattern compression calls rand(), it will change all random
@@ -1123,9 +1113,6 @@ void load_msa(RaxmlInstance& instance)
     srand(opts.random_seed);
   }
 
-//  if (parted_msa.part_count() > 1)
-//    instance.terrace_wrapper.reset(new TerraceWrapper(parted_msa));
-
   parted_msa.set_model_empirical_params();
 
   check_models(instance);
@@ -1312,31 +1299,45 @@ void load_checkpoint(RaxmlInstance& instance, CheckpointManager& cm)
 
     ParallelContext::mpi_broadcast(instance.run_phase);
 
-    /* gather in-progress tree ids */
-    auto& in_work_trees = instance.run_phase == RaxmlRunPhase::bootstrap ?
-        instance.done_bs_trees : instance.done_ml_trees;
+    /* before v9, checkpoint did not store the tree type -> derive it from the run phase */
+    if (ckpfile.version < 9)
+    {
+      for (size_t i = 0; i < ckpfile.checkp_list.size(); ++i)
+        cm.checkpoint(i).bs_tree = instance.run_phase == RaxmlRunPhase::bootstrap;
+    }
+
+    /* gather in-progress tree ids: with pipelining, some workers might be in ML search
+     * while others are already bootstrapping */
+    auto& in_work_ml_trees = instance.done_ml_trees;
+    auto& in_work_bs_trees = instance.done_bs_trees;
     for (auto& c: ckpfile.checkp_list)
     {
       if (c.tree_index > 0)
-        in_work_trees.insert(c.tree_index);
+        (c.bs_tree ? in_work_bs_trees : in_work_ml_trees).insert(c.tree_index);
     }
 
     /* in coarse+MPI mode, collect in-progress tree ids from all ranks */
     if (instance.opts.coarse() && ParallelContext::num_ranks() > 1)
     {
-      auto worker_cb = [&in_work_trees](void * buf, size_t buf_size) -> size_t
+      auto worker_cb = [&in_work_ml_trees, &in_work_bs_trees](void * buf, size_t buf_size) -> size_t
           {
-            return BinaryStream::serialize((char*) buf, buf_size, in_work_trees);
+            BinaryStream bs((char*) buf, buf_size);
+
+            bs << in_work_ml_trees << in_work_bs_trees;
+
+            return bs.pos();
           };
 
       /* receive callback -> master rank */
-      auto master_cb = [&in_work_trees](void * buf, size_t buf_size, size_t /* rank */)
+      auto master_cb = [&in_work_ml_trees, &in_work_bs_trees](void * buf, size_t buf_size,
+                                                              size_t /* rank */)
          {
            BinaryStream bs((char*) buf, buf_size);
 
-           IDSet recv_trees;
-           bs >> recv_trees;
-           in_work_trees.insert(recv_trees.cbegin(), recv_trees.cend());
+           IDSet recv_ml_trees, recv_bs_trees;
+           bs >> recv_ml_trees >> recv_bs_trees;
+           in_work_ml_trees.insert(recv_ml_trees.cbegin(), recv_ml_trees.cend());
+           in_work_bs_trees.insert(recv_bs_trees.cbegin(), recv_bs_trees.cend());
          };
 
       ParallelContext::mpi_gather_custom(worker_cb, master_cb);
@@ -1504,6 +1505,8 @@ void build_start_trees(RaxmlInstance& instance, unsigned int num_threads = 1)
   if (instance.start_trees.size() >= instance.opts.num_searches)
     return;
 
+  global_energy_monitor.phase(EnergyPhase::start_trees);
+
   for (auto& st_tree: opts.start_trees)
   {
     auto st_tree_type = st_tree.first;
@@ -1587,6 +1590,8 @@ void build_start_trees(RaxmlInstance& instance, unsigned int num_threads = 1)
     for (auto const& tree: instance.start_trees)
       nw_start << tree;
   }
+
+  global_energy_monitor.phase(EnergyPhase::other);
 }
 
 void balance_load(RaxmlInstance& instance)
@@ -1608,6 +1613,35 @@ void balance_load(RaxmlInstance& instance)
   LOG_VERB << endl << instance.proc_part_assign;
 }
 
+void share_msa(RaxmlInstance& instance)
+{
+  /* move alignment data into node-local shared memory: it is provided by the node master rank,
+   * all other ranks on the same node drop their private copies and map the shared segment */
+  auto& parted_msa = *instance.parted_msa;
+
+  /* unpartitioned copy is not needed anymore after split_msa() */
+  parted_msa.release_full_msa();
+
+  size_t total_size = 0;
+  for (const auto& pinfo: parted_msa.part_list())
+    total_size += pinfo.msa().size() * pinfo.msa().length();
+
+  auto buf = ParallelContext::alloc_node_shared(total_size);
+  const bool node_master = ParallelContext::node_master_rank();
+  for (auto& pinfo: parted_msa.part_list())
+  {
+    auto& msa = pinfo.msa();
+    const auto part_size = msa.size() * msa.length();
+    msa.share_sequences(buf, node_master);
+    buf += part_size;
+  }
+
+  ParallelContext::node_shared_sync();
+
+  LOG_VERB_TS << "Alignment moved to node-local shared memory ("
+              << total_size / (1024 * 1024) << " MB per node)" << endl;
+}
+
 PartitionAssignmentList balance_load(RaxmlInstance& instance, WeightVectorList part_site_weights)
 {
   /* This function is used to re-distribute sites across processes for each bootstrap replicate.
@@ -1669,6 +1703,12 @@ PartitionAssignmentList balance_load(RaxmlInstance& instance, WeightVectorList p
   return assign_list;
 }
 
+bool pipelined_run(const RaxmlInstance& instance)
+{
+  return instance.opts.command == Command::all && instance.opts.use_pipeline &&
+         ParallelContext::num_groups() > 1 && !instance.start_trees.empty();
+}
+
 void balance_load_coarse(RaxmlInstance& instance, const CheckpointFile& ckpfile)
 {
   auto num_workers = ParallelContext::num_groups();
@@ -1687,8 +1727,30 @@ void balance_load_coarse(RaxmlInstance& instance, const CheckpointFile& ckpfile)
   }
 
   /* distribute ML and BS tree searches */
-  CoarseAssignmentList start_tree_assign = instance.coarse_load_balancer->get_all_assignments(todo_start_trees, num_workers);
-  CoarseAssignmentList bs_tree_assign = instance.coarse_load_balancer->get_all_assignments(todo_bs_trees, num_workers);
+  CoarseAssignmentList start_tree_assign, bs_tree_assign;
+  if (pipelined_run(instance))
+  {
+    /* workers with fewer ML searches do more bootstrapping */
+    instance.coarse_load_balancer->get_pipelined_assignments(todo_start_trees, todo_bs_trees,
+                                                             num_workers, RAXML_PIPELINE_ML_COST,
+                                                             start_tree_assign, bs_tree_assign);
+
+    instance.max_worker_tasks = 0;
+    for (size_t w = 0; w < num_workers; ++w)
+    {
+      instance.max_worker_tasks = std::max(instance.max_worker_tasks,
+                                           start_tree_assign[w].size() + bs_tree_assign[w].size());
+    }
+
+    /* in-progress trees from a checkpoint are re-assigned to the same worker (see below) */
+    if (!instance.done_ml_trees.empty() || !instance.done_bs_trees.empty())
+      instance.max_worker_tasks++;
+  }
+  else
+  {
+    start_tree_assign = instance.coarse_load_balancer->get_all_assignments(todo_start_trees, num_workers);
+    bs_tree_assign = instance.coarse_load_balancer->get_all_assignments(todo_bs_trees, num_workers);
+  }
 
   assert(instance.workers.size() == ckpfile.checkp_list.size());
   for (size_t i = 0; i < instance.workers.size(); ++i)
@@ -1699,7 +1761,7 @@ void balance_load_coarse(RaxmlInstance& instance, const CheckpointFile& ckpfile)
 
     /* add current tree from a checkpoint */
     auto& ckp = ckpfile.checkp_list[i];
-    auto& in_work_trees = instance.run_phase == RaxmlRunPhase::bootstrap ? wrk.bs_trees : wrk.start_trees;
+    auto& in_work_trees = ckp.bs_tree ? wrk.bs_trees : wrk.start_trees;
     if (ckp.tree_index > 0)
       in_work_trees.insert(in_work_trees.begin(), ckp.tree_index);
   }
@@ -1708,6 +1770,14 @@ void balance_load_coarse(RaxmlInstance& instance, const CheckpointFile& ckpfile)
               << instance.workers.at(0).total_num_searches() << endl;
 }
 
+BootstrapReplicate generate_bs_replicate(const RaxmlInstance& instance, BootstrapGenerator& bg,
+                                         unsigned long random_seed)
+{
+  /* with RBA partial loading, the local MSA only holds the weights of its own segments */
+  return instance.part_weights.empty() ? bg.generate(*instance.parted_msa, random_seed) :
+                                         bg.generate(instance.part_weights, random_seed);
+}
+
 void generate_bootstraps(RaxmlInstance& instance, const CheckpointFile& checkp)
 {
   if (instance.opts.command == Command::bootstrap || instance.opts.command == Command::all ||
@@ -1721,7 +1791,8 @@ void generate_bootstraps(RaxmlInstance& instance, const CheckpointFile& checkp)
     for (size_t i = 0; i < seeds.size(); ++i)
       seeds[i] = rand();
 
-    build_parsimony_msa(instance);
+    if (instance.opts.use_bs_pars)
+      build_parsimony_msa(instance);
 
     /* in parallel parsimony mode, starting trees & replicate MSAs will be generated later "just-in-time" */
     if (instance.opts.use_par_pars)
@@ -1747,7 +1818,7 @@ void generate_bootstraps(RaxmlInstance& instance, const CheckpointFile& checkp)
 //      if (b < checkp.bs_trees.size())
 //        continue;
 
-      instance.bs_reps.emplace_back(bg.generate(*instance.parted_msa, seeds[b]));
+      instance.bs_reps.emplace_back(generate_bs_replicate(instance, bg, seeds[b]));
     }
   }
   RAXML_UNUSED(checkp); // might need it again for re-using previously computed replicates
@@ -1761,6 +1832,36 @@ void init_ancestral(RaxmlInstance& instance)
     const Tree& tree = instance.start_trees.at(0);
 
     instance.ancestral_states = make_shared<AncestralStates>(tree.num_inner(), parted_msa);
+
+    for (const auto& pinfo: parted_msa.part_list())
+    {
+      if (pinfo.msa().length() != pinfo.msa().num_sites() && pinfo.msa().site_pattern_map().empty())
+      {
+        LOG_WARN << "WARNING: Site-to-pattern mapping is not available for partition " << pinfo.name()
+                 << ", ancestral states will be reported per alignment pattern!" << endl;
+      }
+    }
+    instance.ancestral_states->block_size = instance.opts.asr_block_size;
+    instance.ancestral_states->selected_node_names = instance.opts.asr_nodes;
+  }
+}
+
+void write_ancestral_states(const Options& opts, const AncestralStates& ancestral, bool append)
+{
+  auto mode = append ? ios::out | ios::app : ios::out;
+
+  if (!opts.asr_probs_file().empty())
+  {
+    AncestralProbStream as(opts.asr_probs_file(), mode);
+    as.precision(logger().precision(LogElement::other));
+    as.prob_format(opts.asr_prob_format);
+    as << ancestral;
+  }
+
+  if (!opts.asr_states_file().empty())
+  {
+    AncestralStateStream as(opts.asr_states_file(), mode);
+    as << ancestral;
   }
 }
 
@@ -1807,6 +1908,8 @@ void postprocess_tree(const Options& opts, Tree& tree)
 void draw_bootstrap_support(RaxmlInstance& instance, Tree& ref_tree,
                             const TreeTopologyList& bs_trees)
 {
+  global_energy_monitor.phase(EnergyPhase::support);
+
   reroot_tree_with_outgroup(instance.opts, ref_tree, false);
 
   for (auto metric: instance.opts.bs_metrics)
@@ -1837,6 +1940,8 @@ void draw_bootstrap_support(RaxmlInstance& instance, Tree& ref_tree,
 
       instance.support_trees[metric] = sup_tree;
   }
+
+  global_energy_monitor.phase(EnergyPhase::other);
 }
 
 bool check_bootstop(const RaxmlInstance& instance, const TreeTopologyList& bs_trees,
@@ -1904,6 +2009,75 @@ bool check_bootstop(const RaxmlInstance& instance, const TreeTopologyList& bs_tr
   return converged;
 }
 
+TreeTopologyList read_binary_trees(Tree& ref_tree, const std::string& fname,
+                                   const std::string& tree_kind)
+{
+  NameList taxon_names;
+  TreeTopologyList trees;
+
+  LOG_INFO << "Reading " << tree_kind << " trees from binary file: " << fname << endl;
+
+  RBTStream rbt(fname);
+  rbt >> RBTStream::RBTOutput(taxon_names, trees);
+
+  if (!trees.empty())
+  {
+    if (ref_tree.empty())
+    {
+      ref_tree = Tree::buildRandom(taxon_names, 0);
+      ref_tree.topology(trees[0]);
+    }
+
+    if (taxon_names.size() != ref_tree.num_tips())
+    {
+      throw runtime_error("Binary tree file contains wrong number of taxa: " +
+                          to_string(taxon_names.size()) +
+                          " (expected: " + to_string(ref_tree.num_tips()) + ")");
+    }
+
+    /* translate tip IDs from the file taxon table into the reference tree IDs */
+    IDVector tip_idmap(taxon_names.size());
+    auto ref_tip_ids = ref_tree.tip_ids();
+    try
+    {
+      for (size_t i = 0; i < taxon_names.size(); ++i)
+        tip_idmap[i] = ref_tip_ids.at(taxon_names[i]);
+    }
+    catch (out_of_range& e)
+    {
+      throw runtime_error("Binary tree file contains incompatible taxon name(s)!");
+    }
+
+    const auto num_tips = taxon_names.size();
+    for (size_t i = 0; i < trees.size(); ++i)
+    {
+      auto& topol = trees[i];
+      if (topol.edges.size() != ref_tree.num_branches())
+      {
+        auto tree_kind_cap = tree_kind;
+        tree_kind_cap[0] = toupper(tree_kind_cap[0]);
+        throw runtime_error(tree_kind_cap + " tree #" + to_string(i+1) +
+                            " has wrong number of branches: " + to_string(topol.edges.size()));
+      }
+
+      for (auto& e: topol.edges)
+      {
+        if (e.left_node_id < num_tips)
+          e.left_node_id = tip_idmap[e.left_node_id];
+        if (e.right_node_id < num_tips)
+          e.right_node_id = tip_idmap[e.right_node_id];
+      }
+      if (topol.vroot_node_id < num_tips)
+        topol.vroot_node_id = tip_idmap[topol.vroot_node_id];
+    }
+  }
+
+  LOG_INFO << "Loaded " << trees.size() << " trees with "
+           << taxon_names.size() << " taxa." << endl << endl;
+
+  return trees;
+}
+
 TreeTopologyList read_newick_trees(Tree& ref_tree, const std::string& fname,
                                    const std::string& tree_kind)
 {
@@ -1914,6 +2088,10 @@ TreeTopologyList read_newick_trees(Tree& ref_tree, const std::string& fname,
   if (!sysutil_file_exists(fname))
     throw runtime_error("File not found: " + fname);
 
+  /* compact binary tree collection (e.g. from --tree-format binary) */
+  if (RBTStream::rbt_file(fname))
+    return read_binary_trees(ref_tree, fname, tree_kind);
+
   NewickStream boots(fname, std::ios::in);
   auto tree_kind_cap = tree_kind;
   tree_kind_cap[0] = toupper(tree_kind_cap[0]);
@@ -2080,10 +2258,66 @@ void command_consense(RaxmlInstance& instance)
     runtime_error("Cannot create consensus tree!");
 }
 
+void write_bootstrap_msa(const Options& opts, const PartitionedMSA& parted_msa,
+                         const BootstrapReplicate& bsrep, size_t bsnum)
+{
+  if (opts.bsmsa_format == FileFormat::binary)
+  {
+    RBAStream rs(opts.bootstrap_msa_file(bsnum));
+    rs << BootstrapMSA(parted_msa, bsrep);
+  }
+  else
+  {
+    PhylipStream ps(opts.bootstrap_msa_file(bsnum));
+    ps << BootstrapMSA(parted_msa, bsrep);
+  }
+}
+
+void thread_bsmsa(const RaxmlInstance& instance, const intVector& seeds)
+{
+  const auto& parted_msa = *instance.parted_msa;
+  BootstrapGenerator bg;
+
+  /* every replicate has its own seed -> replicates are independent of the thread/rank layout */
+  for (size_t b = 0; b < seeds.size(); ++b)
+  {
+    if (b % ParallelContext::num_procs() == ParallelContext::proc_id())
+    {
+      auto bsrep = bg.generate(parted_msa, seeds[b]);
+      write_bootstrap_msa(instance.opts, parted_msa, bsrep, b+1);
+    }
+  }
+}
+
 void command_bsmsa(RaxmlInstance& instance, const CheckpointFile& checkp)
 {
+  RAXML_UNUSED(checkp);
+
+  const auto& opts = instance.opts;
+
   load_parted_msa(instance);
-  generate_bootstraps(instance, checkp);
+
+  if (opts.bootstrap_msa_file(1).empty())
+    return;
+
+  /* same seed sequence as in generate_bootstraps() */
+  auto& seeds = instance.bs_seeds;
+  seeds.resize(opts.num_bootstraps);
+  for (size_t i = 0; i < seeds.size(); ++i)
+    seeds[i] = rand();
+
+  auto num_threads = opts.num_threads ? opts.num_threads : opts.num_threads_max;
+  num_threads = std::min<unsigned int>(num_threads, opts.num_bootstraps);
+
+  LOG_INFO_TS << "Writing " << opts.num_bootstraps << " bootstrap replicate MSAs using "
+              << num_threads << " thread(s)" << endl;
+
+  auto thread_fn = std::bind(thread_bsmsa, std::cref(instance), std::cref(seeds));
+  ParallelContext::init_pthreads_custom(opts, thread_fn, num_threads, num_threads);
+  thread_fn();
+  ParallelContext::finalize_threads();
+
+  ParallelContext::mpi_barrier();
 }
 
 void check_terrace(const RaxmlInstance& instance, const Tree& tree)
@@ -2095,7 +2329,9 @@ void check_terrace(const RaxmlInstance& instance, const Tree& tree)
   {
     try
     {
-      TerraceWrapper terrace_wrapper(parted_msa, tree);
+      auto terrace_cache = instance.terrace_cache ? instance.terrace_cache :
+                                                    make_shared<TerraceCache>(parted_msa);
+      TerraceWrapper terrace_wrapper(terrace_cache, tree);
       auto terrace_size = terrace_wrapper.terrace_size();
       if (terrace_size > 1)
       {
@@ -2150,18 +2386,116 @@ void check_terrace(const RaxmlInstance& instance, const Tree& tree)
 #endif
 }
 
-void save_ml_trees(const Options& opts, const CheckpointFile& checkp)
+#ifdef _RAXML_TERRAPHAST
+void thread_terrace(const TerraceCache& terrace_cache, const TreeList& trees,
+                    std::vector<uint64_t>& terrace_sizes)
+{
+  for (size_t i = ParallelContext::thread_id(); i < trees.size(); i += ParallelContext::num_threads())
+  {
+    try
+    {
+      terrace_sizes[i] = terrace_cache.terrace_size(trees[i]);
+    }
+    catch (terraces::no_usable_root_error& e)
+    {
+      terrace_sizes[i] = 0;
+    }
+  }
+}
+
+void command_terrace(RaxmlInstance& instance)
+{
+  const auto& opts = instance.opts;
+
+  load_parted_msa(instance);
+  assert(!opts.tree_file.empty());
+  LOG_INFO << "Loading tree from: " << opts.tree_file << endl << endl;
+  if (!sysutil_file_exists(opts.tree_file))
+    throw runtime_error("File not found: " + opts.tree_file);
+  instance.start_tree_stream.reset(new NewickStream(opts.tree_file, std::ios::in));
+  Tree tree = generate_tree(instance, StartingTree::user, 0);
+
+  /* build the cache once and reuse it for all trees in the file */
+  const auto& parted_msa = *instance.parted_msa;
+  if (parted_msa.part_count() > 1 && opts.brlen_linkage == PLLMOD_COMMON_BRLEN_UNLINKED)
+    instance.terrace_cache = make_shared<TerraceCache>(parted_msa);
+
+  /* first tree: full check incl. terrace output files */
+  check_terrace(instance, tree);
+
+  if (!instance.terrace_cache)
+    return;
+
+  /* remaining trees: count terrace sizes in parallel, identical topologies are counted once */
+  Tree ref_tree = tree;
+  auto topos = read_newick_trees(ref_tree, opts.tree_file, "input");
+  if (topos.size() < 2)
+    return;
+
+  TreeList trees(topos.size(), tree);
+  for (size_t i = 0; i < topos.size(); ++i)
+    trees[i].topology(topos[i]);
+
+  std::vector<uint64_t> terrace_sizes(trees.size(), 0);
+
+  auto num_threads = opts.num_threads ? opts.num_threads : opts.num_threads_max;
+  num_threads = std::min<unsigned int>(num_threads, trees.size());
+
+  LOG_INFO_TS << "Checking " << trees.size() << " trees for phylogenetic terraces using "
+              << num_threads << " thread(s)" << endl << endl;
+
+  auto thread_fn = std::bind(thread_terrace, std::cref(*instance.terrace_cache),
+                             std::cref(trees), std::ref(terrace_sizes));
+  ParallelContext::init_pthreads_custom(opts, thread_fn, num_threads, num_threads);
+  thread_fn();
+  ParallelContext::finalize_threads();
+
+  size_t terrace_count = 0;
+  for (size_t i = 0; i < trees.size(); ++i)
+  {
+    if (terrace_sizes[i] > 1)
+      terrace_count++;
+    LOG_VERB << "Tree #" << (i+1) << ", terrace size: "
+             << (terrace_sizes[i] ? to_string(terrace_sizes[i]) : "N/A") << endl;
+  }
+
+  LOG_INFO << terrace_count << " out of " << trees.size() << " trees lie on a terrace ("
+           << instance.terrace_cache->misses() << " unique topologies)" << endl << endl;
+}
+#endif
+
+void save_tree_collection(const Options& opts, const CheckpointFile& checkp,
+                          const ScoredTopologyMap& trees, const std::string& fname)
 {
-  NewickStream nw(opts.ml_trees_file(), std::ios::out);
-  for (auto& topol: checkp.ml_trees)
+  if (opts.tree_format == TreeFormat::binary)
   {
-    Tree ml_tree = checkp.tree();
-    ml_tree.topology(topol.second.second);
-    postprocess_tree(opts, ml_tree);
-    nw << ml_tree;
+    /* binary trees are stored unrooted: outgroup rooting is a drawing option only */
+    TreeTopologyList topos;
+    topos.reserve(trees.size());
+    for (auto& topol: trees)
+      topos.push_back(topol.second.second);
+
+    RBTStream rbt(fname, opts.tree_brlen_format);
+    rbt << RBTStream::RBTInput(checkp.tree().tip_labels_list(), topos);
+  }
+  else
+  {
+    NewickStream nw(fname, std::ios::out);
+    for (auto& topol: trees)
+    {
+      Tree tree = checkp.tree();
+      tree.topology(topol.second.second);
+      postprocess_tree(opts, tree);
+      nw << tree;
+    }
   }
 }
 
+void save_ml_trees(const Options& opts, const CheckpointFile& checkp)
+{
+  save_tree_collection(opts, checkp, checkp.ml_trees, opts.ml_trees_file());
+}
+
 void print_ic_scores(const RaxmlInstance& instance, double loglh)
 {
   const auto& parted_msa = *instance.parted_msa;
@@ -2345,16 +2679,7 @@ void print_final_output(const RaxmlInstance& instance, const CheckpointFile& che
     // coarse-grained parallelization scheme (parallel start trees/bootstraps)
     if (!opts.bootstrap_trees_file().empty())
     {
-  //    NewickStream nw(opts.bootstrap_trees_file(), std::ios::out | std::ios::app);
-      NewickStream nw(opts.bootstrap_trees_file(), std::ios::out);
-
-      for (auto& topol: checkp.bs_trees)
-      {
-        Tree bs_tree = checkp.tree();
-        bs_tree.topology(topol.second.second);
-        postprocess_tree(opts, bs_tree);
-        nw << bs_tree;
-      }
+      save_tree_collection(opts, checkp, checkp.bs_trees, opts.bootstrap_trees_file());
 
       LOG_INFO << "Bootstrap trees saved to: " << sysutil_realpath(opts.bootstrap_trees_file()) << endl;
     }
@@ -2370,19 +2695,20 @@ void print_final_output(const RaxmlInstance& instance, const CheckpointFile& che
 
       // Figure out how many bs msa to write out, max
       auto max_bs_trees = opts.write_bs_msa ? checkp.bs_trees.size() : opts.num_bootstraps;
-        
-      size_t bsnum = 0;
-      for (const auto& bsrep: instance.bs_reps)
+
+      /* with --bsmsa, replicate MSAs were already written in parallel by command_bsmsa() */
+      if (opts.command != Command::bsmsa)
       {
-        bsnum++;
-        PhylipStream ps(opts.bootstrap_msa_file(bsnum));
+        size_t bsnum = 0;
+        for (const auto& bsrep: instance.bs_reps)
+        {
+          bsnum++;
+          write_bootstrap_msa(opts, *instance.parted_msa, bsrep, bsnum);
 
-        bs_msa_view.site_weights(bsrep.site_weights);
-        ps << bs_msa_view;
-          
-        // We've reached max number of bootstrap msa to write out
-        if (bsnum >= max_bs_trees)
-          break;
+          // We've reached max number of bootstrap msa to write out
+          if (bsnum >= max_bs_trees)
+            break;
+        }
       }
 
       LOG_INFO << "Bootstrap replicate MSAs saved to: "
@@ -2391,7 +2717,7 @@ void print_final_output(const RaxmlInstance& instance, const CheckpointFile& che
                << "                                   "
                << sysutil_realpath(opts.bootstrap_msa_file(max_bs_trees)) << endl;
 
-      if (print_part_file)
+      if (print_part_file && opts.bsmsa_format != FileFormat::binary)
       {
         RaxmlPartitionStream ps(opts.bootstrap_partition_file(), ios::out);
 
@@ -2430,22 +2756,15 @@ void print_final_output(const RaxmlInstance& instance, const CheckpointFile& che
   {
     assert(instance.ancestral_states);
 
-    if (!opts.asr_probs_file().empty())
-    {
-      AncestralProbStream as(opts.asr_probs_file());
-      as.precision(logger().precision(LogElement::other));
-      as << *instance.ancestral_states;
+    /* in streaming mode, probabilities and sequences have already been written block-wise */
+    if (!opts.asr_block_size)
+      write_ancestral_states(opts, *instance.ancestral_states, false);
 
+    if (!opts.asr_probs_file().empty())
       LOG_INFO << "Marginal ancestral probabilities saved to: " << sysutil_realpath(opts.asr_probs_file()) << endl;
-    }
 
     if (!opts.asr_states_file().empty())
-    {
-      AncestralStateStream as(opts.asr_states_file());
-      as << *instance.ancestral_states;
-
       LOG_INFO << "Reconstructed ancestral sequences saved to: " << sysutil_realpath(opts.asr_states_file()) << endl;
-    }
 
     if (!opts.asr_tree_file().empty())
     {
@@ -2490,6 +2809,9 @@ void print_final_output(const RaxmlInstance& instance, const CheckpointFile& che
     }
   }
 
+  if (opts.profile_format != ProfileFormat::none && !opts.profile_file().empty())
+    LOG_INFO << "Search profile saved to: " << sysutil_realpath(opts.profile_file()) << endl;
+
   if (!opts.log_file().empty())
       LOG_INFO << "\nExecution log saved to: " << sysutil_realpath(opts.log_file()) << endl;
 
@@ -2517,6 +2839,42 @@ void print_final_output(const RaxmlInstance& instance, const CheckpointFile& che
     }
   }
 
+  const auto& phases = instance.energy_phases;
+  if (used_wh > 0.1 && !phases.empty())
+  {
+    LOG_INFO << endl << endl << "Energy by phase (Wh)        total      cores       DRAM   avg. power" << endl;
+    for (size_t p = 0; p < phases.size(); ++p)
+    {
+      const auto& cnt = phases[p];
+      const auto total_j = cnt.joules[(size_t) EnergyDomain::total];
+      if (total_j < 1.)
+        continue;
+
+      LOG_INFO << "  " << setw(20) << left << EnergyMonitor::phase_name((EnergyPhase) p) << right;
+      for (size_t d = 0; d < (size_t) EnergyDomain::count; ++d)
+        LOG_INFO << setw(11) << FMT_PREC3(cnt.joules[d] / 3600.);
+      LOG_INFO << setw(11) << FMT_PREC3((cnt.seconds > 0. ? total_j / cnt.seconds : 0.)) << " W" << endl;
+    }
+
+    /* per-tree efficiency: ML search steps vs. complete bootstrap replicates */
+    auto phase_wh = [&phases](EnergyPhase p) -> double
+        {
+          return phases[(size_t) p].joules[(size_t) EnergyDomain::total] / 3600.;
+        };
+    auto ml_wh = phase_wh(EnergyPhase::modopt) + phase_wh(EnergyPhase::fast_spr) +
+                 phase_wh(EnergyPhase::slow_spr);
+
+    LOG_INFO << endl << "Energy per tree (" << ParallelContext::num_ranks() << " ranks x " <<
+        instance.opts.num_threads << " threads):";
+    if (!checkp.ml_trees.empty())
+      LOG_INFO << " ML search: " << FMT_PREC3(ml_wh / checkp.ml_trees.size()) << " Wh";
+    if (!checkp.bs_trees.empty())
+    {
+      LOG_INFO << (checkp.ml_trees.empty() ? "" : ",") << " bootstrap: " <<
+          FMT_PREC3(phase_wh(EnergyPhase::bootstrap) / checkp.bs_trees.size()) << " Wh";
+    }
+  }
+
   LOG_INFO << endl << endl;
 }
 
@@ -2548,6 +2906,10 @@ void finalize_energy(RaxmlInstance& instance, const CheckpointFile& checkp)
     instance.used_wh = global_energy_monitor.consumed_wh();
     instance.used_wh += checkp.consumed_wh;
 
+    instance.energy_phases = global_energy_monitor.phase_counters(false);
+    for (size_t p = 0; p < instance.energy_phases.size(); ++p)
+      instance.energy_phases[p] += checkp.energy_phases[p];
+
     if (logger().log_level() >= LogLevel::debug && ParallelContext::num_nodes() > 1)
     {
       printf("Consumed energy at node %s: %.3lf Wh\n",
@@ -2555,9 +2917,27 @@ void finalize_energy(RaxmlInstance& instance, const CheckpointFile& checkp)
     }
   }
   else
+  {
     instance.used_wh = 0;
+    instance.energy_phases.assign((size_t) EnergyPhase::count, EnergyCounter());
+  }
 
   ParallelContext::mpi_reduce(&instance.used_wh, 1, PLLMOD_COMMON_REDUCE_SUM);
+
+  /* EnergyCounter is a plain array of doubles */
+  ParallelContext::mpi_reduce((double *) instance.energy_phases.data(),
+                              instance.energy_phases.size() * sizeof(EnergyCounter) / sizeof(double),
+                              PLLMOD_COMMON_REDUCE_SUM);
+}
+
+void write_profile(const Options& opts)
+{
+  /* every rank writes its own profile */
+  if (opts.profile_format == ProfileFormat::none || opts.profile_file().empty())
+    return;
+
+  fstream fs(opts.profile_file(), ios::out);
+  Profiler::write(fs, opts.profile_format);
 }
 
 void init_parallel_buffers(const RaxmlInstance& instance)
@@ -2598,16 +2978,104 @@ void init_parallel_buffers(const RaxmlInstance& instance)
   ParallelContext::resize_buffers(reduce_buffer_size, worker_buf_size);
 }
 
+void infer_ml_tree(RaxmlInstance& instance, CheckpointManager& cm, unique_ptr<TreeInfo>& treeinfo,
+                   size_t start_tree_num, bool restore, double budget_limit)
+{
+  auto const& opts = instance.opts;
+  auto const& master_msa = *instance.parted_msa;
+  auto const& part_assign = instance.proc_part_assign.at(ParallelContext::local_proc_id());
+  Checkpoint& checkp = cm.checkpoint();
+
+  const auto& tree = instance.start_trees.at(start_tree_num-1);
+  assert(!tree.empty());
+
+  if (restore)
+  {
+    // restore search state from checkpoint (tree + model params)
+    treeinfo.reset(new TreeInfo(opts, checkp.tree, master_msa,
+                                instance.tip_msa_idmap, part_assign));
+    assign_models(*treeinfo, checkp);
+  }
+  else
+  {
+    if (ParallelContext::group_master_thread())
+    {
+      checkp.tree_index = start_tree_num;
+      checkp.bs_tree = false;
+    }
+    treeinfo.reset(new TreeInfo(opts, tree, master_msa, instance.tip_msa_idmap, part_assign));
+  }
+
+  treeinfo->set_topology_constraint(instance.constraint_tree);
+
+  auto log_level = instance.start_trees.size() > 1 ? LogLevel::result : LogLevel::info;
+  Optimizer optimizer(opts);
+  optimizer.budget_limit(budget_limit);
+  if (opts.command == Command::evaluate || opts.command == Command::sitelh ||
+      opts.command == Command::ancestral)
+  {
+    // check if we have anything to optimize
+    if (opts.optimize_brlen || opts.optimize_model)
+    {
+      LOG_INFO_TS << "Tree #" << start_tree_num <<
+          ", initial LogLikelihood: " << FMT_LH(treeinfo->loglh()) << endl;
+      LOG_PROGR << endl;
+      optimizer.evaluate(*treeinfo, cm);
+    }
+    else
+    {
+      double loglh = treeinfo->loglh();
+      if (ParallelContext::master_thread())
+        cm.search_state().loglh = loglh;
+
+      cm.update_and_write(*treeinfo);
+    }
+
+    LOG_PROGR << endl;
+    LOG_WORKER_TS(log_level) << "Tree #" << start_tree_num <<
+                         ", final logLikelihood: " << FMT_LH(checkp.loglh()) << endl;
+    LOG_PROGR << endl;
+  }
+  else
+  {
+    optimizer.optimize_topology(*treeinfo, cm);
+    LOG_PROGR << endl;
+    LOG_WORKER_TS(log_level) << "ML tree search #" << start_tree_num <<
+                         ", logLikelihood: " << FMT_LH(checkp.loglh()) << endl;
+    LOG_PROGR << endl;
+  }
+
+  if (!instance.persite_loglh.empty())
+  {
+    assert(start_tree_num <= instance.persite_loglh.size());
+    auto& tree_slh = instance.persite_loglh[start_tree_num-1];
+    std::vector<double*> part_site_lh(master_msa.part_count(), nullptr);
+    for (const auto& pa: part_assign)
+      part_site_lh[pa.part_id] = tree_slh[pa.part_id].data() + pa.start;
+    treeinfo->persite_loglh(part_site_lh);
+  }
+
+  cm.save_ml_tree();
+  cm.reset_search_state();
+}
+
 void thread_infer_ml(RaxmlInstance& instance, CheckpointManager& cm)
 {
   auto& worker = instance.get_worker();
   Checkpoint& checkp = cm.checkpoint();
-  auto const& master_msa = *instance.parted_msa;
   auto const& opts = instance.opts;
 
   unique_ptr<TreeInfo> treeinfo;
 
-  auto gather_ml_trees = [&instance, &cm](unsigned int& batch_id) -> void
+  /* run budget: stop starting new searches if the next one is not likely to fit */
+  const double budget_limit = opts.command == Command::all ?
+                              RAXML_BUDGET_ML_SHARE : 1. - RAXML_BUDGET_RESERVE;
+  const bool budget_per_batch = opts.coarse() && ParallelContext::num_ranks() > 1;
+  const double budget_start = global_budget.active() ? global_budget.used() : 0.;
+  unsigned int budget_items = 0;
+  bool budget_stop = false;
+
+  auto gather_ml_trees = [&](unsigned int& batch_id) -> void
     {
       if (instance.opts.coarse() && ParallelContext::num_ranks() > 1)
       {
@@ -2616,6 +3084,21 @@ void thread_infer_ml(RaxmlInstance& instance, CheckpointManager& cm)
         if (ParallelContext::group_master_thread())
           cm.gather_ml_trees();
 
+        /* coarse MPI: workers are only in sync here, so decide globally once per batch */
+        if (global_budget.active())
+        {
+          budget_items++;
+          double stop = 0.;
+          if (ParallelContext::master())
+          {
+            auto used = global_budget.used();
+            auto next_cost = (used - budget_start) / budget_items;
+            stop = (used + next_cost > budget_limit) ? 1. : 0.;
+          }
+          ParallelContext::global_master_broadcast(&stop, sizeof(double));
+          budget_stop = stop > 0.;
+        }
+
         ParallelContext::global_thread_barrier();
         batch_id++;
       }
@@ -2639,77 +3122,29 @@ void thread_infer_ml(RaxmlInstance& instance, CheckpointManager& cm)
 
   unsigned int batch_id = (instance.done_ml_trees.size() / opts.bootstop_interval) + 1;
 
-  auto ckp_tree_index = instance.run_phase == RaxmlRunPhase::mlsearch ? checkp.tree_index : 0;
+  auto ckp_tree_index = !checkp.bs_tree ? checkp.tree_index : 0;
   ParallelContext::thread_barrier();
   for (auto start_tree_num: worker.start_trees)
   {
-    const auto& tree = instance.start_trees.at(start_tree_num-1);
-    assert(!tree.empty());
-
-    if (ckp_tree_index == start_tree_num)
-    {
-      // restore search state from checkpoint (tree + model params)
-      treeinfo.reset(new TreeInfo(opts, checkp.tree, master_msa,
-                                  instance.tip_msa_idmap, part_assign));
-      assign_models(*treeinfo, checkp);
-    }
-    else
+    if (global_budget.active() && !budget_per_batch && budget_items > 0 &&
+        (opts.command == Command::search || opts.command == Command::all))
     {
-      if (ParallelContext::group_master_thread())
-        checkp.tree_index = start_tree_num;
-      treeinfo.reset(new TreeInfo(opts, tree, master_msa, instance.tip_msa_idmap, part_assign));
+      auto next_cost = ParallelContext::group_master_thread() ?
+                       (global_budget.used() - budget_start) / budget_items : 0.;
+      budget_stop = global_budget.worker_exceeded(budget_limit, next_cost);
     }
 
-    treeinfo->set_topology_constraint(instance.constraint_tree);
-
-    auto log_level = instance.start_trees.size() > 1 ? LogLevel::result : LogLevel::info;
-    Optimizer optimizer(opts);
-    if (opts.command == Command::evaluate || opts.command == Command::sitelh ||
-        opts.command == Command::ancestral)
-    {
-      // check if we have anything to optimize
-      if (opts.optimize_brlen || opts.optimize_model)
-      {
-        LOG_INFO_TS << "Tree #" << start_tree_num <<
-            ", initial LogLikelihood: " << FMT_LH(treeinfo->loglh()) << endl;
-        LOG_PROGR << endl;
-        optimizer.evaluate(*treeinfo, cm);
-      }
-      else
-      {
-        double loglh = treeinfo->loglh();
-        if (ParallelContext::master_thread())
-          cm.search_state().loglh = loglh;
-
-        cm.update_and_write(*treeinfo);
-      }
-
-      LOG_PROGR << endl;
-      LOG_WORKER_TS(log_level) << "Tree #" << start_tree_num <<
-                           ", final logLikelihood: " << FMT_LH(checkp.loglh()) << endl;
-      LOG_PROGR << endl;
-    }
-    else
+    if (budget_stop)
     {
-      optimizer.optimize_topology(*treeinfo, cm);
-      LOG_PROGR << endl;
-      LOG_WORKER_TS(log_level) << "ML tree search #" << start_tree_num <<
-                           ", logLikelihood: " << FMT_LH(checkp.loglh()) << endl;
-      LOG_PROGR << endl;
+      LOG_INFO_TS << "Run budget exhausted, remaining ML searches will be skipped." << endl;
+      break;
     }
 
-    if (!instance.persite_loglh.empty())
-    {
-      assert(start_tree_num <= instance.persite_loglh.size());
-      auto& tree_slh = instance.persite_loglh[start_tree_num-1];
-      std::vector<double*> part_site_lh(master_msa.part_count(), nullptr);
-      for (const auto& pa: part_assign)
-        part_site_lh[pa.part_id] = tree_slh[pa.part_id].data() + pa.start;
-      treeinfo->persite_loglh(part_site_lh);
-    }
+    infer_ml_tree(instance, cm, treeinfo, start_tree_num, ckp_tree_index == start_tree_num,
+                  budget_limit);
 
-    cm.save_ml_tree();
-    cm.reset_search_state();
+    if (!budget_per_batch)
+      budget_items++;
 
     // coarse: collect ML trees from MPI workers
     if (start_tree_num > batch_id * opts.bootstop_interval)
@@ -2720,22 +3155,108 @@ void thread_infer_ml(RaxmlInstance& instance, CheckpointManager& cm)
 
   if (opts.command == Command::ancestral)
   {
-    assert(!opts.use_pattern_compression);
-    treeinfo->compute_ancestral(instance.ancestral_states, part_assign);
+    if (opts.asr_block_size > 0)
+    {
+      bool append = false;
+      treeinfo->compute_ancestral(instance.ancestral_states, part_assign,
+                                  [&opts,&append](const AncestralStates& ancestral)
+                                  {
+                                    write_ancestral_states(opts, ancestral, append);
+                                    append = true;
+                                  });
+    }
+    else
+      treeinfo->compute_ancestral(instance.ancestral_states, part_assign);
     ParallelContext::thread_barrier();
   }
 }
 
-void thread_infer_bootstrap(RaxmlInstance& instance, CheckpointManager& cm)
+void infer_bs_tree(RaxmlInstance& instance, CheckpointManager& cm, BootstrapGenerator& bg,
+                   size_t bs_num, bool restore, double budget_limit)
 {
   auto const& opts = instance.opts;
   auto const& master_msa = *instance.parted_msa;
   auto& worker = instance.get_worker();
   Checkpoint& checkp = cm.checkpoint();
+  auto start_tree_type = opts.use_bs_pars ? StartingTree::parsimony : StartingTree::random;
 
   unique_ptr<TreeInfo> treeinfo;
 
-  auto gather_bs_trees = [&instance, &opts, &cm](unsigned int& batch_start, unsigned int& batch_end) -> void
+  if (instance.opts.use_par_pars)
+  {
+    if (ParallelContext::group_master_thread())
+    {
+      auto bs_seed = instance.bs_seeds.at(bs_num - 1);
+      worker.cur_bs_start_tree = generate_tree(instance, start_tree_type, bs_seed);
+      worker.cur_bs_rep = generate_bs_replicate(instance, bg, bs_seed);
+    }
+    ParallelContext::thread_barrier();
+  }
+  else
+  {
+    worker.cur_bs_start_tree = instance.bs_start_trees.at(bs_num - 1);
+    worker.cur_bs_rep = instance.bs_reps.at(bs_num - 1);
+  }
+
+  // rebalance sites (not possible with RBA partial loading: every rank holds fixed site ranges)
+  if (ParallelContext::group_master_thread())
+  {
+    if (instance.part_weights.empty())
+      worker.proc_part_assign = balance_load(instance, worker.cur_bs_rep.site_weights);
+    else
+      worker.proc_part_assign = instance.proc_part_assign;
+  }
+  ParallelContext::thread_barrier();
+
+  auto const& bs_part_assign = worker.proc_part_assign.at(ParallelContext::local_proc_id());
+
+  if (restore)
+  {
+    // restore search state from checkpoint (tree + model params)
+    treeinfo.reset(new TreeInfo(opts, checkp.tree, master_msa, instance.tip_msa_idmap,
+                                bs_part_assign, worker.cur_bs_rep.site_weights));
+    assign_models(*treeinfo, checkp);
+  }
+  else
+  {
+    if (ParallelContext::group_master_thread())
+    {
+      checkp.tree_index = bs_num;
+      checkp.bs_tree = true;
+    }
+    treeinfo.reset(new TreeInfo(opts, worker.cur_bs_start_tree, master_msa, instance.tip_msa_idmap,
+                                bs_part_assign, worker.cur_bs_rep.site_weights));
+  }
+
+  treeinfo->set_topology_constraint(instance.constraint_tree);
+
+  Optimizer optimizer(opts);
+  optimizer.budget_limit(budget_limit);
+  optimizer.optimize_topology(*treeinfo, cm);
+
+  LOG_PROGR << endl;
+  LOG_WORKER_TS(LogLevel::info) << "Bootstrap tree #" << bs_num <<
+                                   ", logLikelihood: " << FMT_LH(checkp.loglh()) << endl;
+  LOG_PROGR << endl;
+
+  cm.save_bs_tree();
+  cm.reset_search_state();
+}
+
+void thread_infer_bootstrap(RaxmlInstance& instance, CheckpointManager& cm)
+{
+  auto const& opts = instance.opts;
+  auto& worker = instance.get_worker();
+  Checkpoint& checkp = cm.checkpoint();
+
+  global_energy_monitor.phase(EnergyPhase::bootstrap);
+
+  /* run budget: stop bootstrapping if the next batch is not likely to fit */
+  const double budget_limit = 1. - RAXML_BUDGET_RESERVE;
+  const double budget_start = global_budget.active() ? global_budget.used() : 0.;
+  unsigned int budget_batches = 0;
+
+  auto gather_bs_trees = [&](unsigned int& batch_start, unsigned int& batch_end) -> void
     {
       ParallelContext::global_thread_barrier();
 
@@ -2747,27 +3268,73 @@ void thread_infer_bootstrap(RaxmlInstance& instance, CheckpointManager& cm)
       {
         if (ParallelContext::master())
         {
-          Tree tree = instance.random_tree;
-          for (unsigned int  i = batch_start; i < batch_end; ++i)
+          auto& checker = *instance.bootstop_checker;
+
+          /* async mode: test on the previous batch was running while this batch was computed */
+          if (checker.converged_pending())
           {
-            tree.topology(cm.checkp_file().bs_trees.at(i+1).second);
+            auto num_bs_trees = checker.num_bs_trees();
+            instance.bs_converged = checker.converged_result();
 
-            instance.bootstop_checker->add_bootstrap_tree(tree);
-          }
+            /* pending test covers all batches up to the current one */
+            assert(num_bs_trees == batch_start);
 
-          instance.bs_converged = instance.bootstop_checker->converged(opts.random_seed);
+            if (instance.bs_converged)
+            {
+              /* drop this batch, so that the result is the same as with a synchronous test */
+              IDSet extra_trees;
+              for (unsigned int i = batch_start; i < batch_end; ++i)
+                extra_trees.insert(i+1);
+              cm.remove_bs_trees(extra_trees);
+
+              LOG_INFO_TS << "Bootstrapping converged after " << num_bs_trees << " replicates." << endl;
+            }
+          }
 
-          if (instance.bs_converged)
+          if (!instance.bs_converged)
           {
-            auto num_bs_trees = cm.checkp_file().bs_trees.size();
-            LOG_INFO_TS << "Bootstrapping converged after " << num_bs_trees << " replicates." << endl;
+            Tree tree = instance.random_tree;
+            for (unsigned int  i = batch_start; i < batch_end; ++i)
+            {
+              tree.topology(cm.checkp_file().bs_trees.at(i+1).second);
+
+              checker.add_bootstrap_tree(tree);
+            }
+
+            /* no need to wait for the test result, unless this is the last batch anyway */
+            if (opts.use_async_bootstop && batch_end < opts.num_bootstraps)
+              checker.converged_async(opts.random_seed);
+            else
+            {
+              instance.bs_converged = checker.converged(opts.random_seed);
+
+              if (instance.bs_converged)
+              {
+                auto num_bs_trees = cm.checkp_file().bs_trees.size();
+                LOG_INFO_TS << "Bootstrapping converged after " << num_bs_trees << " replicates." << endl;
+              }
+            }
           }
         }
+      }
 
-        if (ParallelContext::master_thread())
-          ParallelContext::mpi_broadcast(&instance.bs_converged, sizeof(bool));
+      if (global_budget.active() && ParallelContext::master() && !instance.bs_converged &&
+          batch_end < opts.num_bootstraps)
+      {
+        budget_batches++;
+        auto used = global_budget.used();
+        auto next_cost = (used - budget_start) / budget_batches;
+        if (used + next_cost > budget_limit)
+        {
+          instance.bs_converged = true;
+          LOG_INFO_TS << "Run budget exhausted, bootstrapping stopped after " <<
+              cm.checkp_file().bs_trees.size() << " replicates." << endl;
+        }
       }
 
+      if ((instance.bootstop_checker || global_budget.active()) && ParallelContext::master_thread())
+        ParallelContext::mpi_broadcast(&instance.bs_converged, sizeof(bool));
+
       ParallelContext::global_thread_barrier();
 
       batch_start = batch_end;
@@ -2803,80 +3370,230 @@ void thread_infer_bootstrap(RaxmlInstance& instance, CheckpointManager& cm)
                                         opts.num_bootstraps);
   auto bs_num = worker.bs_trees.cbegin();
 
-  auto ckp_tree_index = instance.run_phase == RaxmlRunPhase::bootstrap ? checkp.tree_index : 0;
+  auto ckp_tree_index = checkp.bs_tree ? checkp.tree_index : 0;
 
   ParallelContext::global_thread_barrier();
 
   BootstrapGenerator bg;
-  auto start_tree_type = instance.opts.use_bs_pars ? StartingTree::parsimony : StartingTree::random;
   while (!instance.bs_converged && bs_num != worker.bs_trees.cend())
   {
-    if (instance.opts.use_par_pars)
+    infer_bs_tree(instance, cm, bg, *bs_num, ckp_tree_index == *bs_num, budget_limit);
+
+    bs_num++;
+
+    if (bs_num == worker.bs_trees.cend() || *bs_num > bs_batch_end)
+      gather_bs_trees(bs_batch_start, bs_batch_end);
+
+    ParallelContext::thread_barrier();
+  }
+
+  /* special case: if this worker had no bsreps in last batch, it still must synchronize! */
+  if (!instance.bs_converged && bs_batch_start < bs_batch_end)
+    gather_bs_trees(bs_batch_start, bs_batch_end);
+
+  /* bootstrapping was stopped by the run budget -> background test result is not needed */
+  if (instance.bootstop_checker && ParallelContext::master())
+    instance.bootstop_checker->converged_result();
+
+  global_energy_monitor.phase(EnergyPhase::other);
+}
+
+
+/* --all mode: ML searches and bootstrap replicates are processed as one task list per worker,
+ * so that workers which are done with their ML searches start bootstrapping right away */
+void thread_infer_pipelined(RaxmlInstance& instance, CheckpointManager& cm)
+{
+  auto const& opts = instance.opts;
+  auto& worker = instance.get_worker();
+  Checkpoint& checkp = cm.checkpoint();
+
+  unique_ptr<TreeInfo> treeinfo;
+
+  /* run budget: stop bootstrapping if the next batch is not likely to fit
+   * (ML searches are always started, but the optimizer will cut them short if needed) */
+  const double budget_limit = 1. - RAXML_BUDGET_RESERVE;
+  const double budget_start = global_budget.active() ? global_budget.used() : 0.;
+  unsigned int budget_batches = 0;
+
+  /* master: BS trees which have been already passed to the bootstopping test */
+  IDSet bootstop_trees;
+  size_t bootstop_last = 0;
+  bool ml_done = cm.checkp_file().ml_trees.size() >= opts.num_searches;
+  if (ParallelContext::master())
+  {
+    for (const auto& it: cm.checkp_file().bs_trees)
+      bootstop_trees.insert(it.first);
+  }
+
+  auto gather_trees = [&]() -> void
     {
+      ParallelContext::global_thread_barrier();
+
       if (ParallelContext::group_master_thread())
       {
-        auto bs_seed = instance.bs_seeds.at(*bs_num - 1);
-        worker.cur_bs_start_tree = generate_tree(instance, start_tree_type, bs_seed);
-        worker.cur_bs_rep = bg.generate(*instance.parted_msa, bs_seed);
+        cm.gather_ml_trees();
+        cm.gather_bs_trees();
       }
-      ParallelContext::thread_barrier();
-    }
-    else
-    {
-      worker.cur_bs_start_tree = instance.bs_start_trees.at(*bs_num - 1);
-      worker.cur_bs_rep = instance.bs_reps.at(*bs_num - 1);
-    }
 
-    // rebalance sites
-    if (ParallelContext::group_master_thread())
-    {
-      worker.proc_part_assign = balance_load(instance, worker.cur_bs_rep.site_weights);
-    }
-    ParallelContext::thread_barrier();
+      if (ParallelContext::master())
+      {
+        const auto& ckpfile = cm.checkp_file();
+
+        if (!ml_done && ckpfile.ml_trees.size() >= opts.num_searches)
+        {
+          ml_done = true;
+          LOG_INFO_TS << "ML tree search completed, best tree logLH: " <<
+              FMT_LH(ckpfile.ml_trees.best_score()) << endl;
+        }
 
-    auto const& bs_part_assign = worker.proc_part_assign.at(ParallelContext::local_proc_id());
+        /* check bootstrapping convergence: replicates come in out of order, so just test
+         * after every bootstop_interval new trees */
+        if (instance.bootstop_checker && !instance.bs_converged)
+        {
+          auto& checker = *instance.bootstop_checker;
 
-    if (ckp_tree_index == *bs_num)
-    {
-      // restore search state from checkpoint (tree + model params)
-      treeinfo.reset(new TreeInfo(opts, checkp.tree, master_msa, instance.tip_msa_idmap,
-                                  bs_part_assign, worker.cur_bs_rep .site_weights));
-      assign_models(*treeinfo, checkp);
-    }
-    else
-    {
-      if (ParallelContext::group_master_thread())
-        checkp.tree_index = *bs_num;
-      treeinfo.reset(new TreeInfo(opts, worker.cur_bs_start_tree, master_msa, instance.tip_msa_idmap,
-                                  bs_part_assign, worker.cur_bs_rep .site_weights));
-    }
+          if (checker.converged_pending())
+          {
+            auto num_bs_trees = checker.num_bs_trees();
+            instance.bs_converged = checker.converged_result();
 
-    treeinfo->set_topology_constraint(instance.constraint_tree);
+            if (instance.bs_converged)
+            {
+              /* drop replicates gathered after the test was started (see thread_infer_bootstrap) */
+              IDSet extra_trees;
+              for (const auto& it: ckpfile.bs_trees)
+              {
+                if (!bootstop_trees.count(it.first))
+                  extra_trees.insert(it.first);
+              }
+              cm.remove_bs_trees(extra_trees);
+
+              LOG_INFO_TS << "Bootstrapping converged after " << num_bs_trees << " replicates." << endl;
+            }
+          }
 
-    Optimizer optimizer(opts);
-    optimizer.optimize_topology(*treeinfo, cm);
+          if (!instance.bs_converged)
+          {
+            Tree tree = instance.random_tree;
+            for (const auto& it: ckpfile.bs_trees)
+            {
+              if (bootstop_trees.insert(it.first).second)
+              {
+                tree.topology(it.second.second);
+                checker.add_bootstrap_tree(tree);
+              }
+            }
 
-    LOG_PROGR << endl;
-    LOG_WORKER_TS(LogLevel::info) << "Bootstrap tree #" << *bs_num <<
-                                     ", logLikelihood: " << FMT_LH(checkp.loglh()) << endl;
-    LOG_PROGR << endl;
+            auto num_bs_trees = bootstop_trees.size();
+            if (num_bs_trees >= bootstop_last + opts.bootstop_interval ||
+                (num_bs_trees == opts.num_bootstraps && num_bs_trees > bootstop_last))
+            {
+              bootstop_last = num_bs_trees;
+              if (opts.use_async_bootstop && num_bs_trees < opts.num_bootstraps)
+                checker.converged_async(opts.random_seed);
+              else
+              {
+                instance.bs_converged = checker.converged(opts.random_seed);
+
+                if (instance.bs_converged)
+                  LOG_INFO_TS << "Bootstrapping converged after " << num_bs_trees << " replicates." << endl;
+              }
+            }
+          }
+        }
 
-    cm.save_bs_tree();
-    cm.reset_search_state();
+        if (global_budget.active() && !instance.bs_converged &&
+            ckpfile.bs_trees.size() < opts.num_bootstraps)
+        {
+          budget_batches++;
+          auto used = global_budget.used();
+          auto next_cost = (used - budget_start) / budget_batches;
+          if (used + next_cost > budget_limit)
+          {
+            instance.bs_converged = true;
+            LOG_INFO_TS << "Run budget exhausted, bootstrapping stopped after " <<
+                ckpfile.bs_trees.size() << " replicates." << endl;
+          }
+        }
+      }
 
-    bs_num++;
+      if ((instance.bootstop_checker || global_budget.active()) && ParallelContext::master_thread())
+        ParallelContext::mpi_broadcast(&instance.bs_converged, sizeof(bool));
 
-    if (bs_num == worker.bs_trees.cend() || *bs_num > bs_batch_end)
-      gather_bs_trees(bs_batch_start, bs_batch_end);
+      ParallelContext::global_thread_barrier();
+    };
+
+  if (instance.done_ml_trees.empty() && instance.done_bs_trees.empty())
+  {
+    LOG_INFO << "\nStarting ML tree search with " << opts.num_searches <<
+        " distinct starting trees and bootstrapping analysis with " << opts.num_bootstraps <<
+        " replicates" << endl;
+  }
+  else
+  {
+    LOG_INFO << "\nContinuing ML tree search with " << opts.num_searches <<
+        " distinct starting trees and bootstrapping analysis with " << opts.num_bootstraps <<
+        " replicates" << endl;
+  }
+
+  (instance.start_trees.size() > 1 ? LOG_RESULT : LOG_INFO) << endl;
+
+  /* ML searches first, then bootstraps. Trees are collected after every batch_size tasks,
+   * and all workers must take part in the same number of gathers -> pad to the longest list */
+  typedef pair<bool, size_t> PipelineTask;     /* (BS replicate?, tree index) */
+  vector<PipelineTask> tasks;
+  for (auto start_tree_num: worker.start_trees)
+    tasks.emplace_back(false, start_tree_num);
+  for (auto bs_num: worker.bs_trees)
+    tasks.emplace_back(true, bs_num);
+
+  /* the in-progress search from a checkpoint must come first: any other search would
+   * overwrite the checkpointed tree and model parameters */
+  const PipelineTask ckp_task(checkp.bs_tree, checkp.tree_index);
+  if (ckp_task.second > 0)
+  {
+    auto it = std::find(tasks.begin(), tasks.end(), ckp_task);
+    if (it != tasks.end())
+      std::rotate(tasks.begin(), it, it + 1);
+  }
+
+  const size_t batch_size = std::max<size_t>(1, opts.bootstop_interval / ParallelContext::num_groups());
+  const size_t num_batches = (instance.max_worker_tasks + batch_size - 1) / batch_size;
+  assert(tasks.size() <= num_batches * batch_size);
+
+  ParallelContext::global_thread_barrier();
+
+  BootstrapGenerator bg;
+  for (size_t i = 0; i < num_batches * batch_size; ++i)
+  {
+    if (i < tasks.size())
+    {
+      const auto& task = tasks[i];
+      const bool restore = i == 0 && task == ckp_task;
+      if (!task.first)
+      {
+        global_energy_monitor.phase(EnergyPhase::other);
+        infer_ml_tree(instance, cm, treeinfo, task.second, restore, budget_limit);
+      }
+      else if (!instance.bs_converged)
+      {
+        global_energy_monitor.phase(EnergyPhase::bootstrap);
+        infer_bs_tree(instance, cm, bg, task.second, restore, budget_limit);
+      }
+    }
+
+    if ((i + 1) % batch_size == 0)
+      gather_trees();
 
     ParallelContext::thread_barrier();
   }
 
-  /* special case: if this worker had no bsreps in last batch, it still must synchronize! */
-  if (!instance.bs_converged && bs_batch_start < bs_batch_end)
-    gather_bs_trees(bs_batch_start, bs_batch_end);
-}
+  /* test started at the last gather, result is not needed anymore */
+  if (instance.bootstop_checker && ParallelContext::master())
+    instance.bootstop_checker->converged_result();
 
+  global_energy_monitor.phase(EnergyPhase::other);
+}
 
 void thread_main(RaxmlInstance& instance, CheckpointManager& cm)
 {
@@ -2884,26 +3601,40 @@ void thread_main(RaxmlInstance& instance, CheckpointManager& cm)
 //  printf("WORKER: %u, LOCAL_THREAD: %u\n", ParallelContext::group_id(), ParallelContext::local_proc_id());
   ParallelContext::global_barrier();
 
+  ParallelContext::touch_group_buffers();
+
   auto const& opts = instance.opts;
 
   check_oversubscribe(instance);
 
-  if ((opts.command == Command::search || opts.command == Command::all ||
-      opts.command == Command::evaluate || opts.command == Command::sitelh ||
-      opts.command == Command::ancestral) &&
-      !instance.start_trees.empty())
+  if (pipelined_run(instance))
   {
-    thread_infer_ml(instance, cm);
+    thread_infer_pipelined(instance, cm);
     ParallelContext::global_barrier();
   }
-
-  if ((opts.command == Command::bootstrap || opts.command == Command::all))
+  else
   {
-    thread_infer_bootstrap(instance, cm);
-    ParallelContext::global_barrier();
+    if ((opts.command == Command::search || opts.command == Command::all ||
+        opts.command == Command::evaluate || opts.command == Command::sitelh ||
+        opts.command == Command::ancestral) &&
+        !instance.start_trees.empty())
+    {
+      thread_infer_ml(instance, cm);
+      ParallelContext::global_barrier();
+    }
+
+    if ((opts.command == Command::bootstrap || opts.command == Command::all))
+    {
+      thread_infer_bootstrap(instance, cm);
+      ParallelContext::global_barrier();
+    }
   }
 
   (instance.start_trees.size() > 1 ? LOG_RESULT : LOG_INFO) << endl;
+
+  /* worker threads terminate now */
+  if (!ParallelContext::master_thread())
+    global_energy_monitor.release_phase();
 }
 
 void master_main(RaxmlInstance& instance, CheckpointManager& cm)
@@ -2985,6 +3716,9 @@ void master_main(RaxmlInstance& instance, CheckpointManager& cm)
                                                  std::ref(instance),
                                                  std::ref(cm)));
 
+  if (ParallelContext::master() && !ParallelContext::group_cpus().empty())
+    LOG_INFO << CpuTopology().placement_report(ParallelContext::group_cpus()) << endl;
+
   /* init workers */
   assert(opts.num_workers > 0);
   for (size_t i = 0; i < ParallelContext::num_local_groups(); ++i)
@@ -3027,11 +3761,24 @@ void master_main(RaxmlInstance& instance, CheckpointManager& cm)
       }
     }
 
-    LOG_DEBUG << "Loading MSA segments from RBA file..." << endl;
     RBAStream bs(opts.msa_file);
+
+    /* bootstrap replicates are drawn from the whole alignment -> keep all pattern weights */
+    if (opts.command == Command::bootstrap || opts.command == Command::all)
+    {
+      bs >> RBAStream::RBAOutput(parted_msa, RBAStream::RBAElement::weights, nullptr);
+      for (const auto& pinfo: parted_msa.part_list())
+        instance.part_weights.push_back(pinfo.msa().weights());
+    }
+
+    LOG_DEBUG << "Loading MSA segments from RBA file..." << endl;
     bs >> RBAStream::RBAOutput(parted_msa, RBAStream::RBAElement::seqdata, &local_part_ranges);
   }
 
+  /* keep a single copy of the alignment per node */
+  if (opts.use_shared_msa)
+    share_msa(instance);
+
   // TEMP WORKAROUND: here we reset random seed once again to make sure that BS replicates
   // are not affected by the number of ML search starting trees that has been generated before
   srand(instance.opts.random_seed);
@@ -3168,9 +3915,20 @@ int internal_main(int argc, char** argv, void* comm)
 
     check_options_early(opts);
 
+    if (opts.profile_format != ProfileFormat::none)
+      Profiler::enable();
+
     if (!opts.use_energy_monitor)
       global_energy_monitor.disable();
 
+    if (opts.budget_wh > 0. && !global_energy_monitor.active())
+    {
+      LOG_WARN << "WARNING: Energy counters are not available, energy budget will be ignored!"
+               << endl << endl;
+      opts.budget_wh = 0.;
+    }
+    global_budget.init(opts.budget_seconds, opts.budget_wh, ParallelContext::num_nodes());
+
     if (opts.redo_mode)
     {
       LOG_WARN << "WARNING: Running in REDO mode: existing checkpoints are ignored, "
@@ -3224,17 +3982,8 @@ int internal_main(int argc, char** argv, void* comm)
         break;
 #ifdef _RAXML_TERRAPHAST
       case Command::terrace:
-      {
-        load_parted_msa(instance);
-        assert(!opts.tree_file.empty());
-        LOG_INFO << "Loading tree from: " << opts.tree_file << endl << endl;
-        if (!sysutil_file_exists(opts.tree_file))
-          throw runtime_error("File not found: " + opts.tree_file);
-        instance.start_tree_stream.reset(new NewickStream(opts.tree_file, std::ios::in));
-        Tree tree = generate_tree(instance, StartingTree::user, 0);
-        check_terrace(instance, tree);
+        command_terrace(instance);
         break;
-      }
 #endif
       case Command::check:
         opts.use_pattern_compression = false;
@@ -3306,6 +4055,7 @@ int internal_main(int argc, char** argv, void* comm)
 
     /* finalize */
     finalize_energy(instance, cm.checkp_file());
+    write_profile(opts);
     if (ParallelContext::master_rank())
       print_final_output(instance, cm.checkp_file());
 
@@ -38,8 +38,8 @@ void set(terraces::bitmatrix& bm, terraces::index_map indices, bool val)
       bm.set(it.second, col, val);
 }
 
-TerraceWrapper::TerraceWrapper (const PartitionedMSA& parted_msa, const Tree& tree) :
-    _bm(parted_msa.taxon_count(), parted_msa.part_count())
+TerraceCache::TerraceCache (const PartitionedMSA& parted_msa) :
+    _bm(parted_msa.taxon_count(), parted_msa.part_count()), _hits(0), _misses(0)
 {
   /* init index<->name maps */
   _names.resize(parted_msa.taxon_count());
@@ -65,34 +65,96 @@ TerraceWrapper::TerraceWrapper (const PartitionedMSA& parted_msa, const Tree& tr
   LOG_DEBUG << std::endl << "Binary matrix:" << std::endl
             << std::make_pair(std::cref(_bm), std::cref(_names)) << std::endl;
 
-  auto newick_str = to_newick_string_rooted(tree);
-  LOG_DEBUG << "Tree: " << newick_str << std::endl << std::endl;
-
-  auto terra_tree = parse_nwk(newick_str, _indices);
-
   LOG_DEBUG << "Names:" << std::endl;
   for (const auto& n: _names)
     LOG_DEBUG << n << std::endl;
   LOG_DEBUG << std::endl;
+}
+
+std::string TerraceCache::topology_key(const Tree& tree) const
+{
+  /* splits are normalized and sorted, so identical unrooted topologies yield identical keys */
+  pll_split_t * splits = pllmod_utree_split_create(&tree.pll_utree_root(),
+                                                   tree.num_tips(),
+                                                   nullptr);
+  if (!splits)
+    libpll_check_error("Cannot extract tree splits: ", true);
+
+  auto split_bits = sizeof(pll_split_base_t) * 8;
+  auto split_size = sizeof(pll_split_base_t) * ((tree.num_tips() + split_bits - 1) / split_bits);
+
+  std::string key;
+  key.reserve(tree.num_splits() * split_size);
+  for (size_t i = 0; i < tree.num_splits(); ++i)
+    key.append(reinterpret_cast<const char*>(splits[i]), split_size);
+
+  pllmod_utree_split_destroy(splits);
+
+  return key;
+}
+
+std::uint64_t TerraceCache::compute_terrace_size(const Tree& tree) const
+{
+  auto terra_tree = parse_nwk(to_newick_string_rooted(tree), _indices);
+  auto supertree = create_supertree_data(terra_tree, _bm);
+  return count_terrace(supertree);
+}
+
+std::uint64_t TerraceCache::terrace_size(const Tree& tree) const
+{
+  auto key = topology_key(tree);
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _sizes.find(key);
+    if (it != _sizes.end())
+    {
+      _hits++;
+      return it->second;
+    }
+  }
+
+  /* count outside the lock -> different topologies can be processed concurrently */
+  auto size = compute_terrace_size(tree);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _misses++;
+  _sizes[key] = size;
+
+  return size;
+}
+
+TerraceWrapper::TerraceWrapper (const PartitionedMSA& parted_msa, const Tree& tree) :
+    TerraceWrapper(std::make_shared<TerraceCache>(parted_msa), tree)
+{
+}
+
+TerraceWrapper::TerraceWrapper (const TerraceCacheSharedPtr& cache, const Tree& tree) :
+    _cache(cache), _tree(tree)
+{
+  auto newick_str = to_newick_string_rooted(tree);
+  LOG_DEBUG << "Tree: " << newick_str << std::endl << std::endl;
+
+  auto terra_tree = parse_nwk(newick_str, _cache->indices());
 
 //  reroot_at_taxon_inplace(terra_tree, root_index);
-  _supertree = create_supertree_data(terra_tree, _bm);
+  _supertree = create_supertree_data(terra_tree, _cache->presence_matrix());
 }
 
 std::uint64_t TerraceWrapper::terrace_size()
 {
-  return count_terrace(_supertree);
+  return _cache->terrace_size(_tree);
 }
 
 void TerraceWrapper::print_terrace_newick(std::ostream& output)
 {
-  auto result = terraces::print_terrace(_supertree, _names, output);
+  auto result = terraces::print_terrace(_supertree, _cache->names(), output);
   RAXML_UNUSED(result);
 }
 
 void TerraceWrapper::print_terrace_compressed(std::ostream& output)
 {
-  auto result = terraces::print_terrace_compressed(_supertree, _names, output);
+  auto result = terraces::print_terrace_compressed(_supertree, _cache->names(), output);
   RAXML_UNUSED(result);
 }
 
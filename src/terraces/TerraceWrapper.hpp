@@ -1,6 +1,10 @@
 #ifndef RAXML_TERRACES_TERRACEWRAPPER_HPP_
 #define RAXML_TERRACES_TERRACEWRAPPER_HPP_
 
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
 #include <terraces/advanced.hpp>
 #include <terraces/parser.hpp>
 #include <terraces/errors.hpp>
@@ -8,10 +12,47 @@
 class PartitionedMSA;
 class Tree;
 
+/*
+ * Per-dataset terraphast input (taxon x partition presence matrix and taxon names)
+ * plus a cache of terrace sizes keyed by tree topology, so that checking many trees
+ * inferred from the same alignment does not repeat any work for identical topologies
+ */
+class TerraceCache
+{
+public:
+  TerraceCache (const PartitionedMSA& part_msa);
+
+  const terraces::bitmatrix& presence_matrix() const { return _bm; }
+  const terraces::name_map& names() const { return _names; }
+  const terraces::index_map& indices() const { return _indices; }
+
+  /* thread-safe: can be called concurrently for different trees */
+  std::uint64_t terrace_size(const Tree& tree) const;
+
+  size_t hits() const { return _hits; }
+  size_t misses() const { return _misses; }
+
+private:
+  terraces::bitmatrix _bm;
+  terraces::name_map _names;
+  terraces::index_map _indices;
+
+  mutable std::mutex _mutex;
+  mutable std::unordered_map<std::string, std::uint64_t> _sizes;
+  mutable size_t _hits;
+  mutable size_t _misses;
+
+  std::string topology_key(const Tree& tree) const;
+  std::uint64_t compute_terrace_size(const Tree& tree) const;
+};
+
+typedef std::shared_ptr<TerraceCache> TerraceCacheSharedPtr;
+
 class TerraceWrapper
 {
 public:
   TerraceWrapper (const PartitionedMSA& part_msa, const Tree& tree);
+  TerraceWrapper (const TerraceCacheSharedPtr& cache, const Tree& tree);
 
   std::uint64_t terrace_size();
   void print_terrace_newick(std::ostream& output);
@@ -19,9 +60,8 @@ public:
   void print_terrace(std::ostream& output);
 
 private:
-  terraces::bitmatrix _bm;
-  terraces::name_map _names;
-  terraces::index_map _indices;
+  TerraceCacheSharedPtr _cache;
+  const Tree& _tree;    /* must outlive the wrapper */
   terraces::supertree_data _supertree;
 };
 
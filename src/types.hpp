@@ -53,6 +53,34 @@ enum class FileFormat
   binary
 };
 
+enum class TreeFormat
+{
+  newick = 0,
+  binary
+};
+
+enum class TreeBrlenFormat
+{
+  none = 0,
+  quant16,
+  float32,
+  full
+};
+
+enum class AncestralProbFormat
+{
+  text = 0,
+  float32,
+  uint8
+};
+
+enum class ProfileFormat
+{
+  none = 0,
+  json,
+  csv
+};
+
 enum class DataType
 {
   autodetect = 0,
@@ -0,0 +1,362 @@
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <thread>
+#include <tuple>
+
+#include "CpuTopology.hpp"
+
+#include "../common.h"
+
+using namespace std;
+
+/* defined in sysutil.cpp */
+size_t get_numa_node_id(const std::string &cpu_path);
+size_t read_id_from_file(const std::string &filename);
+
+static inline string cpu_path(unsigned int cpu_id)
+{
+  return "/sys/devices/system/cpu/cpu" + to_string(cpu_id) + "/";
+}
+
+/* L3 domain = first CPU in shared_cpu_list of the L3 cache, e.g. "8-15,136-143" -> 8 */
+static size_t l3_domain_id(unsigned int cpu_id)
+{
+  for (size_t i = 0; i < 10; ++i)
+  {
+    string cache_path = cpu_path(cpu_id) + "cache/index" + to_string(i) + "/";
+    if (!sysutil_dir_exists(cache_path))
+      break;
+
+    if (read_id_from_file(cache_path + "level") == 3)
+    {
+      ifstream fs(cache_path + "shared_cpu_list");
+      size_t first_cpu;
+      if (fs >> first_cpu)
+        return first_cpu;
+    }
+  }
+
+  throw runtime_error("L3 cache info not found");
+}
+
+static string format_cpu_list(vector<unsigned int> cpus)
+{
+  stringstream ss;
+  sort(cpus.begin(), cpus.end());
+  cpus.erase(unique(cpus.begin(), cpus.end()), cpus.end());
+  for (size_t i = 0; i < cpus.size(); ++i)
+  {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus[j+1] == cpus[j] + 1)
+      j++;
+
+    ss << (i > 0 ? "," : "") << cpus[i];
+    if (j > i)
+      ss << "-" << cpus[j];
+    i = j;
+  }
+  return ss.str();
+}
+
+template<typename T>
+static string format_id_set(const set<T>& ids)
+{
+  stringstream ss;
+  for (auto it = ids.cbegin(); it != ids.cend(); ++it)
+    ss << (it != ids.cbegin() ? "," : "") << *it;
+  return ss.str();
+}
+
+static vector<unsigned int> affinity_cpu_ids()
+{
+  vector<unsigned int> cpu_ids;
+
+#if defined(__linux__)
+  /* respect the affinity mask set by the MPI launcher or taskset */
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask) == 0)
+  {
+    for (unsigned int i = 0; i < CPU_SETSIZE; ++i)
+    {
+      if (CPU_ISSET(i, &mask))
+        cpu_ids.push_back(i);
+    }
+  }
+#endif
+
+  if (cpu_ids.empty())
+  {
+    for (unsigned int i = 0; i < std::thread::hardware_concurrency(); ++i)
+      cpu_ids.push_back(i);
+  }
+
+  return cpu_ids;
+}
+
+/* captured during static initialization: later on, the master thread might be pinned to
+ * a single core (e.g. by the temporary thread pools for MSA checking or parsimony) */
+static const vector<unsigned int> process_cpu_ids = affinity_cpu_ids();
+
+const std::vector<unsigned int>& CpuTopology::process_cpus()
+{
+  return process_cpu_ids;
+}
+
+CpuTopology::CpuTopology(const std::vector<CpuInfo>& cpus) : _cpus(cpus), _detected(true)
+{
+}
+
+CpuTopology::CpuTopology() : _detected(false)
+{
+  for (auto cpu_id: process_cpus())
+    _cpus.push_back({cpu_id, 0, 0, 0, cpu_id, false});
+
+#if defined(__linux__)
+  try
+  {
+    detect();
+    _detected = true;
+  }
+  catch (const runtime_error&)
+  {
+    /* no topology info -> flat topology in OS numbering */
+    for (auto& c: _cpus)
+      c = {c.cpu_id, 0, 0, 0, c.cpu_id, false};
+  }
+#endif
+}
+
+void CpuTopology::detect()
+{
+  set<tuple<size_t, size_t> > cores;
+  for (auto& c: _cpus)
+  {
+    const auto topo_path = cpu_path(c.cpu_id) + "topology/";
+    c.socket_id = read_id_from_file(topo_path + "physical_package_id");
+    c.node_id = get_numa_node_id(topo_path);
+    c.core_id = (c.socket_id << 16) + read_id_from_file(topo_path + "core_id");
+
+    /* no L3 info (e.g. some VMs/ARM systems) -> NUMA node is the cache domain */
+    try
+    {
+      c.l3_id = l3_domain_id(c.cpu_id);
+    }
+    catch (const runtime_error&)
+    {
+      c.l3_id = c.node_id << 16;
+    }
+  }
+
+  /* first hardware thread in OS numbering is the "physical" core */
+  for (auto& c: _cpus)
+    c.smt_sibling = !cores.emplace(c.node_id, c.core_id).second;
+}
+
+const CpuInfo * CpuTopology::cpu_info(unsigned int cpu_id) const
+{
+  for (const auto& c: _cpus)
+  {
+    if (c.cpu_id == cpu_id)
+      return &c;
+  }
+  return nullptr;
+}
+
+size_t CpuTopology::num_sockets() const
+{
+  set<size_t> ids;
+  for (const auto& c: _cpus)
+    ids.insert(c.socket_id);
+  return ids.size();
+}
+
+size_t CpuTopology::num_nodes() const
+{
+  set<size_t> ids;
+  for (const auto& c: _cpus)
+    ids.insert(c.node_id);
+  return ids.size();
+}
+
+size_t CpuTopology::num_l3() const
+{
+  set<size_t> ids;
+  for (const auto& c: _cpus)
+    ids.insert(c.l3_id);
+  return ids.size();
+}
+
+size_t CpuTopology::num_cores() const
+{
+  size_t count = 0;
+  for (const auto& c: _cpus)
+    count += c.smt_sibling ? 0 : 1;
+  return count;
+}
+
+GroupCpuMap CpuTopology::place_groups(const std::vector<size_t>& group_sizes) const
+{
+  /* SMT siblings are only used if there are more threads than physical cores; in this case,
+   * all hardware threads of a core are assigned to the same group */
+  size_t total_threads = 0;
+  for (auto group_size: group_sizes)
+    total_threads += group_size;
+  const bool use_smt = total_threads > num_cores();
+
+  map<size_t, vector<unsigned int> > siblings;     /* core -> SMT siblings */
+  for (const auto& c: _cpus)
+  {
+    if (c.smt_sibling)
+      siblings[c.core_id].push_back(c.cpu_id);
+  }
+
+  /* free CPUs per L3 domain, domains ordered by (NUMA node, L3 ID) */
+  typedef pair<size_t, size_t> DomainKey;
+  map<DomainKey, vector<unsigned int> > free_cores;
+  for (const auto& c: _cpus)
+  {
+    if (c.smt_sibling)
+      continue;
+
+    auto& dom = free_cores[DomainKey(c.node_id, c.l3_id)];
+    dom.push_back(c.cpu_id);
+    if (use_smt)
+      dom.insert(dom.end(), siblings[c.core_id].cbegin(), siblings[c.core_id].cend());
+  }
+
+  auto node_free = [&free_cores](size_t node_id) -> size_t
+      {
+        size_t count = 0;
+        for (const auto& d: free_cores)
+          count += d.first.first == node_id ? d.second.size() : 0;
+        return count;
+      };
+
+  auto take = [](vector<unsigned int>& from, vector<unsigned int>& to, size_t count)
+      {
+        count = std::min(count, from.size());
+        to.insert(to.end(), from.begin(), from.begin() + count);
+        from.erase(from.begin(), from.begin() + count);
+      };
+
+  GroupCpuMap placement;
+  for (auto group_size: group_sizes)
+  {
+    vector<unsigned int> group_cpus;
+
+    /* 1. best fit: smallest L3 domain which can host the whole group */
+    auto best = free_cores.end();
+    for (auto d = free_cores.begin(); d != free_cores.end(); ++d)
+    {
+      if (d->second.size() >= group_size &&
+          (best == free_cores.end() || d->second.size() < best->second.size()))
+        best = d;
+    }
+
+    if (best != free_cores.end())
+      take(best->second, group_cpus, group_size);
+
+    /* 2. spill over L3 domains: stay on the current NUMA node as long as possible,
+     *    then continue on the node with most free cores */
+    while (group_cpus.size() < group_size)
+    {
+      size_t node_id = 0;
+      size_t max_free = 0;
+      auto last_cpu = group_cpus.empty() ? nullptr : cpu_info(group_cpus.back());
+      if (last_cpu)
+      {
+        node_id = last_cpu->node_id;
+        max_free = node_free(node_id);
+      }
+
+      if (!max_free)
+      {
+        for (const auto& d: free_cores)
+        {
+          auto nfree = node_free(d.first.first);
+          if (nfree > max_free)
+          {
+            max_free = nfree;
+            node_id = d.first.first;
+          }
+        }
+      }
+
+      if (!max_free)
+        break;
+
+      auto dom = free_cores.end();
+      for (auto d = free_cores.begin(); d != free_cores.end(); ++d)
+      {
+        if (d->first.first == node_id &&
+            (dom == free_cores.end() || d->second.size() > dom->second.size()))
+          dom = d;
+      }
+
+      take(dom->second, group_cpus, group_size - group_cpus.size());
+    }
+
+    /* 3. more threads than CPUs: oversubscribe round-robin */
+    if (group_cpus.size() < group_size)
+    {
+      vector<unsigned int> pool = group_cpus;
+      if (pool.empty())
+      {
+        for (const auto& c: _cpus)
+          pool.push_back(c.cpu_id);
+      }
+
+      for (size_t i = 0; !pool.empty() && group_cpus.size() < group_size; ++i)
+        group_cpus.push_back(pool[i % pool.size()]);
+    }
+
+    placement.push_back(group_cpus);
+  }
+
+  return placement;
+}
+
+std::string CpuTopology::placement_report(const GroupCpuMap& placement) const
+{
+  stringstream ss;
+
+  ss << "Thread placement (sockets: " << num_sockets() << ", NUMA nodes: " << num_nodes() <<
+      ", L3 domains: " << num_l3() << ", cores: " << num_cores() << ", CPUs: " << _cpus.size() <<
+      (_detected ? "" : ", topology unknown") << "):" << endl;
+
+  for (size_t g = 0; g < placement.size(); ++g)
+  {
+    set<size_t> sockets, nodes, l3s;
+    size_t smt = 0, unknown = 0;
+    for (auto cpu_id: placement[g])
+    {
+      auto c = cpu_info(cpu_id);
+      if (!c)
+      {
+        unknown++;
+        continue;
+      }
+      sockets.insert(c->socket_id);
+      nodes.insert(c->node_id);
+      l3s.insert(c->l3_id);
+      smt += c->smt_sibling ? 1 : 0;
+    }
+
+    ss << "  group " << g << ": CPUs " << format_cpu_list(placement[g]) <<
+        "  [socket " << format_id_set(sockets) << ", NUMA " << format_id_set(nodes) <<
+        ", L3 domains: " << l3s.size();
+    if (smt)
+      ss << ", SMT threads: " << smt;
+    if (unknown)
+      ss << ", outside of affinity mask: " << unknown;
+    ss << "]" << endl;
+  }
+
+  return ss.str();
+}
@@ -0,0 +1,55 @@
+#ifndef RAXML_CPUTOPOLOGY_HPP_
+#define RAXML_CPUTOPOLOGY_HPP_
+
+#include <string>
+#include <vector>
+
+struct CpuInfo
+{
+  unsigned int cpu_id;
+  size_t socket_id;
+  size_t node_id;
+  size_t l3_id;         /* ID of the first CPU sharing the same L3 cache */
+  size_t core_id;       /* unique across sockets */
+  bool smt_sibling;     /* false for the first hardware thread of a core */
+};
+
+typedef std::vector<std::vector<unsigned int> > GroupCpuMap;
+
+/*
+ * Hardware topology (sockets, NUMA nodes, L3 domains, SMT siblings) of the CPUs
+ * in the affinity mask of the process, as reported by Linux sysfs.
+ * On other systems, or if sysfs is not readable, a flat topology is assumed.
+ */
+class CpuTopology
+{
+public:
+  CpuTopology();
+  explicit CpuTopology(const std::vector<CpuInfo>& cpus);
+
+  /* CPUs in the affinity mask of the process at startup, i.e. before any thread was pinned */
+  static const std::vector<unsigned int>& process_cpus();
+
+  bool detected() const { return _detected; }
+  const std::vector<CpuInfo>& cpus() const { return _cpus; }
+
+  size_t num_sockets() const;
+  size_t num_nodes() const;
+  size_t num_l3() const;
+  size_t num_cores() const;
+
+  /* assign a compact set of CPUs (sharing L3, then NUMA node) to every thread group;
+   * SMT siblings are used only if there are more threads than physical cores */
+  GroupCpuMap place_groups(const std::vector<size_t>& group_sizes) const;
+
+  std::string placement_report(const GroupCpuMap& placement) const;
+
+private:
+  std::vector<CpuInfo> _cpus;
+  bool _detected;
+
+  void detect();
+  const CpuInfo * cpu_info(unsigned int cpu_id) const;
+};
+
+#endif /* RAXML_CPUTOPOLOGY_HPP_ */
@@ -40,7 +40,12 @@ static inline T read_value(string fname)
   return val;
 }
 
-EnergyMonitor::EnergyMonitor ()
+/* phase of the calling thread, -1 = none */
+static thread_local int thread_phase = -1;
+
+EnergyMonitor::EnergyMonitor () :
+    _phase_counters((size_t) EnergyPhase::count, EnergyCounter()),
+    _phase_threads((size_t) EnergyPhase::count, 0)
 {
   // so far, power monitoring only works on Linux
 #if defined(__linux__)
@@ -53,11 +58,16 @@ EnergyMonitor::EnergyMonitor ()
 #endif
   _consumed_joules = 0;
   _last_update_ts = time(NULL);
+  _last_phase_ts = std::chrono::steady_clock::now();
 }
 
 void EnergyMonitor::reset()
 {
-  _consumed_joules = 0;
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _consumed_joules = 0;
+    _phase_counters.assign((size_t) EnergyPhase::count, EnergyCounter());
+  }
   update();
 }
 
@@ -66,6 +76,14 @@ void EnergyMonitor::update(double interval)
   if (!_active || (interval > 0. && time(NULL) - _last_update_ts  < interval))
     return;
 
+  std::lock_guard<std::mutex> lock(_mtx);
+  read_counters();
+}
+
+void EnergyMonitor::read_counters()
+{
+  double joules[(size_t) EnergyDomain::count] = {0.};
+
   for(auto& pkg: _pkg_list)
   {
     size_t energy_uj = read_value<size_t>(pkg.energy_fname);
@@ -75,9 +93,41 @@ void EnergyMonitor::update(double interval)
         energy_uj + (pkg.max_energy_range_uj - pkg.last_energy_uj);
 
     pkg.last_energy_uj = energy_uj;
-    _consumed_joules += diff_uj / 1e6f; // convert to Joules
+
+    double diff_joules = diff_uj / 1e6f; // convert to Joules
+    if (pkg.in_total)
+      joules[(size_t) EnergyDomain::total] += diff_joules;
+    if (pkg.domain != EnergyDomain::total)
+      joules[(size_t) pkg.domain] += diff_joules;
   }
+  _consumed_joules += joules[(size_t) EnergyDomain::total];
   _last_update_ts = time(NULL);
+
+  /* attribute energy and time since the last update to the phases of all registered threads */
+  auto now = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed = now - _last_phase_ts;
+  _last_phase_ts = now;
+
+  size_t total_threads = 0;
+  for (auto n: _phase_threads)
+    total_threads += n;
+
+  for (size_t p = 0; p < _phase_counters.size(); ++p)
+  {
+    double share;
+    if (total_threads > 0)
+      share = ((double) _phase_threads[p]) / total_threads;
+    else
+      share = (p == (size_t) EnergyPhase::other) ? 1. : 0.;
+
+    if (share > 0.)
+    {
+      auto& cnt = _phase_counters[p];
+      for (size_t d = 0; d < (size_t) EnergyDomain::count; ++d)
+        cnt.joules[d] += joules[d] * share;
+      cnt.seconds += elapsed.count() * share;
+    }
+  }
 }
 
 double EnergyMonitor::consumed_joules(bool do_update)
@@ -108,6 +158,73 @@ bool EnergyMonitor::active() const
   return _active;
 }
 
+void EnergyMonitor::set_thread_phase(int phase)
+{
+  if (phase == thread_phase)
+    return;
+
+  std::lock_guard<std::mutex> lock(_mtx);
+
+  /* close the interval of the old phase */
+  if (_active)
+    read_counters();
+
+  if (thread_phase >= 0)
+    _phase_threads[thread_phase]--;
+  if (phase >= 0)
+    _phase_threads[phase]++;
+  thread_phase = phase;
+}
+
+void EnergyMonitor::phase(EnergyPhase phase)
+{
+  set_thread_phase((int) phase);
+}
+
+void EnergyMonitor::search_phase(EnergyPhase phase)
+{
+  if (thread_phase != (int) EnergyPhase::bootstrap)
+    set_thread_phase((int) phase);
+}
+
+void EnergyMonitor::release_phase()
+{
+  set_thread_phase(-1);
+}
+
+EnergyCounterList EnergyMonitor::phase_counters(bool do_update)
+{
+  if (do_update)
+    update();
+
+  std::lock_guard<std::mutex> lock(_mtx);
+  return _phase_counters;
+}
+
+const char * EnergyMonitor::phase_name(EnergyPhase phase)
+{
+  switch (phase)
+  {
+    case EnergyPhase::other:
+      return "other";
+    case EnergyPhase::start_trees:
+      return "starting trees";
+    case EnergyPhase::modopt:
+      return "model optimization";
+    case EnergyPhase::fast_spr:
+      return "fast SPR";
+    case EnergyPhase::slow_spr:
+      return "slow SPR";
+    case EnergyPhase::bootstrap:
+      return "bootstrap";
+    case EnergyPhase::support:
+      return "branch support";
+    default:
+      assert(0);
+      return "";
+  }
+}
+
 bool EnergyMonitor::add_package(RAPLPackage& pkg)
 {
   auto pkg_path = pkg.sub_id < 0 ? pkg_energy_path(pkg.pkg_id) :
@@ -124,12 +241,17 @@ bool EnergyMonitor::add_package(RAPLPackage& pkg)
 
   /* It seems that DRAM subzone energy is NOT included in the parent package value,
    * whereas other subzones (cores, uncore) are. This design choice is extremely confusing,
-   * and not clearly documented. So for now, we just ignore all subzones except DRAM.
+   * and not clearly documented. So for now, we only add DRAM to the total, and track
+   * cores as a separate domain. Uncore and other subzones are ignored.
    * There is no guarantee this workaround will work as intended on all systems,
    * especially the future ones. */
-  if (pkg.sub_id >= 0 && pkg.name != "dram")
+  if (pkg.sub_id >= 0 && pkg.name != "dram" && pkg.name != "core")
     return true;
 
+  pkg.domain = pkg.name == "dram" ? EnergyDomain::dram :
+                 (pkg.name == "core" ? EnergyDomain::core : EnergyDomain::total);
+  pkg.in_total = pkg.name != "core";
+
   bool proceed = true;
   if (pkg.name == "psys")
   {
@@ -1,13 +1,53 @@
 #ifndef RAXML_ENERGYMONITOR_HPP_
 #define RAXML_ENERGYMONITOR_HPP_
 
+#include <chrono>
+#include <mutex>
 #include <string>
 #include <vector>
 
+enum class EnergyPhase
+{
+  other = 0,
+  start_trees,
+  modopt,         /* ML search: brlenOpt, modOpt1-4 */
+  fast_spr,       /* ML search: radiusDetect, fastSPR */
+  slow_spr,       /* ML search: slowSPR */
+  bootstrap,
+  support,
+  count
+};
+
+enum class EnergyDomain
+{
+  total = 0,      /* package + DRAM, or platform (psys) if available */
+  core,
+  dram,
+  count
+};
+
+struct EnergyCounter
+{
+  double joules[(size_t) EnergyDomain::count];
+  double seconds;
+};
+
+inline EnergyCounter& operator+=(EnergyCounter& a, const EnergyCounter& b)
+{
+  for (size_t d = 0; d < (size_t) EnergyDomain::count; ++d)
+    a.joules[d] += b.joules[d];
+  a.seconds += b.seconds;
+  return a;
+}
+
+typedef std::vector<EnergyCounter> EnergyCounterList;  /* indexed by EnergyPhase */
+
 struct RAPLPackage
 {
   int pkg_id;
   int sub_id;
+  EnergyDomain domain;
+  bool in_total;
   std::string name;
   std::string energy_fname;
   size_t last_energy_uj;
@@ -29,11 +69,30 @@ public:
   void disable();
   bool active() const;
 
+  /* set the phase of the calling thread: energy consumed between two updates is split
+   * among phases in proportion to the number of threads in each phase */
+  void phase(EnergyPhase phase);
+  /* same, but keeps the bootstrap phase (ML search steps during bootstrapping) */
+  void search_phase(EnergyPhase phase);
+  /* calling thread stops contributing to phase shares (e.g. on thread exit) */
+  void release_phase();
+
+  EnergyCounterList phase_counters(bool do_update = true);
+
+  static const char * phase_name(EnergyPhase phase);
+
 private:
   bool _active;
   std::vector<RAPLPackage> _pkg_list;
   double _consumed_joules;
   time_t _last_update_ts;
+  std::chrono::steady_clock::time_point _last_phase_ts;
+  EnergyCounterList _phase_counters;
+  std::vector<size_t> _phase_threads;
+  std::mutex _mtx;
+
+  void read_counters();
+  void set_thread_phase(int phase);
 
   bool add_package(RAPLPackage& pkg);
   void init_packages();
@@ -0,0 +1,175 @@
+#include <algorithm>
+
+#include "Profiler.hpp"
+
+#include "../common.h"
+
+using namespace std;
+
+static const char * const PROFILE_EVENT_NAMES[] =
+{
+  "loglh",
+  "brlen_opt",
+  "brlen_scaler_opt",
+  "subst_rates_opt",
+  "freqs_opt",
+  "alpha_opt",
+  "pinv_opt",
+  "alpha_pinv_opt",
+  "free_rates_opt",
+  "spr_round",
+  "reduction",
+  "barrier",
+  "checkpoint"
+};
+
+static const size_t PROFILE_EVENT_COUNT = (size_t) ProfileEvent::count;
+
+bool Profiler::_active = false;
+thread_local bool Profiler::_thread_disabled = false;
+std::mutex Profiler::_mtx;
+std::vector<std::string> Profiler::_phases = {"other"};
+std::map<size_t, Profiler::ThreadProfile> Profiler::_threads;
+thread_local ProfileScope * ProfileScope::_current = nullptr;
+
+Profiler::ThreadProfile& Profiler::thread_profile()
+{
+  /* NB: thread pools are re-created between commands -> look up by proc_id */
+  static thread_local ThreadProfile * tp = nullptr;
+  static thread_local size_t tp_proc_id = 0;
+
+  auto proc_id = ParallelContext::proc_id();
+  if (!tp || tp_proc_id != proc_id)
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto it = _threads.find(proc_id);
+    if (it == _threads.end())
+    {
+      ThreadProfile new_tp;
+      new_tp.rank_id = ParallelContext::rank_id();
+      new_tp.thread_id = ParallelContext::thread_id();
+      new_tp.phase = 0;
+      new_tp.counters.assign(_phases.size(), std::vector<ProfileCounter>(PROFILE_EVENT_COUNT, {0, 0.}));
+      it = _threads.emplace(proc_id, new_tp).first;
+    }
+    tp = &it->second;
+    tp_proc_id = proc_id;
+  }
+
+  return *tp;
+}
+
+void Profiler::phase(const std::string& name)
+{
+  if (!active())
+    return;
+
+  size_t phase_idx;
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto it = std::find(_phases.begin(), _phases.end(), name);
+    phase_idx = it - _phases.begin();
+    if (it == _phases.end())
+      _phases.push_back(name);
+  }
+
+  auto& tp = thread_profile();
+  if (tp.counters.size() <= phase_idx)
+    tp.counters.resize(phase_idx + 1, std::vector<ProfileCounter>(PROFILE_EVENT_COUNT, {0, 0.}));
+  tp.phase = phase_idx;
+}
+
+void Profiler::record(ProfileEvent event, double seconds)
+{
+  auto& tp = thread_profile();
+  auto& c = tp.counters[tp.phase][(size_t) event];
+  c.count++;
+  c.seconds += seconds;
+}
+
+/*
+ *  JSON: { "phases": [..], "events": [..],
+ *          "threads": [ { "rank": r, "thread": t,
+ *                         "profile": { phase: { event: { "count": n, "seconds": s }, .. }, .. } }, .. ] }
+ *  CSV:  rank,thread,phase,event,count,seconds
+ *
+ *  Only non-zero counters are printed.
+ */
+void Profiler::write(std::ostream& stream, ProfileFormat format)
+{
+  std::lock_guard<std::mutex> lock(_mtx);
+
+  stream << fixed << setprecision(6);
+
+  if (format == ProfileFormat::csv)
+  {
+    stream << "rank,thread,phase,event,count,seconds" << endl;
+    for (const auto& it: _threads)
+    {
+      const auto& tp = it.second;
+      for (size_t p = 0; p < tp.counters.size(); ++p)
+      {
+        for (size_t e = 0; e < PROFILE_EVENT_COUNT; ++e)
+        {
+          const auto& c = tp.counters[p][e];
+          if (c.count > 0)
+          {
+            stream << tp.rank_id << "," << tp.thread_id << "," << _phases[p] << "," <<
+                PROFILE_EVENT_NAMES[e] << "," << c.count << "," << c.seconds << endl;
+          }
+        }
+      }
+    }
+    return;
+  }
+
+  stream << "{" << endl;
+
+  stream << "  \"phases\": [";
+  for (size_t p = 0; p < _phases.size(); ++p)
+    stream << (p > 0 ? ", " : "") << "\"" << _phases[p] << "\"";
+  stream << "]," << endl;
+
+  stream << "  \"events\": [";
+  for (size_t e = 0; e < PROFILE_EVENT_COUNT; ++e)
+    stream << (e > 0 ? ", " : "") << "\"" << PROFILE_EVENT_NAMES[e] << "\"";
+  stream << "]," << endl;
+
+  stream << "  \"threads\": [";
+  bool first_thread = true;
+  for (const auto& it: _threads)
+  {
+    const auto& tp = it.second;
+    stream << (first_thread ? "" : ",") << endl;
+    stream << "    { \"rank\": " << tp.rank_id << ", \"thread\": " << tp.thread_id <<
+        ", \"profile\": {";
+    bool first_phase = true;
+    for (size_t p = 0; p < tp.counters.size(); ++p)
+    {
+      bool first_event = true;
+      for (size_t e = 0; e < PROFILE_EVENT_COUNT; ++e)
+      {
+        const auto& c = tp.counters[p][e];
+        if (c.count == 0)
+          continue;
+
+        if (first_event)
+        {
+          stream << (first_phase ? "" : ",") << endl;
+          stream << "        \"" << _phases[p] << "\": {";
+          first_phase = false;
+        }
+        stream << (first_event ? " " : ", ") << "\"" << PROFILE_EVENT_NAMES[e] <<
+            "\": { \"count\": " << c.count << ", \"seconds\": " << c.seconds << " }";
+        first_event = false;
+      }
+      if (!first_event)
+        stream << " }";
+    }
+    stream << (first_phase ? "" : "\n      ") << "} }";
+    first_thread = false;
+  }
+  stream << endl << "  ]" << endl;
+
+  stream << "}" << endl;
+}
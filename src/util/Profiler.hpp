@@ -0,0 +1,120 @@
+#ifndef RAXML_PROFILER_HPP_
+#define RAXML_PROFILER_HPP_
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class ProfileFormat;
+
+enum class ProfileEvent
+{
+  loglh = 0,
+  brlen_opt,
+  brlen_scaler_opt,
+  subst_rates_opt,
+  freqs_opt,
+  alpha_opt,
+  pinv_opt,
+  alpha_pinv_opt,
+  free_rates_opt,
+  spr_round,
+  reduction,      /* excl. barrier wait inside the reduction */
+  barrier,        /* wait time in thread_barrier() */
+  checkpoint,
+  count
+};
+
+struct ProfileCounter
+{
+  unsigned long count;
+  double seconds;
+};
+
+/*
+ * Per-thread timers and call counters, broken down by search phase (CheckpointStep).
+ * Recording is lock-free: every thread only updates its own counters, and the
+ * (mutex-protected) phase/thread registry is only touched on phase changes.
+ */
+class Profiler
+{
+public:
+  typedef std::chrono::steady_clock clock;
+
+  static void enable() { _active = true; }
+  static bool active() { return _active && !_thread_disabled; }
+
+  /* profiles are keyed by ParallelContext::proc_id(), which is only unique for thread pool
+   * threads -> any other thread (e.g. std::async) must call this before its first scope,
+   * its work is then not profiled at all */
+  static void disable_thread() { _thread_disabled = true; }
+
+  /* set the current search phase of the calling thread */
+  static void phase(const std::string& name);
+
+  static void record(ProfileEvent event, double seconds);
+
+  static void write(std::ostream& stream, ProfileFormat format);
+
+private:
+  struct ThreadProfile
+  {
+    size_t rank_id;
+    size_t thread_id;
+    size_t phase;
+    std::vector<std::vector<ProfileCounter> > counters;   /* [phase][event] */
+  };
+
+  static bool _active;
+  static thread_local bool _thread_disabled;
+  static std::mutex _mtx;
+  static std::vector<std::string> _phases;
+  static std::map<size_t, ThreadProfile> _threads;   /* key = proc_id */
+
+  static ThreadProfile& thread_profile();
+};
+
+/*
+ * Scopes may nest (e.g. barrier inside reduction inside loglh): every event is charged
+ * with its exclusive time only, i.e. the time spent in child scopes is subtracted.
+ */
+class ProfileScope
+{
+public:
+  ProfileScope(ProfileEvent event) : _event(event), _active(Profiler::active()),
+      _parent(nullptr), _child_seconds(0.)
+  {
+    if (_active)
+    {
+      _parent = _current;
+      _current = this;
+      _start = Profiler::clock::now();
+    }
+  }
+
+  ~ProfileScope()
+  {
+    if (_active)
+    {
+      std::chrono::duration<double> elapsed = Profiler::clock::now() - _start;
+      Profiler::record(_event, elapsed.count() - _child_seconds);
+      if (_parent)
+        _parent->_child_seconds += elapsed.count();
+      _current = _parent;
+    }
+  }
+
+private:
+  ProfileEvent _event;
+  bool _active;
+  ProfileScope * _parent;
+  double _child_seconds;
+  Profiler::clock::time_point _start;
+
+  static thread_local ProfileScope * _current;
+};
+
+#endif /* RAXML_PROFILER_HPP_ */
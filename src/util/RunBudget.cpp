@@ -0,0 +1,42 @@
+#include "RunBudget.hpp"
+#include "EnergyMonitor.hpp"
+
+#include "../common.h"
+
+using namespace std;
+
+RunBudget global_budget;
+
+void RunBudget::init(double max_seconds, double max_wh, size_t num_nodes)
+{
+  _max_seconds = max_seconds;
+  _max_wh = max_wh;
+  _num_nodes = std::max<size_t>(num_nodes, 1);
+}
+
+double RunBudget::used() const
+{
+  double frac = 0.;
+
+  if (_max_seconds > 0.)
+    frac = global_timer().elapsed_seconds() / _max_seconds;
+
+  if (_max_wh > 0.)
+    frac = std::max(frac, global_energy_monitor.consumed_wh() * _num_nodes / _max_wh);
+
+  return frac;
+}
+
+bool RunBudget::worker_exceeded(double limit, double next_cost) const
+{
+  if (!active())
+    return false;
+
+  double exceeded = 0.;
+  if (ParallelContext::group_master_thread())
+    exceeded = (used() + next_cost > limit) ? 1. : 0.;
+
+  ParallelContext::parallel_reduce_cb(nullptr, &exceeded, 1, PLLMOD_COMMON_REDUCE_MAX);
+
+  return exceeded > 0.;
+}
@@ -0,0 +1,35 @@
+#ifndef RAXML_RUNBUDGET_HPP_
+#define RAXML_RUNBUDGET_HPP_
+
+#include <cstddef>
+
+/*
+ * Wall-clock and/or energy budget of the current run (--budget).
+ * Energy counters are node-wide, so the value measured on the local node is
+ * extrapolated to all nodes.
+ */
+class RunBudget
+{
+public:
+  RunBudget() : _max_seconds(0.), _max_wh(0.), _num_nodes(1) {}
+
+  void init(double max_seconds, double max_wh, size_t num_nodes);
+
+  bool active() const { return _max_seconds > 0. || _max_wh > 0.; }
+
+  /* fraction of the budget consumed so far (max over time and energy) */
+  double used() const;
+
+  /* true if used() + next_cost exceeds limit on the group master thread of the calling worker;
+   * collective call: must be called by all threads (and ranks) of the worker */
+  bool worker_exceeded(double limit, double next_cost = 0.) const;
+
+private:
+  double _max_seconds;
+  double _max_wh;
+  size_t _num_nodes;
+};
+
+extern RunBudget global_budget;
+
+#endif /* RAXML_RUNBUDGET_HPP_ */
@@ -0,0 +1,397 @@
+/*
+ * raxml_bench: end-to-end performance benchmark on synthetic alignments.
+ *
+ * Alignments are simulated on random trees (JC-like model with Gamma rate heterogeneity,
+ * uniform gap insertion), written to RBA and then pushed through the main stages of a
+ * RAxML-NG analysis. All timings are wall-clock seconds (minimum over repetitions).
+ *
+ * Usage: raxml_bench [--quick] [--reps N] [--seed N] [--out FILE] [--tmpdir DIR]
+ *
+ * Output: one JSON object per dataset and line ("JSON lines"), suitable for diffing
+ * results between commits.
+ */
+
+#include <fstream>
+#include <functional>
+#include <random>
+
+#include "src/common.h"
+#include "src/version.h"
+#include "src/MSA.hpp"
+#include "src/PartitionedMSA.hpp"
+#include "src/ParsimonyMSA.hpp"
+#include "src/Tree.hpp"
+#include "src/TreeInfo.hpp"
+#include "src/Optimizer.hpp"
+#include "src/io/file_io.hpp"
+#include "src/bootstrap/BootstrapTree.hpp"
+#include "src/topology/RFDistCalculator.hpp"
+
+using namespace std;
+
+struct BenchDataset
+{
+  string name;
+  DataType data_type;
+  string model;
+  string alphabet;
+  size_t taxa;
+  size_t sites;
+  size_t parts;
+  double gap_rate;
+};
+
+struct BenchConfig
+{
+  bool quick;
+  unsigned int reps;
+  unsigned int seed;
+  string out_fname;
+  string tmp_dir;
+};
+
+static const vector<BenchDataset> BENCH_DATASETS =
+{
+  {"dna_p1",   DataType::dna,     "GTR+G", "ACGT",                  100, 10000,  1, 0.05},
+  {"dna_p20",  DataType::dna,     "GTR+G", "ACGT",                  100, 20000, 20, 0.20},
+  {"aa_p1",    DataType::protein, "LG+G",  "ARNDCQEGHILKMFPSTWYV",   50,  2000,  1, 0.10},
+  {"aa_p8",    DataType::protein, "LG+G",  "ARNDCQEGHILKMFPSTWYV",   50,  4000,  8, 0.30},
+  {"bin_p1",   DataType::binary,  "BIN+G", "01",                     100,  5000,  1, 0.00},
+  {"dna_gappy",DataType::dna,     "GTR+G", "ACGT",                  200,  5000,  4, 0.60}
+};
+
+/* random topology + exponential branch lengths (mean 0.1) */
+static Tree random_tree(const NameList& taxa, mt19937& rng)
+{
+  Tree tree = Tree::buildRandom(taxa, rng());
+
+  exponential_distribution<double> brlen_dist(10.);
+  auto topol = tree.topology();
+  for (auto& branch: topol.edges)
+    branch.length = max(brlen_dist(rng), RAXML_BRLEN_MIN);
+  tree.topology(topol);
+
+  return tree;
+}
+
+/* Jukes-Cantor-like simulation for k states with Gamma(0.5) site rates */
+static MSA simulate_msa(const Tree& tree, const BenchDataset& ds, mt19937& rng)
+{
+  const auto k = ds.alphabet.size();
+  const double alpha = 0.5;
+
+  gamma_distribution<double> rate_dist(alpha, 1. / alpha);
+  doubleVector site_rates(ds.sites);
+  for (auto& r: site_rates)
+    r = rate_dist(rng);
+
+  uniform_int_distribution<size_t> state_dist(0, k-1);
+  uniform_int_distribution<size_t> other_dist(0, k-2);
+  uniform_real_distribution<double> unif(0., 1.);
+
+  auto mutate = [&](const string& parent_seq, double brlen) -> string
+      {
+        string seq(parent_seq);
+        for (size_t i = 0; i < seq.size(); ++i)
+        {
+          double p_change = (k - 1.) / k * (1. - exp(-(double) k / (k - 1.) * brlen * site_rates[i]));
+          if (unif(rng) < p_change)
+          {
+            auto cur = ds.alphabet.find(seq[i]);
+            auto next = other_dist(rng);
+            seq[i] = ds.alphabet[next >= cur ? next + 1 : next];
+          }
+        }
+        return seq;
+      };
+
+  MSA msa;
+
+  /* node->back is the parent, node->length is the branch length leading to the parent */
+  function<void(const pll_unode_t*, const string&)> evolve =
+      [&](const pll_unode_t * node, const string& parent_seq)
+      {
+        auto seq = mutate(parent_seq, node->length);
+        if (!node->next)
+        {
+          for (auto& c: seq)
+          {
+            if (unif(rng) < ds.gap_rate)
+              c = '-';
+          }
+          msa.append(seq, node->label);
+        }
+        else
+        {
+          evolve(node->next->back, seq);
+          evolve(node->next->next->back, seq);
+        }
+      };
+
+  const pll_unode_t * root = &tree.pll_utree_root();
+  if (!root->next)
+    root = root->back;
+
+  string root_seq(ds.sites, ' ');
+  for (auto& c: root_seq)
+    c = ds.alphabet[state_dist(rng)];
+
+  evolve(root->back, root_seq);
+  evolve(root->next->back, root_seq);
+  evolve(root->next->next->back, root_seq);
+
+  return msa;
+}
+
+static shared_ptr<PartitionedMSA> make_parted_msa(const BenchDataset& ds, MSA&& msa)
+{
+  auto parted_msa = make_shared<PartitionedMSA>();
+
+  size_t part_len = ds.sites / ds.parts;
+  for (size_t p = 0; p < ds.parts; ++p)
+  {
+    auto start = p * part_len + 1;
+    auto end = (p == ds.parts - 1) ? ds.sites : start + part_len - 1;
+    parted_msa->emplace_part_info("p" + to_string(p+1), ds.data_type, ds.model,
+                                  to_string(start) + "-" + to_string(end));
+  }
+
+  parted_msa->full_msa(std::move(msa));
+  parted_msa->split_msa();
+
+  return parted_msa;
+}
+
+/* runs f() cfg.reps times and returns the minimum wall-clock time;
+ * setup() is called before every repetition and is not timed */
+static double time_min(const BenchConfig& cfg, const function<void()>& f,
+                       const function<void()>& setup = nullptr)
+{
+  double best = numeric_limits<double>::max();
+  for (unsigned int i = 0; i < cfg.reps; ++i)
+  {
+    if (setup)
+      setup();
+    auto start = sysutil_gettime();
+    f();
+    best = min(best, sysutil_gettime() - start);
+  }
+  return best;
+}
+
+static void run_dataset(const BenchConfig& cfg, const Options& opts, BenchDataset ds,
+                        ostream& out)
+{
+  if (cfg.quick)
+  {
+    ds.taxa = max<size_t>(ds.taxa / 4, 8);
+    ds.sites = max<size_t>(ds.sites / 10, 100 * ds.parts);
+  }
+
+  mt19937 rng(cfg.seed);
+
+  NameList taxa;
+  for (size_t i = 0; i < ds.taxa; ++i)
+    taxa.push_back("t" + to_string(i+1));
+
+  vector<pair<string, double> > timings;
+
+  /* simulate + write RBA (not timed: part of the setup) */
+  auto true_tree = random_tree(taxa, rng);
+  auto sim_msa = simulate_msa(true_tree, ds, rng);
+  auto rba_fname = cfg.tmp_dir + "/raxml_bench_" + ds.name + ".rba";
+  {
+    auto pmsa = make_parted_msa(ds, std::move(sim_msa));
+    pmsa->compress_patterns();
+    pmsa->set_model_empirical_params();
+    RBAStream bs(rba_fname);
+    bs << *pmsa;
+  }
+
+  /* pattern compression on a freshly simulated copy of the same data (setup is not timed) */
+  double compress_time = numeric_limits<double>::max();
+  for (unsigned int i = 0; i < cfg.reps; ++i)
+  {
+    mt19937 sim_rng(cfg.seed);
+    auto tree = random_tree(taxa, sim_rng);
+    auto pmsa = make_parted_msa(ds, simulate_msa(tree, ds, sim_rng));
+    auto start = sysutil_gettime();
+    pmsa->compress_patterns();
+    compress_time = min(compress_time, sysutil_gettime() - start);
+  }
+  timings.emplace_back("compress", compress_time);
+
+  /* load RBA */
+  shared_ptr<PartitionedMSA> parted_msa;
+  timings.emplace_back("load_rba", time_min(cfg, [&]()
+      {
+        parted_msa = make_shared<PartitionedMSA>();
+        RBAStream bs(rba_fname);
+        bs >> RBAStream::RBAOutput(*parted_msa, RBAStream::RBAElement::all, nullptr);
+      }));
+
+  /* starting trees */
+  const unsigned int num_trees = 10;
+  TreeList start_trees;
+  timings.emplace_back("start_trees_pars", time_min(cfg, [&]()
+      {
+        ParsimonyMSA pars_msa(parted_msa, opts.simd_arch | PLL_ATTRIB_PATTERN_TIP);
+        start_trees.clear();
+        for (unsigned int i = 0; i < num_trees; ++i)
+        {
+          auto tree = Tree::buildParsimony(pars_msa, cfg.seed + i);
+          tree.fix_missing_brlens();
+          tree.reset_tip_ids(parted_msa->taxon_id_map());
+          start_trees.push_back(std::move(tree));
+        }
+      }));
+
+  /* likelihood engine: single thread holds all partitions */
+  PartitionAssignment part_assign;
+  for (size_t p = 0; p < parted_msa->part_count(); ++p)
+  {
+    const auto& pinfo = parted_msa->part_info(p);
+    part_assign.assign_sites(p, 0, pinfo.length(), pinfo.model().clv_entry_size());
+  }
+
+  IDVector tip_msa_idmap;
+  unique_ptr<TreeInfo> treeinfo;
+  timings.emplace_back("treeinfo_init", time_min(cfg, [&]()
+      {
+        treeinfo.reset(new TreeInfo(opts, start_trees.at(0), *parted_msa, tip_msa_idmap,
+                                    part_assign));
+      }));
+
+  double loglh = 0.;
+  timings.emplace_back("loglh", time_min(cfg, [&]() { loglh = treeinfo->loglh(); }));
+
+  /* model optimization and SPR round start from the unoptimized starting tree every time */
+  auto fresh_treeinfo = [&]()
+      {
+        treeinfo.reset(new TreeInfo(opts, start_trees.at(0), *parted_msa, tip_msa_idmap,
+                                    part_assign));
+      };
+
+  Optimizer optimizer(opts);
+  timings.emplace_back("model_opt", time_min(cfg, [&]()
+      {
+        loglh = optimizer.optimize_model(*treeinfo, 10.);
+      }, fresh_treeinfo));
+
+  spr_round_params spr_params;
+  timings.emplace_back("spr_round", time_min(cfg, [&]()
+      {
+        loglh = treeinfo->spr_round(spr_params);
+      },
+      [&]()
+      {
+        fresh_treeinfo();
+        spr_params.thorough = 0;
+        spr_params.radius_min = 1;
+        spr_params.radius_max = 5;
+        spr_params.ntopol_keep = 20;
+        spr_params.subtree_cutoff = opts.spr_cutoff;
+        spr_params.lh_epsilon_brlen_full = opts.lh_epsilon;
+        spr_params.lh_epsilon_brlen_triplet = opts.lh_epsilon_brlen_triplet;
+        spr_params.reset_cutoff_info(treeinfo->loglh());
+      }));
+
+  /* support + RF on the parsimony trees (stand-ins for bootstrap replicates) */
+  timings.emplace_back("bs_support", time_min(cfg, [&]()
+      {
+        BootstrapTree sup_tree(start_trees.at(0));
+        for (const auto& tree: start_trees)
+          sup_tree.add_replicate_tree(tree);
+        sup_tree.draw_support(true);
+      }));
+
+  double avg_rrf = 0.;
+  timings.emplace_back("rfdist", time_min(cfg, [&]()
+      {
+        RFDistCalculator rfdist(start_trees);
+        avg_rrf = rfdist.avg_rrf();
+      }));
+
+  treeinfo.reset();
+  sysutil_file_remove(rba_fname);
+
+  out << fixed << setprecision(6);
+  out << "{\"dataset\": \"" << ds.name << "\", \"taxa\": " << ds.taxa << ", \"sites\": " << ds.sites <<
+      ", \"partitions\": " << ds.parts << ", \"patterns\": " << parted_msa->total_patterns() <<
+      ", \"gap_rate\": " << ds.gap_rate << ", \"model\": \"" << ds.model << "\"" <<
+      ", \"reps\": " << cfg.reps << ", \"loglh\": " << loglh << ", \"avg_rrf\": " << avg_rrf;
+  for (const auto& t: timings)
+    out << ", \"" << t.first << "\": " << t.second;
+  out << "}" << endl;
+}
+
+static void print_usage()
+{
+  cout << "Usage: raxml_bench [--quick] [--reps N] [--seed N] [--out FILE] [--tmpdir DIR]"
+       << endl;
+}
+
+int main(int argc, char** argv)
+{
+  BenchConfig cfg = {false, 3, 42, "", "/tmp"};
+
+  for (int i = 1; i < argc; ++i)
+  {
+    string arg = argv[i];
+    auto next = [&]() -> string
+        {
+          if (i + 1 >= argc)
+            throw runtime_error("Missing value for argument: " + arg);
+          return argv[++i];
+        };
+
+    if (arg == "--quick")
+      cfg.quick = true;
+    else if (arg == "--reps")
+      cfg.reps = max(stoi(next()), 1);
+    else if (arg == "--seed")
+      cfg.seed = stoul(next());
+    else if (arg == "--out")
+      cfg.out_fname = next();
+    else if (arg == "--tmpdir")
+      cfg.tmp_dir = next();
+    else
+    {
+      print_usage();
+      return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  logger().log_level(LogLevel::error);
+
+  Options opts;
+  opts.simd_arch = sysutil_simd_autodetect();
+
+  /* NB: the benchmark drives the engine from a single thread (no thread pool) */
+  ParallelContext::init_pthreads_custom(opts, nullptr, 1, 1);
+
+  ofstream fout;
+  if (!cfg.out_fname.empty())
+    fout.open(cfg.out_fname);
+  ostream& out = cfg.out_fname.empty() ? cout : fout;
+
+  out << "{\"raxml_version\": \"" << RAXML_VERSION << "\", \"cpu\": \"" << sysutil_get_cpu_model() <<
+      "\", \"simd\": " << opts.simd_arch << ", \"seed\": " << cfg.seed <<
+      ", \"quick\": " << (cfg.quick ? "true" : "false") << "}" << endl;
+
+  int retval = EXIT_SUCCESS;
+  try
+  {
+    for (const auto& ds: BENCH_DATASETS)
+      run_dataset(cfg, opts, ds, out);
+  }
+  catch (exception& e)
+  {
+    cerr << "ERROR: " << e.what() << endl;
+    retval = EXIT_FAILURE;
+  }
+
+  ParallelContext::finalize_threads();
+
+  return retval;
+}
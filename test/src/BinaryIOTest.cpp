@@ -0,0 +1,243 @@
+#include "RaxmlTest.hpp"
+
+#include <cstdio>
+
+#include "src/io/binary_io.hpp"
+#include "src/io/file_io.hpp"
+#include "src/bootstrap/BootstrapGenerator.hpp"
+
+using namespace std;
+
+/* unrooted 4-taxon tree ((t0,t1),(t2,t3)): tips 0..3, inner nodes 4 and 5 */
+TreeTopology simple_topology()
+{
+  TreeTopology topol;
+  topol.vroot_node_id = 4;
+  topol.edges.emplace_back(0, 4, 0.1);
+  topol.edges.emplace_back(1, 4, 0.2);
+  topol.edges.emplace_back(4, 5, 0.05);
+  topol.edges.emplace_back(2, 5, 0.3);
+  topol.edges.emplace_back(3, 5, 0.4);
+
+  return topol;
+}
+
+void compare_topologies(const TreeTopology& t1, const TreeTopology& t2, double brlen_eps)
+{
+  EXPECT_EQ(t1.vroot_node_id, t2.vroot_node_id);
+  ASSERT_EQ(t1.edges.size(), t2.edges.size());
+  for (size_t i = 0; i < t1.edges.size(); ++i)
+  {
+    EXPECT_EQ(t1.edges[i].left_node_id, t2.edges[i].left_node_id);
+    EXPECT_EQ(t1.edges[i].right_node_id, t2.edges[i].right_node_id);
+    EXPECT_NEAR(t1.edges[i].length, t2.edges[i].length, brlen_eps);
+  }
+  EXPECT_EQ(t1.brlens.size(), t2.brlens.size());
+}
+
+TEST(BinaryIOTest, varint)
+{
+  const vector<uint64_t> values = {0, 1, 127, 128, 300, 16383, 16384,
+                                   0xFFFFFFFFull, 0x100000000ull, UINT64_MAX};
+
+  char buf[256];
+  BinaryStream out(buf, sizeof(buf));
+  for (auto v: values)
+    put_varint(out, v);
+
+  /* 1 byte for values < 128, 10 bytes for UINT64_MAX */
+  BinaryStream small(buf, sizeof(buf));
+  put_varint(small, 127);
+  EXPECT_EQ(1u, small.pos());
+
+  BinaryStream in(buf, out.pos());
+  for (auto v: values)
+    EXPECT_EQ(v, get_varint(in));
+  EXPECT_EQ(out.pos(), in.pos());
+}
+
+TEST(BinaryIOTest, varint_invalid)
+{
+  /* continuation bit set on every byte -> more than 64 bits */
+  char buf[16];
+  memset(buf, 0xFF, sizeof(buf));
+  BinaryStream in(buf, sizeof(buf));
+  EXPECT_THROW(get_varint(in), runtime_error);
+
+  /* truncated varint */
+  BinaryStream trunc(buf, 2);
+  EXPECT_ANY_THROW(get_varint(trunc));
+}
+
+TEST(BinaryIOTest, compact_topology)
+{
+  auto topol = simple_topology();
+  topol.brlens.push_back({0.1, 0.2, 0.05, 0.3, 0.4});
+
+  char buf[1024];
+  for (auto fmt: {TreeBrlenFormat::full, TreeBrlenFormat::float32, TreeBrlenFormat::quant16})
+  {
+    BinaryStream out(buf, sizeof(buf));
+    out << CompactTopology(topol, fmt);
+
+    TreeTopology topol2;
+    BinaryStream in(buf, out.pos());
+    in >> CompactTopologyRef(topol2, fmt);
+
+    double eps = (fmt == TreeBrlenFormat::full) ? 0. : 1e-3;
+    compare_topologies(topol, topol2, eps);
+    ASSERT_EQ(1u, topol2.brlens.size());
+    EXPECT_NEAR(0.3, topol2.brlens[0][3], eps);
+    EXPECT_EQ(out.pos(), in.pos());
+  }
+
+  /* no branch lengths */
+  BinaryStream out(buf, sizeof(buf));
+  out << CompactTopology(topol, TreeBrlenFormat::none);
+  TreeTopology topol2;
+  BinaryStream in(buf, out.pos());
+  in >> CompactTopologyRef(topol2, TreeBrlenFormat::none);
+  EXPECT_EQ(RAXML_BRLEN_DEFAULT, topol2.edges[0].length);
+  EXPECT_TRUE(topol2.brlens.empty());
+}
+
+TEST(BinaryIOTest, rbt_roundtrip)
+{
+  const string fname = "raxml_test_roundtrip.rbt";
+  const NameList taxa = {"t0", "t1", "t2", "t3"};
+
+  TreeTopologyList trees;
+  trees.push_back(simple_topology());
+  trees.push_back(simple_topology());
+  std::swap(trees[1].edges[1].left_node_id, trees[1].edges[3].left_node_id);
+
+  {
+    RBTStream rbt(fname, TreeBrlenFormat::full);
+    rbt << RBTStream::RBTInput(taxa, trees);
+  }
+
+  EXPECT_TRUE(RBTStream::rbt_file(fname));
+
+  RBTStream rbt(fname);
+  EXPECT_EQ(2u, rbt.tree_count());
+  EXPECT_EQ(taxa, rbt.taxon_names());
+  compare_topologies(trees[1], rbt.tree(1), 0.);
+  EXPECT_THROW(rbt.tree(2), out_of_range);
+
+  NameList taxa2;
+  TreeTopologyList trees2;
+  rbt >> RBTStream::RBTOutput(taxa2, trees2);
+  EXPECT_EQ(taxa, taxa2);
+  ASSERT_EQ(2u, trees2.size());
+  compare_topologies(trees[0], trees2[0], 0.);
+  compare_topologies(trees[1], trees2[1], 0.);
+
+  std::remove(fname.c_str());
+}
+
+TEST(BinaryIOTest, rbt_invalid_node_id)
+{
+  const string fname = "raxml_test_invalid.rbt";
+  const NameList taxa = {"t0", "t1", "t2", "t3"};
+
+  /* 4 taxa -> valid node IDs are 0..5 */
+  TreeTopologyList trees(1, simple_topology());
+  trees[0].edges[2].right_node_id = 1000;
+
+  {
+    RBTStream rbt(fname, TreeBrlenFormat::none);
+    rbt << RBTStream::RBTInput(taxa, trees);
+  }
+
+  RBTStream rbt(fname);
+  NameList taxa2;
+  TreeTopologyList trees2;
+  EXPECT_THROW(rbt >> RBTStream::RBTOutput(taxa2, trees2), runtime_error);
+  EXPECT_THROW(rbt.tree(0), runtime_error);
+
+  /* wrong number of branches */
+  trees[0] = simple_topology();
+  trees[0].edges.pop_back();
+  {
+    RBTStream rbt_out(fname, TreeBrlenFormat::none);
+    rbt_out << RBTStream::RBTInput(taxa, trees);
+  }
+  EXPECT_THROW(rbt >> RBTStream::RBTOutput(taxa2, trees2), runtime_error);
+
+  /* invalid root */
+  trees[0] = simple_topology();
+  trees[0].vroot_node_id = 6;
+  {
+    RBTStream rbt_out(fname, TreeBrlenFormat::none);
+    rbt_out << RBTStream::RBTInput(taxa, trees);
+  }
+  EXPECT_THROW(rbt.tree(0), runtime_error);
+
+  std::remove(fname.c_str());
+}
+
+static PartitionedMSA bsrep_msa(MSA&& msa)
+{
+  PartitionedMSA pmsa;
+
+  pmsa.emplace_part_info("p1", DataType::dna, "GTR+FC+IC", "1-20");
+  pmsa.emplace_part_info("p2", DataType::dna, "GTR+FC+IC", "21-40");
+  pmsa.full_msa(std::move(msa));
+  pmsa.split_msa();
+  pmsa.compress_patterns();
+
+  return pmsa;
+}
+
+TEST(BinaryIOTest, rba_bootstrap_stats)
+{
+  const string rba_fname = "raxml_test_bsrep.rba";
+  const string phy_fname = "raxml_test_bsrep.phy";
+
+  MSA msa;
+  msa.append("ATGGCATATCCCATACAACTAGGATTCCAAGATGCAACAT", "t1");
+  msa.append("ATGGCCAACCACTCC--ACTAGGCTTTCAAGACGCCTCAT", "t2");
+  msa.append("ATGGCACATGCAGCGCAAGTAGGTCTACAAGNNNNTACTT", "t3");
+  msa.append("ATGGCACATCCCACACAATTAGGATTCCAAGACGCGGCCT", "t4");
+  msa.append("ATGGCCTACCCATTCCAACTTGG---ACAAGACGCCACAT", "t5");
+
+  auto pmsa = bsrep_msa(std::move(msa));
+
+  BootstrapGenerator bg;
+  auto bsrep = bg.generate(pmsa, 42);
+
+  {
+    RBAStream rs(rba_fname);
+    rs << BootstrapMSA(pmsa, bsrep);
+    PhylipStream ps(phy_fname);
+    ps << BootstrapMSA(pmsa, bsrep);
+  }
+
+  /* stats stored in the RBA replicate must match those of the same replicate loaded from PHYLIP */
+  PartitionedMSA rba_msa;
+  RBAStream rs(rba_fname);
+  rs >> rba_msa;
+
+  auto phy_msa = bsrep_msa(msa_load_from_file(phy_fname, FileFormat::phylip));
+
+  ASSERT_EQ(phy_msa.part_count(), rba_msa.part_count());
+  for (size_t p = 0; p < phy_msa.part_count(); ++p)
+  {
+    const auto& phy_stats = phy_msa.part_info(p).stats();
+    const auto& rba_stats = rba_msa.part_info(p).stats();
+
+    EXPECT_EQ(phy_stats.site_count, rba_stats.site_count);
+    EXPECT_EQ(phy_stats.pattern_count, rba_stats.pattern_count);
+    EXPECT_DOUBLE_EQ(phy_stats.inv_prop, rba_stats.inv_prop);
+    EXPECT_DOUBLE_EQ(phy_stats.gap_prop, rba_stats.gap_prop);
+    ASSERT_EQ(phy_stats.emp_base_freqs.size(), rba_stats.emp_base_freqs.size());
+    for (size_t i = 0; i < phy_stats.emp_base_freqs.size(); ++i)
+      EXPECT_NEAR(phy_stats.emp_base_freqs[i], rba_stats.emp_base_freqs[i], 1e-12);
+
+    /* replicates keep the number of sites of the original partition */
+    EXPECT_EQ(pmsa.part_info(p).stats().site_count, rba_stats.site_count);
+  }
+
+  std::remove(rba_fname.c_str());
+  std::remove(phy_fname.c_str());
+}
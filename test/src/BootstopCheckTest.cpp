@@ -0,0 +1,124 @@
+#include "RaxmlTest.hpp"
+
+#include "src/bootstrap/BootstopCheck.hpp"
+
+using namespace std;
+
+static const size_t BS_INTERVAL = 10;
+static const unsigned long BS_SEED = 42;
+static const size_t BS_PERMUTATIONS = 100;
+
+struct BootstopResult
+{
+  bool converged;
+  size_t num_bs_trees;
+};
+
+/* batches are tested right after they are complete */
+static BootstopResult bootstop_sync(const TreeList& bs_trees)
+{
+  BootstopCheckMRE checker(bs_trees.size(), RAXML_BOOTSTOP_CUTOFF, BS_PERMUTATIONS);
+  for (size_t batch_start = 0; batch_start < bs_trees.size(); batch_start += BS_INTERVAL)
+  {
+    auto batch_end = std::min(bs_trees.size(), batch_start + BS_INTERVAL);
+    for (size_t i = batch_start; i < batch_end; ++i)
+      checker.add_bootstrap_tree(bs_trees[i]);
+
+    if (checker.converged(BS_SEED))
+      return {true, batch_end};
+  }
+  return {false, bs_trees.size()};
+}
+
+/* same protocol as in thread_infer_bootstrap(): the test on a batch runs while the
+ * next batch is computed, which is dropped if the test has converged */
+static BootstopResult bootstop_async(const TreeList& bs_trees)
+{
+  BootstopCheckMRE checker(bs_trees.size(), RAXML_BOOTSTOP_CUTOFF, BS_PERMUTATIONS);
+  for (size_t batch_start = 0; batch_start < bs_trees.size(); batch_start += BS_INTERVAL)
+  {
+    auto batch_end = std::min(bs_trees.size(), batch_start + BS_INTERVAL);
+
+    if (checker.converged_pending())
+    {
+      EXPECT_EQ(batch_start, checker.num_bs_trees());
+      if (checker.converged_result())
+        return {true, batch_start};
+    }
+
+    for (size_t i = batch_start; i < batch_end; ++i)
+      checker.add_bootstrap_tree(bs_trees[i]);
+
+    if (batch_end < bs_trees.size())
+      checker.converged_async(BS_SEED);
+    else if (checker.converged(BS_SEED))
+      return {true, batch_end};
+  }
+  return {false, bs_trees.size()};
+}
+
+static NameList bootstop_taxa(size_t num_taxa)
+{
+  NameList taxa;
+  for (size_t i = 0; i < num_taxa; ++i)
+    taxa.push_back("t" + to_string(i));
+  return taxa;
+}
+
+static BootstopResult check_bootstop(const TreeList& bs_trees)
+{
+  auto sync = bootstop_sync(bs_trees);
+  auto async = bootstop_async(bs_trees);
+
+  EXPECT_EQ(sync.converged, async.converged);
+
+  /* replicates 1..num_bs_trees are kept in both modes */
+  EXPECT_EQ(sync.num_bs_trees, async.num_bs_trees);
+
+  return sync;
+}
+
+TEST(BootstopCheckTest, async_converged)
+{
+  auto taxa = bootstop_taxa(12);
+  auto ref_tree = Tree::buildRandom(taxa, 1);
+
+  /* identical replicates -> converged after the first batch, async mode drops the second one */
+  TreeList bs_trees(6 * BS_INTERVAL, ref_tree);
+
+  auto result = check_bootstop(bs_trees);
+  EXPECT_TRUE(result.converged);
+  EXPECT_EQ(BS_INTERVAL, result.num_bs_trees);
+}
+
+TEST(BootstopCheckTest, async_random)
+{
+  auto taxa = bootstop_taxa(20);
+
+  TreeList bs_trees;
+  for (size_t i = 0; i < 6 * BS_INTERVAL; ++i)
+    bs_trees.push_back(Tree::buildRandom(taxa, i + 1));
+
+  check_bootstop(bs_trees);
+}
+
+TEST(BootstopCheckTest, async_result)
+{
+  auto taxa = bootstop_taxa(12);
+
+  BootstopCheckMRE sync(BS_INTERVAL, RAXML_BOOTSTOP_CUTOFF, BS_PERMUTATIONS);
+  BootstopCheckMRE async(BS_INTERVAL, RAXML_BOOTSTOP_CUTOFF, BS_PERMUTATIONS);
+  for (size_t i = 0; i < BS_INTERVAL; ++i)
+  {
+    auto tree = Tree::buildRandom(taxa, i % 3 + 1);
+    sync.add_bootstrap_tree(tree);
+    async.add_bootstrap_tree(tree);
+  }
+
+  async.converged_async(BS_SEED);
+  EXPECT_TRUE(async.converged_pending());
+  EXPECT_EQ(sync.converged(BS_SEED), async.converged_result());
+  EXPECT_FALSE(async.converged_pending());
+  EXPECT_DOUBLE_EQ(sync.avg_wrf(), async.avg_wrf());
+  EXPECT_EQ(sync.num_better(), async.num_better());
+}
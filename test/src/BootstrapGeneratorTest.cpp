@@ -0,0 +1,39 @@
+#include "RaxmlTest.hpp"
+
+#include <numeric>
+
+#include "src/bootstrap/BootstrapGenerator.hpp"
+
+using namespace std;
+
+MSA simple_msa();
+
+TEST(BootstrapGeneratorTest, pattern_weights)
+{
+  PartitionedMSA pmsa;
+  pmsa.emplace_part_info("p1", DataType::dna, "GTR", "1-30");
+  pmsa.emplace_part_info("p2", DataType::dna, "GTR", "31-60");
+  pmsa.full_msa(simple_msa());
+  pmsa.split_msa();
+  pmsa.compress_patterns();
+
+  /* RBA partial loading: only the pattern weights are known for the whole alignment */
+  WeightVectorList part_weights;
+  for (const auto& pinfo: pmsa.part_list())
+    part_weights.push_back(pinfo.msa().weights());
+
+  BootstrapGenerator bg;
+  for (unsigned long seed = 1; seed <= 10; ++seed)
+  {
+    auto msa_rep = bg.generate(pmsa, seed);
+    auto weights_rep = bg.generate(part_weights, seed);
+
+    ASSERT_EQ(pmsa.part_count(), weights_rep.site_weights.size());
+    for (size_t p = 0; p < pmsa.part_count(); ++p)
+    {
+      const auto& w = weights_rep.site_weights[p];
+      EXPECT_EQ(msa_rep.site_weights[p], w);
+      EXPECT_EQ(pmsa.part_info(p).msa().num_sites(), std::accumulate(w.cbegin(), w.cend(), 0u));
+    }
+  }
+}
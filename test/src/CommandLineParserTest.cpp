@@ -179,6 +179,156 @@ TEST(CommandLineParserTest, all_complex)
   EXPECT_EQ(PLLMOD_COMMON_BRLEN_UNLINKED, options.brlen_linkage);
 }
 
+TEST(CommandLineParserTest, tree_format)
+{
+  // buildup
+  CommandLineParser parser;
+  Options options;
+
+  string cmd = "raxml-ng --msa data.fa --model GTR";
+  parse_options(cmd, parser, options, false);
+  EXPECT_EQ(TreeFormat::newick, options.tree_format);
+
+  // binary output keeps full branch length precision unless lossy encoding is requested
+  cmd = "raxml-ng --msa data.fa --model GTR --tree-format binary";
+  parse_options(cmd, parser, options, false);
+  EXPECT_EQ(TreeFormat::binary, options.tree_format);
+  EXPECT_EQ(TreeBrlenFormat::full, options.tree_brlen_format);
+
+  cmd = "raxml-ng --msa data.fa --model GTR --tree-format binary{q16}";
+  parse_options(cmd, parser, options, false);
+  EXPECT_EQ(TreeBrlenFormat::quant16, options.tree_brlen_format);
+
+  // wrong: unknown branch length format
+  cmd = "raxml-ng --msa data.fa --model GTR --tree-format binary{f16}";
+  parse_options(cmd, parser, options, true);
+}
+
+TEST(CommandLineParserTest, budget)
+{
+  // buildup
+  CommandLineParser parser;
+  Options options;
+
+  // no budget by default
+  string cmd = "raxml-ng --msa data.fa --model GTR";
+  parse_options(cmd, parser, options, false);
+  EXPECT_EQ(0., options.budget_seconds);
+  EXPECT_EQ(0., options.budget_wh);
+
+  // time units can be combined
+  cmd = "raxml-ng --msa data.fa --model GTR --budget 23h30m";
+  parse_options(cmd, parser, options, false);
+  EXPECT_DOUBLE_EQ(23. * 3600. + 30. * 60., options.budget_seconds);
+  EXPECT_EQ(0., options.budget_wh);
+
+  cmd = "raxml-ng --msa data.fa --model GTR --budget 1d12h30min15s";
+  parse_options(cmd, parser, options, false);
+  EXPECT_DOUBLE_EQ(86400. + 12. * 3600. + 30. * 60. + 15., options.budget_seconds);
+
+  // energy budget, units are case-insensitive
+  cmd = "raxml-ng --msa data.fa --model GTR --budget 1.5kwh";
+  parse_options(cmd, parser, options, false);
+  EXPECT_EQ(0., options.budget_seconds);
+  EXPECT_DOUBLE_EQ(1500., options.budget_wh);
+
+  // time and energy budget
+  cmd = "raxml-ng --msa data.fa --model GTR --budget 2d,100Wh";
+  parse_options(cmd, parser, options, false);
+  EXPECT_DOUBLE_EQ(2. * 86400., options.budget_seconds);
+  EXPECT_DOUBLE_EQ(100., options.budget_wh);
+}
+
+TEST(CommandLineParserTest, budget_wrong)
+{
+  // buildup
+  CommandLineParser parser;
+  Options options;
+
+  // wrong: time and energy in one item
+  string cmd = "raxml-ng --msa data.fa --model GTR --budget 1h5Wh";
+  parse_options(cmd, parser, options, true);
+
+  // wrong: unknown unit
+  cmd = "raxml-ng --msa data.fa --model GTR --budget 10y";
+  parse_options(cmd, parser, options, true);
+
+  // wrong: negative, zero or missing value
+  cmd = "raxml-ng --msa data.fa --model GTR --budget -1h";
+  parse_options(cmd, parser, options, true);
+
+  cmd = "raxml-ng --msa data.fa --model GTR --budget 0s";
+  parse_options(cmd, parser, options, true);
+
+  cmd = "raxml-ng --msa data.fa --model GTR --budget h";
+  parse_options(cmd, parser, options, true);
+}
+
+TEST(CommandLineParserTest, extra_toggles)
+{
+  // buildup
+  CommandLineParser parser;
+  Options options;
+
+  struct ExtraToggle
+  {
+    const char * on;
+    const char * off;
+    bool Options::* flag;
+    bool def_value;
+    bool compat_v11;    /* disabled by --extra compat-v11 */
+  };
+
+  const vector<ExtraToggle> toggles = {
+    {"modopt-split",     "modopt-sync",    &Options::use_split_modopt,     false, false},
+    {"alpha-pinv-joint", "alpha-pinv-seq", &Options::use_joint_alpha_pinv, false, true},
+    {"modopt-adaptive",  "modopt-fixed",   &Options::use_adaptive_modopt,  false, true},
+    {"tiplookup-on",     "tiplookup-off",  &Options::use_tip_lookup,       false, true},
+    {"msa-shm-on",       "msa-shm-off",    &Options::use_shared_msa,       false, false},
+    {"reduce-hier",      "reduce-flat",    &Options::use_hier_reduce,      true,  false},
+    {"pipeline-on",      "pipeline-off",   &Options::use_pipeline,         true,  false},
+    {"bootstop-async",   "bootstop-sync",  &Options::use_async_bootstop,   true,  false},
+  };
+
+  const string base_cmd = "raxml-ng --msa data.fa --model GTR";
+  for (const auto& t: toggles)
+  {
+    string cmd = base_cmd;
+    parse_options(cmd, parser, options, false);
+    EXPECT_EQ(t.def_value, options.*t.flag) << t.on;
+
+    cmd = base_cmd + " --extra " + t.on;
+    parse_options(cmd, parser, options, false);
+    EXPECT_TRUE(options.*t.flag) << t.on;
+
+    cmd = base_cmd + " --extra " + t.on + "," + t.off;
+    parse_options(cmd, parser, options, false);
+    EXPECT_FALSE(options.*t.flag) << t.off;
+
+    if (t.compat_v11)
+    {
+      cmd = base_cmd + " --extra " + t.on + ",compat-v11";
+      parse_options(cmd, parser, options, false);
+      EXPECT_FALSE(options.*t.flag) << t.on << ",compat-v11";
+    }
+  }
+}
+
+TEST(CommandLineParserTest, extra_wrong)
+{
+  // buildup
+  CommandLineParser parser;
+  Options options;
+
+  // wrong: unknown extra option
+  string cmd = "raxml-ng --msa data.fa --model GTR+G --extra no-such-option";
+  parse_options(cmd, parser, options, true);
+
+  // wrong: libpll has no single-precision CLVs
+  cmd = "raxml-ng --msa data.fa --model GTR+G --extra clv-float";
+  parse_options(cmd, parser, options, true);
+}
+
 TEST(CommandLineParserTest, eval_wrong)
 {
   // buildup
@@ -0,0 +1,89 @@
+#include "RaxmlTest.hpp"
+
+#include "src/util/CpuTopology.hpp"
+
+using namespace std;
+
+/* 2 NUMA nodes with 2 L3 domains of 2 cores each; CPUs 8-15 are SMT siblings of CPUs 0-7 */
+static CpuTopology two_node_topology()
+{
+  vector<CpuInfo> cpus;
+  for (unsigned int i = 0; i < 16; ++i)
+  {
+    size_t core = i % 8;
+    size_t node = core / 4;
+    size_t l3 = core / 2 * 2;
+    cpus.push_back({i, node, node, l3, core, i >= 8});
+  }
+  return CpuTopology(cpus);
+}
+
+TEST(CpuTopologyTest, counts)
+{
+  auto topo = two_node_topology();
+
+  EXPECT_EQ(2u, topo.num_sockets());
+  EXPECT_EQ(2u, topo.num_nodes());
+  EXPECT_EQ(4u, topo.num_l3());
+  EXPECT_EQ(8u, topo.num_cores());
+  EXPECT_FALSE(CpuTopology::process_cpus().empty());
+}
+
+TEST(CpuTopologyTest, place_groups_l3)
+{
+  auto topo = two_node_topology();
+
+  /* every group fits into one L3 domain, no SMT siblings */
+  auto placement = topo.place_groups({2, 2, 2, 2});
+  ASSERT_EQ(4u, placement.size());
+  EXPECT_EQ(vector<unsigned int>({0, 1}), placement[0]);
+  EXPECT_EQ(vector<unsigned int>({2, 3}), placement[1]);
+  EXPECT_EQ(vector<unsigned int>({4, 5}), placement[2]);
+  EXPECT_EQ(vector<unsigned int>({6, 7}), placement[3]);
+}
+
+TEST(CpuTopologyTest, place_groups_numa)
+{
+  auto topo = two_node_topology();
+
+  /* groups span two L3 domains, but stay on one NUMA node */
+  auto placement = topo.place_groups({4, 4});
+  ASSERT_EQ(2u, placement.size());
+  EXPECT_EQ(vector<unsigned int>({0, 1, 2, 3}), placement[0]);
+  EXPECT_EQ(vector<unsigned int>({4, 5, 6, 7}), placement[1]);
+}
+
+TEST(CpuTopologyTest, place_groups_smt)
+{
+  auto topo = two_node_topology();
+
+  /* more threads than cores -> SMT siblings of a core go to the same group */
+  auto placement = topo.place_groups({8, 8});
+  ASSERT_EQ(2u, placement.size());
+  EXPECT_EQ(vector<unsigned int>({0, 8, 1, 9, 2, 10, 3, 11}), placement[0]);
+  EXPECT_EQ(vector<unsigned int>({4, 12, 5, 13, 6, 14, 7, 15}), placement[1]);
+}
+
+TEST(CpuTopologyTest, place_groups_oversubscribe)
+{
+  auto topo = two_node_topology();
+
+  auto placement = topo.place_groups({20});
+  ASSERT_EQ(1u, placement.size());
+  ASSERT_EQ(20u, placement[0].size());
+
+  set<unsigned int> used(placement[0].cbegin(), placement[0].cend());
+  EXPECT_EQ(16u, used.size());
+  EXPECT_EQ(placement[0][0], placement[0][16]);
+}
+
+TEST(CpuTopologyTest, placement_report)
+{
+  auto topo = two_node_topology();
+
+  /* CPU 99 is not part of the topology (e.g. outside of the affinity mask) */
+  string report;
+  ASSERT_NO_THROW(report = topo.placement_report({{0, 1}, {4, 99}}));
+  EXPECT_NE(string::npos, report.find("group 1: CPUs 4,99"));
+  EXPECT_NE(string::npos, report.find("outside of affinity mask: 1"));
+}
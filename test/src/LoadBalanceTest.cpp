@@ -1,6 +1,7 @@
 #include "RaxmlTest.hpp"
 
 #include "src/loadbalance/LoadBalancer.hpp"
+#include "src/loadbalance/CoarseLoadBalancer.hpp"
 #include "src/io/file_io.hpp"
 
 using namespace std;
@@ -238,3 +239,88 @@ TEST(LoadBalanceTest, testSTUPID4)
   // tests
   check_assignment_all(part_sizes, 25);
 }
+
+static void check_pipelined(size_t num_ml, size_t num_bs, size_t num_workers, double ml_cost)
+{
+  CoarseAssignment ml_ids, bs_ids;
+  for (size_t i = 1; i <= num_ml; ++i)
+    ml_ids.push_back(i);
+  for (size_t i = 1; i <= num_bs; ++i)
+    bs_ids.push_back(i);
+
+  SimpleCoarseLoadBalancer clb;
+  CoarseAssignmentList ml_assign, bs_assign;
+  clb.get_pipelined_assignments(ml_ids, bs_ids, num_workers, ml_cost, ml_assign, bs_assign);
+
+  ASSERT_EQ(num_workers, ml_assign.size());
+  ASSERT_EQ(num_workers, bs_assign.size());
+
+  // every search is assigned exactly once, ML searches as in the non-pipelined mode
+  EXPECT_EQ(clb.get_all_assignments(ml_ids, num_workers), ml_assign);
+
+  CoarseAssignment all_bs;
+  std::vector<double> load(num_workers);
+  for (size_t w = 0; w < num_workers; ++w)
+  {
+    all_bs.insert(all_bs.end(), bs_assign[w].cbegin(), bs_assign[w].cend());
+    load[w] = ml_assign[w].size() * ml_cost + bs_assign[w].size();
+  }
+  std::sort(all_bs.begin(), all_bs.end());
+  EXPECT_EQ(bs_ids, all_bs);
+
+  // BS replicates fill up the workers with fewer ML searches first
+  const auto max_ml = std::max_element(ml_assign.cbegin(), ml_assign.cend(),
+      [](const CoarseAssignment& a, const CoarseAssignment& b) { return a.size() < b.size(); });
+  const double max_ml_load = max_ml->size() * ml_cost;
+  const auto minmax_load = std::minmax_element(load.cbegin(), load.cend());
+  if (num_bs * 1. + num_ml * ml_cost >= max_ml_load * num_workers)
+    EXPECT_LE(*minmax_load.second - *minmax_load.first, 1.);
+  else
+    EXPECT_LE(*minmax_load.second, max_ml_load + 1.);
+
+  for (size_t w = 0; w < num_workers; ++w)
+  {
+    for (size_t v = 0; v < num_workers; ++v)
+    {
+      if (ml_assign[w].size() < ml_assign[v].size())
+      {
+        EXPECT_GE(bs_assign[w].size(), bs_assign[v].size());
+      }
+    }
+  }
+}
+
+TEST(LoadBalanceTest, testPIPELINED)
+{
+  // ML searches on 2 out of 4 workers
+  check_pipelined(2, 10, 4, 2.);
+
+  // few BS replicates: only workers without ML search bootstrap
+  check_pipelined(2, 3, 4, 2.);
+
+  // ML searches on all workers
+  check_pipelined(10, 100, 4, 2.);
+
+  // only ML or only BS searches
+  check_pipelined(5, 0, 3, 2.);
+  check_pipelined(0, 7, 3, 2.);
+
+  // single worker
+  check_pipelined(3, 5, 1, 2.);
+}
+
+TEST(LoadBalanceTest, testPIPELINED_split)
+{
+  CoarseAssignment ml_ids = {1, 2};
+  CoarseAssignment bs_ids = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+  SimpleCoarseLoadBalancer clb;
+  CoarseAssignmentList ml_assign, bs_assign;
+  clb.get_pipelined_assignments(ml_ids, bs_ids, 4, 2., ml_assign, bs_assign);
+
+  // expected
+  CoarseAssignmentList ml_exp = {{1}, {2}, {}, {}};
+  CoarseAssignmentList bs_exp = {{5, 9}, {6, 10}, {1, 3, 7}, {2, 4, 8}};
+  EXPECT_EQ(ml_exp, ml_assign);
+  EXPECT_EQ(bs_exp, bs_assign);
+}
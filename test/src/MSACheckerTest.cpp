@@ -0,0 +1,95 @@
+#include "RaxmlTest.hpp"
+
+#include "src/MSAChecker.hpp"
+
+using namespace std;
+
+/* t2 = duplicate of t1, t3 has an invalid char, t4 is all-gap, column 11 is all-gap */
+static PartitionedMSA checker_msa()
+{
+  MSA msa;
+
+  msa.append("ACGTACGTAC-A", "t1");
+  msa.append("ACGTACGTAC-A", "t2");
+  msa.append("ACJTACGTAC-G", "t3");
+  msa.append("------------", "t4");
+  msa.append("TTGTACGAAN-C", "t5");
+
+  PartitionedMSA pmsa;
+  pmsa.emplace_part_info("p1", DataType::dna, "GTR", "1-6");
+  pmsa.emplace_part_info("p2", DataType::dna, "GTR", "7-12");
+  pmsa.full_msa(std::move(msa));
+  pmsa.split_msa();
+
+  return pmsa;
+}
+
+TEST(MSACheckerTest, all_checks)
+{
+  auto pmsa = checker_msa();
+
+  MSAChecker checker(pmsa, true, true, 1);
+  checker.thread_check();
+  checker.finalize();
+
+  ASSERT_EQ(1u, checker.dup_seqs().size());
+  EXPECT_EQ(0u, checker.dup_seqs()[0].first);
+  EXPECT_EQ(1u, checker.dup_seqs()[0].second);
+
+  ASSERT_EQ(1u, checker.invalid_chars().size());
+  const auto& ic = checker.invalid_chars()[0];
+  EXPECT_EQ(0u, ic.part_id);
+  EXPECT_EQ(2u, ic.seq_id);
+  EXPECT_EQ(2u, ic.site);
+  EXPECT_EQ('J', ic.c);
+
+  /* gap columns are reported per partition with partition-local indices */
+  ASSERT_EQ(2u, checker.gap_cols().size());
+  EXPECT_TRUE(checker.gap_cols()[0].empty());
+  ASSERT_EQ(1u, checker.gap_cols()[1].size());
+  EXPECT_EQ(4u, checker.gap_cols()[1][0]);
+
+  ASSERT_EQ(1u, checker.gap_seqs().size());
+  EXPECT_EQ(1u, checker.gap_seqs().count(3));
+}
+
+TEST(MSACheckerTest, checks_disabled)
+{
+  auto pmsa = checker_msa();
+
+  MSAChecker checker(pmsa, false, false, 1);
+  checker.thread_check();
+  checker.finalize();
+
+  EXPECT_TRUE(checker.dup_seqs().empty());
+  EXPECT_TRUE(checker.gap_seqs().empty());
+  for (const auto& gc: checker.gap_cols())
+    EXPECT_TRUE(gc.empty());
+
+  /* invalid characters are always reported */
+  EXPECT_EQ(1u, checker.invalid_chars().size());
+}
+
+TEST(MSACheckerTest, clean_msa)
+{
+  MSA msa;
+  msa.append("ACGTNACGT", "t1");
+  msa.append("ACGTTACGA", "t2");
+  msa.append("AC-TTACCA", "t3");
+  msa.append("TCGATAGGA", "t4");
+
+  PartitionedMSA pmsa;
+  pmsa.emplace_part_info("p1", DataType::dna, "GTR");
+  pmsa.full_msa(std::move(msa));
+  pmsa.split_msa();
+
+  MSAChecker checker(pmsa, true, true, 1);
+  checker.thread_check();
+  checker.finalize();
+
+  EXPECT_TRUE(checker.dup_seqs().empty());
+  EXPECT_TRUE(checker.invalid_chars().empty());
+  ASSERT_EQ(1u, checker.gap_cols().size());
+  EXPECT_TRUE(checker.gap_cols()[0].empty());
+  EXPECT_TRUE(checker.gap_seqs().empty());
+}
@@ -0,0 +1,47 @@
+#include "RaxmlTest.hpp"
+
+#include <cstring>
+
+#include "src/MSA.hpp"
+
+using namespace std;
+
+MSA simple_msa();
+
+TEST(MSATest, share_sequences)
+{
+  auto ref_msa = simple_msa();
+  auto msa = simple_msa();
+  const auto taxa = msa.size();
+  const auto len = msa.length();
+
+  std::vector<char> buf(taxa * len);
+  msa.share_sequences(buf.data(), true);
+
+  EXPECT_TRUE(msa.shared());
+  EXPECT_EQ(taxa, msa.size());
+  EXPECT_EQ(len, msa.length());
+
+  /* per-sequence strings are gone, sequence data is served from the shared buffer */
+  EXPECT_THROW(msa.at(0), runtime_error);
+  EXPECT_THROW(msa.at(msa.label(0)), runtime_error);
+  EXPECT_THROW(msa.append(ref_msa.at(0), "new"), runtime_error);
+  EXPECT_THROW(msa.share_sequences(buf.data(), true), runtime_error);
+  EXPECT_THROW(msa.sequence_data(taxa), out_of_range);
+
+  const pll_msa_t * pll_msa = msa.pll_msa();
+  ASSERT_EQ(taxa, (size_t) pll_msa->count);
+  for (size_t i = 0; i < taxa; ++i)
+  {
+    EXPECT_EQ(buf.data() + i * len, msa.sequence_data(i));
+    EXPECT_EQ(ref_msa.at(i), string(msa.sequence_data(i), len));
+    EXPECT_EQ(0, strncmp(ref_msa.at(i).c_str(), pll_msa->sequence[i], len));
+    EXPECT_EQ(ref_msa.label(i), msa.label(i));
+  }
+
+  /* non-copying ranks attach to a buffer that has already been filled */
+  auto msa2 = simple_msa();
+  msa2.share_sequences(buf.data(), false);
+  for (size_t i = 0; i < taxa; ++i)
+    EXPECT_EQ(ref_msa.at(i), string(msa2.sequence_data(i), len));
+}
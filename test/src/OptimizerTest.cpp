@@ -0,0 +1,64 @@
+#include "RaxmlTest.hpp"
+
+#include "src/Optimizer.hpp"
+
+using namespace std;
+
+static void set_param_gain(modopt_schedule& sched, int param, double gain)
+{
+  for (size_t i = 0; i < RAXML_MODOPT_PARAM_SLOTS; ++i)
+  {
+    if (param & (1 << i))
+      sched.param_gains[i] = gain;
+  }
+}
+
+TEST(OptimizerTest, schedule_modopt)
+{
+  const int model_params = PLLMOD_OPT_PARAM_SUBST_RATES | PLLMOD_OPT_PARAM_FREQUENCIES |
+                           PLLMOD_OPT_PARAM_ALPHA;
+
+  modopt_schedule sched;
+  sched.reset();
+
+  /* first step: gains unknown, no reference topology -> full optimization */
+  Optimizer::schedule_modopt(sched, 1., true);
+  EXPECT_EQ(PLLMOD_OPT_PARAM_ALL, sched.params);
+  EXPECT_EQ(1., sched.lh_epsilon);
+
+  /* stable topology: converged params are masked, epsilon is loosened */
+  set_param_gain(sched, model_params, 0.);
+  set_param_gain(sched, PLLMOD_OPT_PARAM_ALPHA, 2 * RAXML_MODOPT_MIN_GAIN);
+  sched.topol_dist = RAXML_MODOPT_STABLE_RFDIST / 2;
+  Optimizer::schedule_modopt(sched, 1., true);
+  EXPECT_EQ(0, sched.params & (PLLMOD_OPT_PARAM_SUBST_RATES | PLLMOD_OPT_PARAM_FREQUENCIES));
+  EXPECT_NE(0, sched.params & PLLMOD_OPT_PARAM_ALPHA);
+  EXPECT_NE(0, sched.params & PLLMOD_OPT_PARAM_BRANCHES_ITERATIVE);
+  EXPECT_EQ(RAXML_MODOPT_EPS_FACTOR, sched.lh_epsilon);
+  EXPECT_EQ(0u, sched.skipped);
+
+  /* topology changed -> full optimization again */
+  sched.topol_dist = 2 * RAXML_MODOPT_STABLE_RFDIST;
+  Optimizer::schedule_modopt(sched, 1., true);
+  EXPECT_EQ(PLLMOD_OPT_PARAM_ALL, sched.params);
+
+  /* all params converged -> branch lengths only, at most RAXML_MODOPT_MAX_SKIPPED times */
+  set_param_gain(sched, PLLMOD_OPT_PARAM_ALL, 0.);
+  sched.topol_dist = 0.;
+  for (unsigned int i = 1; i <= RAXML_MODOPT_MAX_SKIPPED; ++i)
+  {
+    Optimizer::schedule_modopt(sched, 1., true);
+    EXPECT_EQ(0, sched.params & model_params);
+    EXPECT_NE(0, sched.params & PLLMOD_OPT_PARAM_BRANCHES_ITERATIVE);
+    EXPECT_EQ(1., sched.lh_epsilon);
+    EXPECT_EQ(i, sched.skipped);
+  }
+
+  Optimizer::schedule_modopt(sched, 1., true);
+  EXPECT_EQ(PLLMOD_OPT_PARAM_ALL, sched.params);
+  EXPECT_EQ(0u, sched.skipped);
+
+  /* adaptive scheduling off -> always full optimization */
+  Optimizer::schedule_modopt(sched, 1., false);
+  EXPECT_EQ(PLLMOD_OPT_PARAM_ALL, sched.params);
+}
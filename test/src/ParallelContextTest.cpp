@@ -0,0 +1,102 @@
+#include "RaxmlTest.hpp"
+
+#include "src/CommandLineParser.hpp"
+
+using namespace std;
+
+void parse_options(string &cmd, CommandLineParser &parser, Options &opts, bool except_throw);
+
+#ifdef _RAXML_PTHREADS
+static const size_t NUM_THREADS = 4;
+static const size_t NUM_ROUNDS = 50;
+
+static Options parallel_options()
+{
+  CommandLineParser parser;
+  Options opts;
+
+  string cmd = "raxml-ng --msa data.fa --model GTR+G --threads " + to_string(NUM_THREADS);
+  parse_options(cmd, parser, opts, false);
+
+  opts.thread_pinning = false;
+
+  return opts;
+}
+
+/* thread t contributes (t+1) * (i+1) + round */
+static doubleVector thread_values(size_t thread_id, size_t round, size_t size)
+{
+  doubleVector v(size);
+  for (size_t i = 0; i < size; ++i)
+    v[i] = (thread_id + 1.) * (i + 1.) + round;
+  return v;
+}
+
+TEST(ParallelContextTest, parallel_reduce)
+{
+  auto opts = parallel_options();
+  const size_t size = 3;
+
+  std::vector<int> failed(NUM_THREADS, 0);
+  run_threads(opts, NUM_THREADS, [&]()
+      {
+        const auto tid = ParallelContext::local_proc_id();
+        for (size_t r = 0; r < NUM_ROUNDS; ++r)
+        {
+          auto sum = thread_values(tid, r, size);
+          auto max = thread_values(tid, r, size);
+          auto min = thread_values(tid, r, size);
+          ParallelContext::parallel_reduce(sum.data(), size, PLLMOD_COMMON_REDUCE_SUM);
+          ParallelContext::parallel_reduce(max.data(), size, PLLMOD_COMMON_REDUCE_MAX);
+          ParallelContext::parallel_reduce(min.data(), size, PLLMOD_COMMON_REDUCE_MIN);
+
+          const double n = NUM_THREADS;
+          for (size_t i = 0; i < size; ++i)
+          {
+            if (sum[i] != n * (n + 1.) / 2. * (i + 1.) + n * r ||
+                max[i] != n * (i + 1.) + r ||
+                min[i] != (i + 1.) + r)
+              failed[tid]++;
+          }
+        }
+      });
+
+  for (size_t t = 0; t < NUM_THREADS; ++t)
+    EXPECT_EQ(0, failed[t]) << "thread " << t;
+}
+
+TEST(ParallelContextTest, parallel_reduce_nonblocking)
+{
+  auto opts = parallel_options();
+  const size_t size = 5;
+
+  std::vector<int> failed(NUM_THREADS, 0);
+  run_threads(opts, NUM_THREADS, [&]()
+      {
+        const auto tid = ParallelContext::local_proc_id();
+        for (size_t r = 0; r < NUM_ROUNDS; ++r)
+        {
+          auto async_sum = thread_values(tid, r, size);
+          ParallelContext::parallel_reduce_start(async_sum.data(), size, PLLMOD_COMMON_REDUCE_SUM);
+
+          /* blocking reductions in between must not interfere with the pending one */
+          auto max = thread_values(tid, r, size - 2);
+          ParallelContext::parallel_reduce(max.data(), size - 2, PLLMOD_COMMON_REDUCE_MAX);
+
+          ParallelContext::parallel_reduce_wait(async_sum.data(), size);
+
+          const double n = NUM_THREADS;
+          for (size_t i = 0; i < size; ++i)
+          {
+            if (async_sum[i] != n * (n + 1.) / 2. * (i + 1.) + n * r)
+              failed[tid]++;
+            if (i < size - 2 && max[i] != n * (i + 1.) + r)
+              failed[tid]++;
+          }
+        }
+      });
+
+  for (size_t t = 0; t < NUM_THREADS; ++t)
+    EXPECT_EQ(0, failed[t]) << "thread " << t;
+}
+#endif
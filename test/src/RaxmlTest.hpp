@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 
 #include "src/Options.hpp"
+#include "src/ParallelContext.hpp"
 
 // The testing environment
 class RaxmlTest : public ::testing::Environment {
@@ -37,3 +38,13 @@ public:
 };
 
 extern RaxmlTest* env;
+
+/* run fn on num_threads threads (one thread group), then switch back to single-threaded mode */
+inline void run_threads(const Options& opts, size_t num_threads, const std::function<void()>& fn)
+{
+  ParallelContext::finalize_threads();
+  ParallelContext::init_pthreads_custom(opts, fn, num_threads, 1);
+  fn();
+  ParallelContext::finalize_threads();
+  ParallelContext::init_pthreads_custom(opts, [](){}, 1, 1);
+}
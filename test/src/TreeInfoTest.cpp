@@ -0,0 +1,228 @@
+#include "RaxmlTest.hpp"
+
+#include "src/CommandLineParser.hpp"
+#include "src/TreeInfo.hpp"
+
+using namespace std;
+
+MSA simple_msa();
+void parse_options(string &cmd, CommandLineParser &parser, Options &opts, bool except_throw);
+
+static Options treeinfo_options(const string& extra_args = "")
+{
+  CommandLineParser parser;
+  Options opts;
+
+  string cmd = "raxml-ng --msa data.fa --model GTR+G --threads 1" + extra_args;
+  parse_options(cmd, parser, opts, false);
+
+  opts.thread_pinning = false;
+
+  return opts;
+}
+
+/* 3 partitions of 20 sites each */
+static PartitionedMSA treeinfo_msa(const string& model)
+{
+  PartitionedMSA pmsa;
+
+  pmsa.emplace_part_info("p1", DataType::dna, model, "1-20");
+  pmsa.emplace_part_info("p2", DataType::dna, model, "21-40");
+  pmsa.emplace_part_info("p3", DataType::dna, model, "41-60");
+  pmsa.full_msa(simple_msa());
+
+  pmsa.split_msa();
+  pmsa.compress_patterns();
+
+  return pmsa;
+}
+
+/* simple_msa() twice -> 120 sites (no pattern compression), optionally recoded to binary */
+static PartitionedMSA long_msa(bool binary)
+{
+  auto dna = simple_msa();
+
+  MSA msa;
+  for (size_t i = 0; i < dna.size(); ++i)
+  {
+    string seq = dna.at(i);
+    if (binary)
+    {
+      for (auto& c: seq)
+        c = (c == 'A' || c == 'G') ? '0' : '1';
+    }
+    msa.append(seq + seq, dna.label(i));
+  }
+
+  PartitionedMSA pmsa;
+  if (binary)
+    pmsa.emplace_part_info("bin", DataType::binary, "BIN");
+  else
+    pmsa.emplace_part_info("dna", DataType::dna, "GTR");
+  pmsa.full_msa(std::move(msa));
+  pmsa.split_msa();
+
+  return pmsa;
+}
+
+/* all partitions on a single thread */
+static PartitionAssignment treeinfo_assignment(const PartitionedMSA& pmsa)
+{
+  PartitionAssignment part_assign;
+  for (size_t p = 0; p < pmsa.part_count(); ++p)
+    part_assign.assign_sites(p, 0, pmsa.part_info(p).msa().length());
+  return part_assign;
+}
+
+static const int MODEL_PARAMS = PLLMOD_OPT_PARAM_ALL & ~PLLMOD_OPT_PARAM_BRANCHES_ITERATIVE;
+
+#ifdef _RAXML_PTHREADS
+TEST(TreeInfoTest, split_modopt)
+{
+  auto opts = treeinfo_options();
+  auto pmsa = treeinfo_msa("GTR+G");
+  auto tree = Tree::buildRandom(pmsa.taxon_names(), 42);
+
+  /* p1 and p2 are held by a single thread each, p3 is split across both threads */
+  auto p3_len = pmsa.part_info(2).msa().length();
+  PartitionAssignmentList part_assign(2);
+  part_assign[0].assign_sites(0, 0, pmsa.part_info(0).msa().length());
+  part_assign[0].assign_sites(2, 0, p3_len / 2);
+  part_assign[1].assign_sites(1, 0, pmsa.part_info(1).msa().length());
+  part_assign[1].assign_sites(2, p3_len / 2, p3_len - p3_len / 2);
+
+  double lockstep_loglh = 0., split_loglh = 0.;
+  run_threads(opts, 2, [&]()
+      {
+        auto& pa = part_assign.at(ParallelContext::local_proc_id());
+
+        TreeInfo lockstep(opts, tree, pmsa, IDVector(), pa);
+        auto loglh1 = lockstep.optimize_params(MODEL_PARAMS, OPT_LH_EPSILON, false);
+
+        TreeInfo split(opts, tree, pmsa, IDVector(), pa);
+        auto loglh2 = split.optimize_params(MODEL_PARAMS, OPT_LH_EPSILON, true);
+
+        if (ParallelContext::master_thread())
+        {
+          lockstep_loglh = loglh1;
+          split_loglh = loglh2;
+        }
+      });
+
+  EXPECT_LT(lockstep_loglh, 0.);
+  EXPECT_NEAR(lockstep_loglh, split_loglh, OPT_LH_EPSILON);
+}
+#endif
+
+TEST(TreeInfoTest, joint_alpha_pinv)
+{
+  auto seq_opts = treeinfo_options();
+  auto joint_opts = treeinfo_options(" --extra alpha-pinv-joint");
+  auto pmsa = treeinfo_msa("GTR+I+G");
+  auto tree = Tree::buildRandom(pmsa.taxon_names(), 42);
+  auto part_assign = treeinfo_assignment(pmsa);
+
+  ASSERT_FALSE(seq_opts.use_joint_alpha_pinv);
+  ASSERT_TRUE(joint_opts.use_joint_alpha_pinv);
+
+  double seq_loglh = 0., joint_loglh = 0.;
+  unsigned int joint_evals = 0;
+  run_threads(seq_opts, 1, [&]()
+      {
+        TreeInfo seq(seq_opts, tree, pmsa, IDVector(), part_assign);
+        seq_loglh = seq.optimize_params(MODEL_PARAMS, OPT_LH_EPSILON);
+
+        TreeInfo joint(joint_opts, tree, pmsa, IDVector(), part_assign);
+        joint_loglh = joint.optimize_params(MODEL_PARAMS, OPT_LH_EPSILON);
+        joint_evals = joint.alpha_pinv().last_evals;
+      });
+
+  EXPECT_LT(seq_loglh, 0.);
+  EXPECT_GE(joint_loglh, seq_loglh - OPT_LH_EPSILON);
+
+  /* logLH evaluations, not all reductions: every L-BFGS-B step needs at least one */
+  EXPECT_GT(joint_evals, 0u);
+  EXPECT_LT(joint_evals, 10u * RAXML_ALPHA_PINV_EVAL_BUDGET);
+}
+
+TEST(TreeInfoTest, tip_lookup)
+{
+  auto lookup_opts = treeinfo_options(" --pat-comp off --extra tiplookup-on");
+  auto repeats_opts = treeinfo_options(" --pat-comp off --extra tiplookup-off");
+
+  /* generic kernels: SSE3 has no tip-inner kernels */
+  lookup_opts.simd_arch = repeats_opts.simd_arch = PLL_ATTRIB_ARCH_CPU;
+
+  auto bin_msa = long_msa(true);
+  auto dna_msa = long_msa(false);
+  auto tree = Tree::buildRandom(bin_msa.taxon_names(), 42);
+
+  unsigned int bin_lookup = 0, bin_repeats = 0, dna_lookup = 0;
+  run_threads(lookup_opts, 1, [&]()
+      {
+        TreeInfo bin1(lookup_opts, tree, bin_msa, IDVector(), treeinfo_assignment(bin_msa));
+        bin_lookup = bin1.pll_treeinfo().partitions[0]->attributes;
+
+        TreeInfo bin2(repeats_opts, tree, bin_msa, IDVector(), treeinfo_assignment(bin_msa));
+        bin_repeats = bin2.pll_treeinfo().partitions[0]->attributes;
+
+        TreeInfo dna(lookup_opts, tree, dna_msa, IDVector(), treeinfo_assignment(dna_msa));
+        dna_lookup = dna.pll_treeinfo().partitions[0]->attributes;
+      });
+
+  /* binary partition: lookup tables replace site repeats */
+  EXPECT_TRUE(bin_lookup & PLL_ATTRIB_PATTERN_TIP);
+  EXPECT_FALSE(bin_lookup & PLL_ATTRIB_SITE_REPEATS);
+
+  EXPECT_FALSE(bin_repeats & PLL_ATTRIB_PATTERN_TIP);
+  EXPECT_TRUE(bin_repeats & PLL_ATTRIB_SITE_REPEATS);
+
+  /* DNA has dedicated 4-state kernels -> site repeats */
+  EXPECT_FALSE(dna_lookup & PLL_ATTRIB_PATTERN_TIP);
+  EXPECT_TRUE(dna_lookup & PLL_ATTRIB_SITE_REPEATS);
+}
+
+TEST(TreeInfoTest, partial_msa_bootstrap)
+{
+  auto opts = treeinfo_options(" --pat-comp off");
+  auto full_msa = long_msa(false);
+  auto tree = Tree::buildRandom(full_msa.taxon_names(), 42);
+
+  /* RBA partial loading: only sites 40..79 are held locally */
+  const Range local_range(40, 40);
+  auto part_msa = long_msa(false);
+  MSA local_msa(RangeList{local_range});
+  const auto& msa = full_msa.part_msa(0);
+  for (size_t i = 0; i < msa.size(); ++i)
+    local_msa.append(msa.at(i).substr(local_range.start, local_range.length), msa.label(i));
+  local_msa.weights(WeightVector(local_range.length, 1));
+  part_msa.part_msa(0, std::move(local_msa));
+
+  PartitionAssignment part_assign;
+  part_assign.assign_sites(0, local_range.start, local_range.length);
+
+  /* global replicate weights, drawn from local and non-local sites alike */
+  std::vector<uintVector> bs_weights(1, uintVector(msa.length(), 0));
+  for (size_t i = 0; i < msa.length(); i += 3)
+    bs_weights[0][i] = 1 + i % 2;
+  std::vector<uintVector> zero_weights(1, uintVector(msa.length(), 0));
+  zero_weights[0][10] = 120;
+
+  double full_loglh = 0., part_loglh = 0., zero_loglh = -1.;
+  run_threads(opts, 1, [&]()
+      {
+        TreeInfo full(opts, tree, full_msa, IDVector(), part_assign, bs_weights);
+        full_loglh = full.loglh();
+
+        TreeInfo part(opts, tree, part_msa, IDVector(), part_assign, bs_weights);
+        part_loglh = part.loglh();
+
+        /* no local site was drawn -> all columns kept with zero weight */
+        TreeInfo zero(opts, tree, part_msa, IDVector(), part_assign, zero_weights);
+        zero_loglh = zero.loglh();
+      });
+
+  EXPECT_LT(full_loglh, 0.);
+  EXPECT_NEAR(full_loglh, part_loglh, 1e-6);
+  EXPECT_DOUBLE_EQ(0., zero_loglh);
+}